@@ -648,6 +648,7 @@ namespace mongo {
         uassert( 13386, "socket error for mapping query", c.get() );
 
         if ( !doExhaust ) {
+            c->prefetch();
             while( c->more() ) {
                 DBClientCursorBatchIterator i( *c );
                 f( i );
@@ -889,7 +890,14 @@ namespace mongo {
     }
 
     void DBClientConnection::recv( Message &m ) {
-        port().recv(m);
+        try {
+            if ( ! port().recv(m) )
+                failed = true;
+        }
+        catch( SocketException & ) {
+            failed = true;
+            throw;
+        }
     }
 
     bool DBClientConnection::call( Message &toSend, Message &response, bool assertOk , string * actualServer ) {
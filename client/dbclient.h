@@ -338,6 +338,10 @@ namespace mongo {
 
         /* used by QueryOption_Exhaust.  To use that your subclass must implement this. */
         virtual void recv( Message& m ) { assert(false); }
+
+        /** @return true if the response to a say() can be read later with recv(),
+            see DBClientCursor::initLazy */
+        virtual bool lazySupported() const { return false; }
     };
 
     /**
@@ -845,7 +849,8 @@ namespace mongo {
 
         /** Uses QueryOption_Exhaust
             Exhaust mode sends back all data queries as fast as possible, with no back-and-for for OP_GETMORE.  If you are certain
-            you will exhaust the query, it could be useful.
+            you will exhaust the query, it could be useful.  When the server doesn't support exhaust, reads ahead instead (see
+            DBClientCursor::prefetch()), so f must not use this connection.
 
             Use DBClientCursorBatchIterator version if you want to do items in large blocks, perhaps to avoid granular locking and such.
          */
@@ -878,6 +883,7 @@ namespace mongo {
         virtual bool call( Message &toSend, Message &response, bool assertOk = true , string * actualServer = 0 );
         virtual ConnectionString::ConnectionType type() const { return ConnectionString::MASTER; }
         virtual void checkResponse( const char *data, int nReturned );
+        virtual bool lazySupported() const { return true; }
         void setSoTimeout(double to) { _so_timeout = to; }
 
         static int getNumConnections() {
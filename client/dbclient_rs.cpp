@@ -410,7 +410,7 @@ namespace mongo {
     // --------------------------------
 
     DBClientReplicaSet::DBClientReplicaSet( const string& name , const vector<HostAndPort>& servers )
-        : _monitor( ReplicaSetMonitor::get( name , servers ) ) {
+        : _monitor( ReplicaSetMonitor::get( name , servers ) ) , _lazyConn( 0 ) {
     }
 
     DBClientReplicaSet::~DBClientReplicaSet() {
@@ -427,6 +427,8 @@ namespace mongo {
         }
 
         _masterHost = _monitor->getMaster();
+        if ( _lazyConn == _master.get() )
+            _lazyConn = 0;
         _master.reset( new DBClientConnection( true ) );
         string errmsg;
         if ( ! _master->connect( _masterHost , errmsg ) ) {
@@ -465,6 +467,13 @@ namespace mongo {
 
     }
 
+    void DBClientReplicaSet::recv( Message &m ) {
+        uassert( 13703 , str::stream() << "replica set master connection for " << _monitor->getName() << " changed before the reply was read" , _lazyConn );
+        DBConnector * c = _lazyConn; // DBClientConnection::recv is protected
+        _lazyConn = 0;
+        c->recv( m );
+    }
+
     DBClientConnection& DBClientReplicaSet::masterConn() {
         return *checkMaster();
     }
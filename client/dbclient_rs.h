@@ -230,7 +230,9 @@ namespace mongo {
         // ---- low level ------
 
         virtual bool call( Message &toSend, Message &response, bool assertOk=true , string * actualServer = 0 );
-        virtual void say( Message &toSend ) { checkMaster()->say( toSend ); }
+        virtual void say( Message &toSend ) { _lazyConn = checkMaster(); _lazyConn->say( toSend ); }
+        virtual void recv( Message &m );
+        virtual bool lazySupported() const { return true; }
         virtual bool callRead( Message& toSend , Message& response ) { return checkMaster()->callRead( toSend , response ); }
 
 
@@ -252,6 +254,10 @@ namespace mongo {
         HostAndPort _slaveHost;
         scoped_ptr<DBClientConnection> _slave;
 
+        // the connection the last say() went out on, which its reply has to be read from.
+        // cleared if checkMaster() replaces that connection
+        DBClientConnection * _lazyConn;
+
         /**
          * for storing authentication info
          * fields are exactly for DBClientConnection::auth
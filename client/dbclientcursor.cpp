@@ -26,6 +26,138 @@ namespace mongo {
 
     void assembleRequest( const string &ns, BSONObj query, int nToReturn, int nToSkip, const BSONObj *fieldsToReturn, int queryOptions, Message &toSend );
 
+    /** sends getMores for a cursor on its own thread and holds on to the replies until
+        DBClientCursor gets to them.  has the connection to itself while running.
+    */
+    class DBClientCursor::Prefetcher : boost::noncopyable {
+    public:
+        /** @param remaining how many more the cursor may return, if haveLimit */
+        Prefetcher( DBClientBase *client , const string& ns , int opts , long long cursorId ,
+                    bool haveLimit , int remaining , int batchSize , int maxBatches , int maxBytes ) :
+            _client( client ), _ns( ns ), _opts( opts ), _cursorId( cursorId ),
+            _haveLimit( haveLimit ), _remaining( remaining ), _batchSize( batchSize ),
+            _maxBatches( maxBatches ), _maxBytes( maxBytes ),
+            _m( "DBClientCursor::Prefetcher" ), _bytes( 0 ), _done( false ), _stop( false ), _errorCode( 0 ) {
+        }
+
+        ~Prefetcher() {
+            {
+                scoped_lock lk( _m );
+                _stop = true;
+                _cond.notify_all();
+            }
+            // a getMore in flight has to finish before the connection is usable again
+            if ( _thread )
+                _thread->join();
+            for ( deque<Message*>::iterator i = _batches.begin(); i != _batches.end(); ++i )
+                delete *i;
+        }
+
+        void start() {
+            _thread.reset( new boost::thread( boost::bind( &Prefetcher::run , this ) ) );
+        }
+
+        /** waits for the next reply.
+            @return null if there are no more
+        */
+        auto_ptr<Message> next() {
+            scoped_lock lk( _m );
+            while ( _batches.empty() && ! _done )
+                _cond.wait( lk.boost() );
+            if ( _batches.empty() ) {
+                if ( _errorCode || ! _error.empty() )
+                    throw UserException( _errorCode ? _errorCode : 13701 , "getMore prefetch failed: " + _error );
+                return auto_ptr<Message>();
+            }
+            auto_ptr<Message> m( _batches.front() );
+            _batches.pop_front();
+            _bytes -= m->size();
+            _cond.notify_all();
+            return m;
+        }
+
+    private:
+        void run() {
+            try {
+                while ( 1 ) {
+                    {
+                        scoped_lock lk( _m );
+                        while ( ! _stop && ( (int) _batches.size() >= _maxBatches || _bytes >= _maxBytes ) )
+                            _cond.wait( lk.boost() );
+                        if ( _stop )
+                            return;
+                    }
+
+                    int n = _batchSize;
+                    if ( _haveLimit && ( _batchSize == 0 || _remaining < _batchSize ) )
+                        n = _remaining;
+
+                    BufBuilder b;
+                    b.appendNum( _opts );
+                    b.appendStr( _ns );
+                    b.appendNum( n );
+                    b.appendNum( _cursorId );
+
+                    Message toSend;
+                    toSend.setData( dbGetMore , b.buf() , b.len() );
+                    auto_ptr<Message> response( new Message() );
+                    _client->call( toSend , *response );
+                    uassert( 13702 , "empty getMore reply" , ! response->empty() );
+
+                    QueryResult *qr = (QueryResult *) response->singleData();
+                    bool last = qr->cursorId == 0 || ( qr->resultFlags() & ResultFlag_CursorNotFound );
+                    if ( _haveLimit ) {
+                        _remaining -= qr->nReturned;
+                        if ( _remaining <= 0 )
+                            last = true;
+                    }
+
+                    scoped_lock lk( _m );
+                    _bytes += response->size();
+                    _batches.push_back( response.release() );
+                    if ( last )
+                        _done = true;
+                    _cond.notify_all();
+                    if ( last )
+                        return;
+                }
+            }
+            catch ( DBException& e ) {
+                scoped_lock lk( _m );
+                _errorCode = e.getCode();
+                _error = e.what();
+                _done = true;
+                _cond.notify_all();
+            }
+            catch ( std::exception& e ) {
+                scoped_lock lk( _m );
+                _error = e.what();
+                _done = true;
+                _cond.notify_all();
+            }
+        }
+
+        DBClientBase *_client;
+        const string _ns;
+        const int _opts;
+        const long long _cursorId;
+        const bool _haveLimit;
+        int _remaining;
+        const int _batchSize;
+        const int _maxBatches;
+        const int _maxBytes;
+
+        mongo::mutex _m;
+        boost::condition _cond;
+        deque<Message*> _batches;
+        int _bytes;
+        bool _done;
+        bool _stop;
+        int _errorCode;
+        string _error;
+        scoped_ptr<boost::thread> _thread;
+    };
+
     int DBClientCursor::nextBatchSize() {
 
         if ( nToReturn == 0 )
@@ -37,8 +169,7 @@ namespace mongo {
         return batchSize < nToReturn ? batchSize : nToReturn;
     }
 
-    bool DBClientCursor::init() {
-        Message toSend;
+    void DBClientCursor::_assembleInit( Message& toSend ) {
         if ( !cursorId ) {
             assembleRequest( ns, query, nextBatchSize() , nToSkip, fieldsToReturn, opts, toSend );
         }
@@ -50,6 +181,11 @@ namespace mongo {
             b.appendNum( cursorId );
             toSend.setData( dbGetMore, b.buf(), b.len() );
         }
+    }
+
+    bool DBClientCursor::init() {
+        Message toSend;
+        _assembleInit( toSend );
         if ( !_client->call( toSend, *m, false ) ) {
             // log msg temp?
             log() << "DBClientCursor::init call() failed" << endl;
@@ -64,6 +200,29 @@ namespace mongo {
         return true;
     }
 
+    void DBClientCursor::initLazy() {
+        assert( _client->lazySupported() );
+        Message toSend;
+        _assembleInit( toSend );
+        _client->say( toSend );
+    }
+
+    bool DBClientCursor::initLazyFinish() {
+        try {
+            _client->recv( *m );
+        }
+        catch ( SocketException& ) {
+            log() << "DBClientCursor::initLazyFinish recv() failed" << endl;
+            return false;
+        }
+        if ( m->empty() ) {
+            log() << "DBClientCursor::initLazyFinish message from recv() was empty" << endl;
+            return false;
+        }
+        dataReceived();
+        return true;
+    }
+
     void DBClientCursor::requestMore() {
         assert( cursorId && pos == nReturned );
 
@@ -71,6 +230,19 @@ namespace mongo {
             nToReturn -= nReturned;
             assert(nToReturn > 0);
         }
+
+        if ( _prefetcher ) {
+            auto_ptr<Message> response = _prefetcher->next();
+            if ( ! response.get() ) {
+                // nothing more was coming after all
+                nReturned = pos = 0;
+                return;
+            }
+            m = response;
+            dataReceived();
+            return;
+        }
+
         BufBuilder b;
         b.appendNum(opts);
         b.appendStr(ns);
@@ -170,10 +342,43 @@ namespace mongo {
         pos++;
         BSONObj o(data);
         data += o.objsize();
+
+        if ( _prefetchBatches && pos * 2 >= nReturned )
+            _startPrefetch();
+
         /* todo would be good to make data null at end of batch for safety */
         return o;
     }
 
+    void DBClientCursor::prefetch( int maxBatches , int maxBytes ) {
+        assert( maxBatches > 0 && maxBytes > 0 );
+        if ( _prefetcher )
+            return;
+        _prefetchBatches = maxBatches;
+        _prefetchBytes = maxBytes;
+    }
+
+    void DBClientCursor::_startPrefetch() {
+        int batches = _prefetchBatches;
+        _prefetchBatches = 0; // only once
+
+        if ( cursorId == 0 || ! _client || ! _client->lazySupported() )
+            return;
+        if ( opts & ( QueryOption_CursorTailable | QueryOption_Exhaust ) )
+            return;
+
+        int remaining = 0;
+        if ( haveLimit ) {
+            remaining = nToReturn - nReturned;
+            if ( remaining <= 0 )
+                return;
+        }
+
+        _prefetcher.reset( new Prefetcher( _client , ns , opts , cursorId , haveLimit , remaining ,
+                                           batchSize , batches , _prefetchBytes ) );
+        _prefetcher->start();
+    }
+
     void DBClientCursor::peek(vector<BSONObj>& v, int atMost) {
         int m = atMost;
 
@@ -221,6 +426,9 @@ namespace mongo {
 
         DESTRUCTOR_GUARD (
 
+        // done with the connection before we use it below
+        _prefetcher.reset();
+
         if ( cursorId && _ownCursor ) {
         BufBuilder b;
         b.appendNum( (int)0 ); // reserved
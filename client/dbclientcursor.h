@@ -121,6 +121,25 @@ namespace mongo {
             return (resultFlags & flag) != 0;
         }
 
+        /** sends the query without waiting for the response, so several servers can work on
+            their first batch at the same time.  nothing else may be sent on the connection
+            until initLazyFinish() is called.  requires _client->lazySupported()
+        */
+        void initLazy();
+
+        /** reads the response to initLazy()
+            @return false if the call failed
+        */
+        bool initLazyFinish();
+
+        /** read ahead: once half of the current batch has been read, the next getMore is sent from
+            a background thread, so the round trip overlaps with whatever the caller does with the
+            data.  at most maxBatches replies, and about maxBytes of them, are buffered at once.
+            nothing else may be sent on the connection until the cursor is exhausted or destroyed.
+            no effect on tailable and exhaust cursors, attach()ed cursors, or in process clients.
+        */
+        void prefetch( int maxBatches = 2 , int maxBytes = 16 * 1024 * 1024 );
+
         DBClientCursor( DBClientBase* client, const string &_ns, BSONObj _query, int _nToReturn,
                         int _nToSkip, const BSONObj *_fieldsToReturn, int queryOptions , int bs ) :
             _client(client),
@@ -137,7 +156,9 @@ namespace mongo {
             nReturned(),
             pos(),
             data(),
-            _ownCursor( true ) {
+            _ownCursor( true ),
+            _prefetchBatches( 0 ),
+            _prefetchBytes( 0 ) {
         }
 
         DBClientCursor( DBClientBase* client, const string &_ns, long long _cursorId, int _nToReturn, int options ) :
@@ -151,7 +172,9 @@ namespace mongo {
             nReturned(),
             pos(),
             data(),
-            _ownCursor( true ) {
+            _ownCursor( true ),
+            _prefetchBatches( 0 ),
+            _prefetchBytes( 0 ) {
         }
 
         virtual ~DBClientCursor();
@@ -169,6 +192,7 @@ namespace mongo {
         friend class DBClientBase;
         friend class DBClientConnection;
         bool init();
+        void _assembleInit( Message& toSend );
         int nextBatchSize();
         DBClientBase* _client;
         string ns;
@@ -192,6 +216,12 @@ namespace mongo {
         bool _ownCursor; // see decouple()
         string _scopedHost;
 
+        class Prefetcher;
+        shared_ptr<Prefetcher> _prefetcher; // reading ahead, see prefetch()
+        int _prefetchBatches;
+        int _prefetchBytes;
+        void _startPrefetch();
+
         // Don't call from a virtual function
         void _assertIfNull() const { uassert(13348, "connection died", this); }
 
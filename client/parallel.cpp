@@ -19,10 +19,12 @@
 #include "pch.h"
 #include "parallel.h"
 #include "connpool.h"
+#include "dbclient_rs.h"
 #include "../db/queryutil.h"
 #include "../db/dbmessage.h"
 #include "../s/util.h"
 #include "../s/shard.h"
+#include "../util/concurrency/thread_pool.h"
 
 namespace mongo {
 
@@ -88,31 +90,8 @@ namespace mongo {
             
             auto_ptr<DBClientCursor> cursor =
                 conn->query( _ns , q , num , 0 , ( _fields.isEmpty() ? 0 : &_fields ) , _options , _batchSize == 0 ? 0 : _batchSize + skipLeft );
-            
-            if ( ! cursor.get() && _options & QueryOption_PartialResults ) {
-                _done = true;
-                conn.done();
-                return cursor;
-            }
-            
-            massert( 13633 , str::stream() << "error querying server: " << server  , cursor.get() );
-            
-            if ( cursor->hasResultFlag( ResultFlag_ShardConfigStale ) ) {
-                conn.done();
-                throw StaleConfigException( _ns , "ClusteredCursor::query" );
-            }
-            
-            if ( cursor->hasResultFlag( ResultFlag_ErrSet ) ) {
-                conn.done();
-                BSONObj o = cursor->next();
-                throw UserException( o["code"].numberInt() , o["$err"].String() );
-            }
-            
-            
-            cursor->attach( &conn );
-            
-            conn.done();
-            return cursor;
+
+            return _checkCursor( server , conn , cursor );
         }
         catch ( SocketException& e ) {
             if ( ! ( _options & QueryOption_PartialResults ) )
@@ -122,6 +101,108 @@ namespace mongo {
         }
     }
 
+    auto_ptr<DBClientCursor> ClusteredCursor::_checkCursor( const string& server , ShardConnection& conn , auto_ptr<DBClientCursor> cursor ) {
+        if ( ! cursor.get() && _options & QueryOption_PartialResults ) {
+            _done = true;
+            conn.done();
+            return cursor;
+        }
+
+        massert( 13633 , str::stream() << "error querying server: " << server  , cursor.get() );
+
+        if ( cursor->hasResultFlag( ResultFlag_ShardConfigStale ) ) {
+            conn.done();
+            throw StaleConfigException( _ns , "ClusteredCursor::query" );
+        }
+
+        if ( cursor->hasResultFlag( ResultFlag_ErrSet ) ) {
+            conn.done();
+            BSONObj o = cursor->next();
+            throw UserException( o["code"].numberInt() , o["$err"].String() );
+        }
+
+        cursor->attach( &conn );
+
+        conn.done();
+        return cursor;
+    }
+
+    void ClusteredCursor::queryAll( const vector<ServerAndQuery>& servers , int skipLeft , FilteringClientCursor * out ) {
+        uassert( 13650 ,  "cursor already done" , ! _done );
+        assert( _didInit );
+
+        const unsigned n = servers.size();
+        vector< shared_ptr<ShardConnection> > conns( n );
+        vector< DBClientCursor* > pending( n , (DBClientCursor*)0 );
+
+        try {
+            // slaveOk reads go through call() so a replica set can pick a secondary
+            for ( unsigned i=0; i<n && ! ( _options & QueryOption_SlaveOk ); i++ ) {
+                const ServerAndQuery& sq = servers[i];
+
+                BSONObj q = _query;
+                if ( ! sq._extra.isEmpty() )
+                    q = concatQuery( q , sq._extra );
+
+                try {
+                    shared_ptr<ShardConnection> conn( new ShardConnection( sq._server , _ns ) );
+
+                    if ( conn->setVersion() ) {
+                        conn->done();
+                        throw StaleConfigException( _ns , "ClusteredCursor::queryAll ShardConnection had to change" , true );
+                    }
+
+                    if ( ! conn->get()->lazySupported() ) {
+                        conn->done();
+                        continue;
+                    }
+
+                    log(5) << "ClusteredCursor::queryAll (" << type() << ") server:" << sq._server
+                           << " ns:" << _ns << " query:" << q << endl;
+
+                    pending[i] = new DBClientCursor( conn->get() , _ns , q , 0 , 0 , ( _fields.isEmpty() ? 0 : &_fields ) ,
+                                                     _options , _batchSize == 0 ? 0 : _batchSize + skipLeft );
+                    conns[i] = conn;
+                    pending[i]->initLazy();
+                }
+                catch ( SocketException& e ) {
+                    if ( ! ( _options & QueryOption_PartialResults ) )
+                        throw e;
+                    delete pending[i];
+                    pending[i] = 0;
+                    conns[i].reset();
+                    _done = true;
+                }
+            }
+
+            for ( unsigned i=0; i<n; i++ ) {
+                if ( ! conns[i] ) {
+                    if ( ! _done )
+                        out[i].reset( query( servers[i]._server , 0 , servers[i]._extra , skipLeft ) );
+                    continue;
+                }
+
+                auto_ptr<DBClientCursor> cursor( pending[i] );
+                pending[i] = 0;
+
+                if ( ! cursor->initLazyFinish() ) {
+                    conns[i]->kill();
+                    if ( ! ( _options & QueryOption_PartialResults ) )
+                        msgasserted( 13651 , str::stream() << "error querying server: " << servers[i]._server );
+                    _done = true;
+                    continue;
+                }
+
+                out[i].reset( _checkCursor( servers[i]._server , *conns[i] , cursor ) );
+            }
+        }
+        catch ( ... ) {
+            for ( unsigned i=0; i<n; i++ )
+                delete pending[i];
+            throw;
+        }
+    }
+
     BSONObj ClusteredCursor::explain( const string& server , BSONObj extra ) {
         BSONObj q = _query;
         if ( ! extra.isEmpty() ) {
@@ -252,9 +333,10 @@ namespace mongo {
         assert( ! _next.isEmpty() );
         assert( ! _done );
 
+        // we advance lazily so that handing out the last object of a batch
+        // doesn't block on the getMore for the next one
         BSONObj ret = _next;
         _next = BSONObj();
-        _advance();
         return ret;
     }
 
@@ -264,6 +346,16 @@ namespace mongo {
         return _next;
     }
 
+    bool FilteringClientCursor::moreInCurrentBatch() {
+        if ( ! _next.isEmpty() )
+            return true;
+
+        if ( _done || ! _cursor.get() )
+            return false;
+
+        return _cursor->moreInCurrentBatch();
+    }
+
     void FilteringClientCursor::_advance() {
         assert( _next.isEmpty() );
         if ( ! _cursor.get() || _done )
@@ -477,6 +569,84 @@ namespace mongo {
 
     }
 
+    // --------  ParallelUnorderedClusteredCursor -----------
+
+    ParallelUnorderedClusteredCursor::ParallelUnorderedClusteredCursor( const set<ServerAndQuery>& servers , QueryMessage& q )
+        : ClusteredCursor( q ) , _servers( servers.begin() , servers.end() ) , _cursors( 0 ) , _current( 0 ) {
+        _needToSkip = q.ntoskip;
+    }
+
+    ParallelUnorderedClusteredCursor::~ParallelUnorderedClusteredCursor() {
+        delete [] _cursors;
+        _cursors = 0;
+    }
+
+    void ParallelUnorderedClusteredCursor::_init() {
+        assert( ! _cursors );
+        _cursors = new FilteringClientCursor[_servers.size()];
+        queryAll( _servers , _needToSkip , _cursors );
+    }
+
+    bool ParallelUnorderedClusteredCursor::more() {
+
+        if ( _needToSkip > 0 ) {
+            int n = _needToSkip;
+            _needToSkip = 0;
+
+            while ( n > 0 && more() ) {
+                next();
+                n--;
+            }
+
+            _needToSkip = n;
+        }
+
+        for ( unsigned i=0; i<_servers.size(); i++ ) {
+            if ( _cursors[i].moreInCurrentBatch() )
+                return true;
+        }
+
+        for ( unsigned i=0; i<_servers.size(); i++ ) {
+            if ( _cursors[i].more() )
+                return true;
+        }
+        return false;
+    }
+
+    BSONObj ParallelUnorderedClusteredCursor::next() {
+        const unsigned n = _servers.size();
+
+        // stay on the server we are reading from while it has data buffered,
+        // then move to any other server that has a batch waiting
+        for ( unsigned k=0; k<n; k++ ) {
+            unsigned i = ( _current + k ) % n;
+            if ( _cursors[i].moreInCurrentBatch() && _cursors[i].more() ) {
+                _current = i;
+                return _cursors[i].next();
+            }
+        }
+
+        // nothing buffered anywhere, block on the next server with more
+        for ( unsigned k=0; k<n; k++ ) {
+            unsigned i = ( _current + k ) % n;
+            if ( _cursors[i].more() ) {
+                _current = i;
+                return _cursors[i].next();
+            }
+        }
+
+        uasserted( 13652 , "no more elements" );
+        return BSONObj();
+    }
+
+    void ParallelUnorderedClusteredCursor::_explain( map< string,list<BSONObj> >& out ) {
+        for ( unsigned i=0; i<_servers.size(); i++ ) {
+            const ServerAndQuery& sq = _servers[i];
+            list<BSONObj> & l = out[sq._server];
+            l.push_back( explain( sq._server , sq._extra ) );
+        }
+    }
+
     // -----------------
     // ---- Future -----
     // -----------------
@@ -527,4 +697,225 @@ namespace mongo {
         return res;
     }
 
+    // -----------------
+    // - ParallelCommand
+    // -----------------
+
+    struct ParallelCommand::Call {
+        Call( const string& shard , ShardConnection * conn , const BSONObj& cmd )
+            : shard( shard ) , conn( conn ) , client( conn->get() ) , cmd( cmd.getOwned() ) ,
+              ok( false ) , broken( false ) , finished( false ) , abandoned( false ) {
+        }
+        string shard;
+        ShardConnection * conn;
+        DBClientBase * client;
+        BSONObj cmd;
+
+        // the rest is guarded by Shared::m
+        bool ok;
+        bool broken; // the command threw, don't hand the connection back to the pool
+        BSONObj res;
+        bool finished;
+        bool abandoned; // caller gave up; the command thread cleans up the connection
+    };
+
+    struct ParallelCommand::Shared {
+        Shared( const string& db , double timeoutSecs ) : db( db ) , timeoutSecs( timeoutSecs ) , m( "ParallelCommand" ) {}
+        const string db;
+        const double timeoutSecs; // socket timeout for the commands, 0 for none
+        mongo::mutex m;
+        boost::condition replied;
+        list< shared_ptr<Call> > done; // replies not handed out yet, in the order they came in
+    };
+
+    /** shared by all ParallelCommands, so a hung shard can't make mongos start threads without bound */
+    static ThreadPool& parallelCommandPool() {
+        static ThreadPool *p = new ThreadPool( 64 ); // never freed, commands may still be running at exit
+        return *p;
+    }
+
+    /** the connection runCommand will use, to set a socket timeout on.  0 if we don't know it */
+    static MessagingPort * commandPort( DBClientBase * c ) {
+        switch ( c->type() ) {
+        case ConnectionString::MASTER:
+            return &((DBClientConnection*)c)->port();
+        case ConnectionString::SET:
+            return &((DBClientReplicaSet*)c)->masterConn().port();
+        default:
+            return 0;
+        }
+    }
+
+    static void releaseCall( ShardConnection * conn , DBClientBase * client , bool broken ) {
+        if ( broken || client->isFailed() )
+            conn->kill();
+        else
+            conn->done();
+        delete conn;
+    }
+
+    ParallelCommand::ParallelCommand( const string& db , int timeoutMillis )
+        : _db( db ) , _timeoutMillis( timeoutMillis ) , _s( new Shared( db , timeoutMillis / 1000.0 ) ) , _nOk( 0 ) {
+        boost::xtime_get( &_deadline , boost::TIME_UTC );
+        unsigned long long nsec = _deadline.nsec + timeoutMillis * 1000000ULL;
+        _deadline.sec += (boost::xtime::xtime_sec_t) ( nsec / 1000000000 );
+        _deadline.nsec = (boost::xtime::xtime_nsec_t) ( nsec % 1000000000 );
+    }
+
+    ParallelCommand::~ParallelCommand() {
+        list< shared_ptr<Call> > done;
+        {
+            scoped_lock lk( _s->m );
+            done.swap( _s->done );
+            for ( list< shared_ptr<Call> >::iterator i = _pending.begin(); i != _pending.end(); ++i ) {
+                if ( ! (*i)->finished )
+                    (*i)->abandoned = true;
+            }
+        }
+        for ( list< shared_ptr<Call> >::iterator i = done.begin(); i != done.end(); ++i )
+            releaseCall( (*i)->conn , (*i)->client , (*i)->broken );
+    }
+
+    bool ParallelCommand::spawn( const Shard& shard , const string& ns , const BSONObj& cmd ) {
+        ShardConnection * conn = new ShardConnection( shard , ns );
+        bool setVersion;
+        try {
+            setVersion = conn->setVersion();
+        }
+        catch ( ... ) {
+            delete conn;
+            throw;
+        }
+
+        shared_ptr<Call> c( new Call( shard.getName() , conn , cmd ) );
+        _pending.push_back( c );
+        parallelCommandPool().schedule( ParallelCommand::callThread , _s , c );
+        return setVersion;
+    }
+
+    void ParallelCommand::callThread( shared_ptr<Shared> s , shared_ptr<Call> c ) {
+        bool abandoned;
+        {
+            scoped_lock lk( s->m );
+            abandoned = c->abandoned;
+            c->finished = abandoned;
+        }
+        if ( abandoned ) {
+            // the deadline passed while this was queued for a thread, nothing was sent
+            c->conn->kill();
+            delete c->conn;
+            return;
+        }
+
+        BSONObj res;
+        bool ok = false;
+        bool broken = false;
+        try {
+            MessagingPort * port = s->timeoutSecs > 0 ? commandPort( c->client ) : 0;
+            if ( port )
+                setSockTimeouts( port->getSocket() , s->timeoutSecs );
+            ok = c->client->runCommand( s->db , c->cmd , res );
+            if ( port )
+                setSockTimeouts( port->getSocket() , 0 );
+        }
+        catch ( std::exception& e ) {
+            broken = true;
+            BSONObjBuilder b;
+            b.append( "ok" , 0.0 );
+            b.append( "errmsg" , e.what() );
+            res = b.obj();
+        }
+
+        {
+            scoped_lock lk( s->m );
+            c->ok = ok;
+            c->broken = broken;
+            c->res = res.getOwned();
+            c->finished = true;
+            if ( ! c->abandoned ) {
+                s->done.push_back( c );
+                s->replied.notify_one();
+                return;
+            }
+        }
+
+        // nobody is waiting for this anymore, and the connection may be mid reply
+        c->conn->kill();
+        delete c->conn;
+    }
+
+    bool ParallelCommand::next( Result& r ) {
+        shared_ptr<Call> c;
+        {
+            scoped_lock lk( _s->m );
+            while ( _s->done.empty() ) {
+                if ( _pending.empty() )
+                    return false;
+
+                if ( _timeoutMillis == 0 ) {
+                    _s->replied.wait( lk.boost() );
+                }
+                else if ( ! _s->replied.timed_wait( lk.boost() , _deadline ) && _s->done.empty() ) {
+                    for ( list< shared_ptr<Call> >::iterator i = _pending.begin(); i != _pending.end(); ++i ) {
+                        (*i)->abandoned = true;
+                        _timedOut.push_back( (*i)->shard );
+                    }
+                    _pending.clear();
+                    return false;
+                }
+            }
+            c = _s->done.front();
+            _s->done.pop_front();
+            _pending.remove( c );
+        }
+
+        releaseCall( c->conn , c->client , c->broken );
+
+        r.shard = c->shard;
+        r.ok = c->ok;
+        r.res = c->res;
+        if ( r.ok )
+            _nOk++;
+        return true;
+    }
+
+    void ParallelCommand::failed( const Result& r ) {
+        _failed.push_back( make_pair( r.shard , r.res ) );
+    }
+
+    void ParallelCommand::appendTimedOut( BSONObjBuilder& b ) const {
+        BSONObjBuilder t( b.subobjStart( "timedOut" ) );
+        t.append( "timeoutMillis" , _timeoutMillis );
+        t.append( "shards" , _timedOut );
+        t.done();
+    }
+
+    bool ParallelCommand::finish( string& errmsg , BSONObjBuilder& result ) const {
+        if ( _failed.empty() && _timedOut.empty() )
+            return true;
+
+        if ( _failed.size() ) {
+            BSONObjBuilder e( result.subobjStart( "shardErrors" ) );
+            for ( vector< pair<string,BSONObj> >::const_iterator i = _failed.begin(); i != _failed.end(); ++i )
+                e.append( i->first , i->second );
+            e.done();
+        }
+        if ( _timedOut.size() )
+            appendTimedOut( result );
+
+        if ( _nOk == 0 ) {
+            errmsg = _timedOut.size() ? "shards timed out" : "failed on all shards";
+            return false;
+        }
+        result.appendBool( "partial" , true );
+        return true;
+    }
+
+    int ParallelCommand::timeoutFor( const BSONObj& cmdObj ) {
+        BSONElement e = cmdObj["maxTimeMS"];
+        if ( ! e.isNumber() || e.numberInt() < 0 )
+            return 0;
+        return e.numberInt();
+    }
+
 }
@@ -28,6 +28,10 @@
 
 namespace mongo {
 
+    class Shard;
+    class ShardConnection;
+    class FilteringClientCursor;
+
     /**
      * holder for a server address and a query to run
      */
@@ -92,6 +96,16 @@ namespace mongo {
         auto_ptr<DBClientCursor> query( const string& server , int num = 0 , BSONObj extraFilter = BSONObj() , int skipLeft = 0 );
         BSONObj explain( const string& server , BSONObj extraFilter = BSONObj() );
 
+        /**
+         * like query() for every server, but the first batch is requested from all of them
+         * before waiting on any, so the servers work on it concurrently.
+         * @param out array of servers.size() cursors to fill in
+         */
+        void queryAll( const vector<ServerAndQuery>& servers , int skipLeft , FilteringClientCursor * out );
+
+        /** checks the first batch of a cursor from query() or queryAll() and attaches it to conn */
+        auto_ptr<DBClientCursor> _checkCursor( const string& server , ShardConnection& conn , auto_ptr<DBClientCursor> cursor );
+
         static BSONObj _concatFilter( const BSONObj& filter , const BSONObj& extraFilter );
 
         virtual void _explain( map< string,list<BSONObj> >& out ) = 0;
@@ -120,6 +134,9 @@ namespace mongo {
         BSONObj next();
 
         BSONObj peek();
+
+        /** @return true if more() can answer from what has already been fetched, without a getMore */
+        bool moreInCurrentBatch();
     private:
         void _advance();
 
@@ -237,6 +254,31 @@ namespace mongo {
         int _needToSkip;
     };
 
+    /**
+     * runs a query in parallel across N servers, returning results in whatever order they arrive.
+     * used when there is no sort, instead of SerialServerClusteredCursor.
+     * the first batch is requested from every server up front, and next() drains batches that
+     * are already buffered before blocking on a getMore from any one server.
+     */
+    class ParallelUnorderedClusteredCursor : public ClusteredCursor {
+    public:
+        ParallelUnorderedClusteredCursor( const set<ServerAndQuery>& servers , QueryMessage& q );
+        virtual ~ParallelUnorderedClusteredCursor();
+        virtual bool more();
+        virtual BSONObj next();
+        virtual string type() const { return "ParallelUnordered"; }
+    protected:
+        void _init();
+
+        virtual void _explain( map< string,list<BSONObj> >& out );
+
+        vector<ServerAndQuery> _servers;
+
+        FilteringClientCursor * _cursors;
+        unsigned _current; // server we last returned from
+        int _needToSkip;
+    };
+
     /**
      * tools for doing asynchronous operations
      * right now uses underlying sync network ops and uses another thread
@@ -296,6 +338,81 @@ namespace mongo {
         static shared_ptr<CommandResult> spawnCommand( const string& server , const string& db , const BSONObj& cmd , DBClientBase * conn = 0 );
     };
 
+    /**
+     * scatter/gather for commands sent to several shards.
+     * the commands run on a thread pool shared by all ParallelCommands, and replies are handed
+     * back in the order they arrive so the caller can merge while slower shards are still
+     * working.  shards that haven't answered by the deadline are given up on rather than holding
+     * up the caller, and their sockets time out so the pool threads don't hang on them either.
+     *
+     * connections are checked out (and shard versions set) on the calling thread as
+     * ShardConnection is per thread; only the command itself runs on the other threads.
+     *
+     * a shard that fails or times out doesn't fail the whole command: the caller passes failed
+     * replies to failed(), merges the rest, and finish() reports what's missing.
+     */
+    class ParallelCommand : boost::noncopyable {
+    public:
+        struct Result {
+            string shard;  // shard name
+            bool ok;
+            BSONObj res;
+        };
+
+        /** @param timeoutMillis give up on shards that haven't replied this long after construction, 0 for no limit */
+        ParallelCommand( const string& db , int timeoutMillis = 0 );
+
+        /** connections of commands still running are closed as those commands finish */
+        ~ParallelCommand();
+
+        /**
+         * starts cmd on shard
+         * @param ns if not empty, the connection is versioned for ns like ShardConnection
+         * @return true if the shard version had to be changed, see ShardConnection::setVersion
+         */
+        bool spawn( const Shard& shard , const string& ns , const BSONObj& cmd );
+
+        /**
+         * blocks for the next reply
+         * @return false once all spawned commands have been returned or the deadline has passed
+         */
+        bool next( Result& r );
+
+        /** shards given up on at the deadline */
+        const vector<string>& timedOut() const { return _timedOut; }
+
+        /** notes a failed reply from next() that the caller left out of its result */
+        void failed( const Result& r );
+
+        /** timedOut : { timeoutMillis : <n> , shards : [ <shard>, ... ] } */
+        void appendTimedOut( BSONObjBuilder& b ) const;
+
+        /**
+         * call once next() returns false.  if some shards failed or timed out, appends
+         * shardErrors : { <shard> : <reply> } and timedOut, and partial : true if any shard succeeded
+         * @return false if no shard succeeded, with errmsg set
+         */
+        bool finish( string& errmsg , BSONObjBuilder& result ) const;
+
+        /** @return per command deadline in millis requested by the user as maxTimeMS, 0 for none */
+        static int timeoutFor( const BSONObj& cmdObj );
+
+    private:
+        struct Call;
+        struct Shared;
+
+        static void callThread( shared_ptr<Shared> s , shared_ptr<Call> c );
+
+        const string _db;
+        const int _timeoutMillis;
+        boost::xtime _deadline;
+        shared_ptr<Shared> _s;
+        list< shared_ptr<Call> > _pending;
+        vector<string> _timedOut;
+        vector< pair<string,BSONObj> > _failed;
+        int _nOk;
+    };
+
 
 }
 
@@ -1153,6 +1153,31 @@ namespace mongo {
         return false;
     }
 
+    bool BtreeBucket::isLeaf() const {
+        if ( !nextChild.isNull() )
+            return false;
+        for ( int i = 0; i < n; i++ )
+            if ( !k(i).prevChildBucket.isNull() )
+                return false;
+        return true;
+    }
+
+    void BtreeBucket::delLeafKeys(const DiskLoc thisLoc, IndexDetails& id, int from, int to) const {
+        assert( 0 <= from && from < to && to <= n && isLeaf() );
+        BtreeBucket *b = thisLoc.btreemod();
+        // back to front so the positions still to delete don't shift
+        for ( int p = to - 1; p >= from; p-- )
+            b->_delKeyAtPos( p, true );
+
+        // the rest is what delKeyAtPos() does after taking a key out of a leaf
+        if ( b->isHead() )
+            return;
+        if ( !b->mayBalanceWithNeighbors( thisLoc, id, Ordering::make(id.keyPattern()) ) && b->n == 0 ) {
+            // An empty bucket is only allowed as a transient state.
+            b->delBucket( thisLoc, id );
+        }
+    }
+
     BtreeBucket* BtreeBucket::allocTemp() {
         BtreeBucket *b = (BtreeBucket*) malloc(BucketSize);
         b->init();
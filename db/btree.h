@@ -544,6 +544,20 @@ namespace mongo {
          */
         bool unindex(const DiskLoc thisLoc, IndexDetails& id, const BSONObj& key, const DiskLoc recordLoc) const;
 
+        /** @return true if no key of this bucket has a child bucket */
+        bool isLeaf() const;
+
+        /**
+         * Removes a run of keys from a leaf bucket and rebalances once, instead of after every
+         * key as separate unindex() calls would.  For Helpers::removeRange.
+         * Preconditions:
+         *  - isLeaf() and 0 <= from < to <= n
+         * Postconditions:
+         *  - The keys at positions [from, to) are removed, and 'this' / thisLoc may be
+         *    invalidated, as with unindex().
+         */
+        void delLeafKeys(const DiskLoc thisLoc, IndexDetails& id, int from, int to) const;
+
         /**
          * locate may return an "unused" key that is just a marker.  so be careful.
          *   looks for a key:recordloc pair.
@@ -906,8 +920,9 @@ namespace mongo {
 
         virtual long long nscanned() { return _nscanned; }
 
-        /** for debugging only */
+        /** for debugging, and for Helpers::removeRange to unindex by bucket */
         const DiskLoc getBucket() const { return bucket; }
+        int getKeyOfs() const { return keyOfs; }
 
     private:
         /**
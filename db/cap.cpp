@@ -189,6 +189,8 @@ namespace mongo {
     }
 
     DiskLoc NamespaceDetails::cappedAlloc(const char *ns, int len) {
+        CappedInsertNotifier::notify( ns );
+
         // signal done allocating new extents.
         if ( !cappedLastDelRecLastExtent().isValid() )
             getDur().writingDiskLoc( cappedLastDelRecLastExtent() ) = DiskLoc();
@@ -449,4 +451,54 @@ namespace mongo {
         }
     }
 
+    /* CappedInsertNotifier -------------------------------------------------- */
+
+    mongo::mutex CappedInsertNotifier::_m("CappedInsertNotifier");
+    map< string , shared_ptr<CappedInsertNotifier::Waiters> > CappedInsertNotifier::_waiters;
+    volatile bool CappedInsertNotifier::_any = false;
+
+    void CappedInsertNotifier::notify( const char *ns ) {
+        // _any is set under the db lock we hold now, so no one who might be waiting is missed
+        if ( ! _any )
+            return;
+        scoped_lock lk( _m );
+        map< string , shared_ptr<Waiters> >::iterator i = _waiters.find( ns );
+        if ( i == _waiters.end() )
+            return;
+        i->second->version++;
+        i->second->changed.notify_all();
+    }
+
+    unsigned long long CappedInsertNotifier::version( const char *ns ) {
+        scoped_lock lk( _m );
+        shared_ptr<Waiters> &w = _waiters[ ns ];
+        if ( ! w ) {
+            // never erased: only the few namespaces that get tailed end up here
+            w.reset( new Waiters() );
+            _any = true;
+        }
+        return w->version;
+    }
+
+    bool CappedInsertNotifier::wait( const char *ns , unsigned long long v , int millis ) {
+        boost::xtime xt;
+        boost::xtime_get( &xt, boost::TIME_UTC );
+        xt.sec += millis / 1000;
+        xt.nsec += ( millis % 1000 ) * 1000000;
+        if ( xt.nsec >= 1000000000 ) {
+            xt.nsec -= 1000000000;
+            xt.sec++;
+        }
+
+        scoped_lock lk( _m );
+        map< string , shared_ptr<Waiters> >::iterator i = _waiters.find( ns );
+        assert( i != _waiters.end() ); // version() first
+        Waiters &w = *i->second;
+        while ( w.version == v ) {
+            if ( ! w.changed.timed_wait( lk.boost() , xt ) )
+                return w.version != v;
+        }
+        return true;
+    }
+
 }
@@ -323,6 +323,14 @@ namespace mongo {
         if ( _lockType )
             b.append("lockType" , _lockType > 0 ? "write" : "read"  );
         b.append("waitingForLock" , _waitingForLock );
+        {
+            BSONObjBuilder ls( b.subobjStart( "lockStats" ) );
+            BSONObjBuilder ta( ls.subobjStart( "timeAcquiringMicros" ) );
+            ta.appendNumber( "r" , _timeAcquiringMicros[0] );
+            ta.appendNumber( "w" , _timeAcquiringMicros[1] );
+            ta.done();
+            ls.done();
+        }
 
         if( a ) {
             b.append("secs_running", elapsedSeconds() );
@@ -26,20 +26,29 @@
 #include "db.h"
 #include "instance.h"
 #include "repl.h"
+#include "../util/mongoutils/str.h"
 
 namespace mongo {
 
+    using namespace mongoutils;
+
     void ensureHaveIdIndex(const char *ns);
 
     bool replAuthenticate(DBClientBase *);
 
     class Cloner: boost::noncopyable {
         auto_ptr< DBClientWithCommands > conn;
+        CloneProgress *progress;
         void copy(const char *from_ns, const char *to_ns, bool isindex, bool logForRepl,
                   bool masterSameProcess, bool slaveOk, Query q = Query());
+        void cloneOne(const BSONObj& collection, const string& todb, bool logForRepl, bool masterSameProcess, bool slaveOk, bool snapshot);
         struct Fun;
+        struct Parallel;
+        static void cloneThread(Parallel *p);
+        bool cloneInParallel(const char *masterHost, string& errmsg, list<BSONObj>& toClone, const string& todb,
+                             bool logForRepl, bool slaveOk, bool snapshot, int nThreads);
     public:
-        Cloner() { }
+        Cloner() : progress(0) { }
 
         /* slaveOk     - if true it is ok if the source of the data is !ismaster.
            useReplAuth - use the credentials we normally use as a replication slave for the cloning
@@ -47,7 +56,8 @@ namespace mongo {
                          for example repairDatabase need not use it.
         */
         void setConnection( DBClientWithCommands *c ) { conn.reset( c ); }
-        bool go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot);
+        void setProgress( CloneProgress *p ) { progress = p; }
+        bool go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot, int nThreads = 1);
 
         bool copyCollection( const string& from , const string& ns , const BSONObj& query , string& errmsg , bool copyIndexes = true, bool logForRepl = true );
     };
@@ -142,8 +152,15 @@ namespace mongo {
                     saveLast = time( 0 );
                 }
             }
+
+            if ( progress ) {
+                progress->gotObjects( n - reported );
+                reported = n;
+            }
         }
         int n;
+        int reported;
+        CloneProgress *progress;
         bool isindex;
         const char *from_collection;
         const char *to_collection;
@@ -161,6 +178,8 @@ namespace mongo {
 
         Fun f;
         f.n = 0;
+        f.reported = 0;
+        f.progress = isindex ? 0 : progress;
         f.isindex = isindex;
         f.from_collection = from_collection;
         f.to_collection = to_collection;
@@ -251,7 +270,138 @@ namespace mongo {
     extern bool inDBRepair;
     void ensureIdIndexForNewNs(const char *ns);
 
-    bool Cloner::go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot) {
+    /* create the collection and copy its documents.  the _id index is built after the copy, in
+       bulk; the other indexes are built by go() once every collection is in.
+    */
+    void Cloner::cloneOne(const BSONObj& collection, const string& todb, bool logForRepl, bool masterSameProcess, bool slaveOk, bool snapshot) {
+        log(2) << "  really will clone: " << collection << endl;
+        const char * from_name = collection["name"].valuestr();
+        BSONObj options = collection.getObjectField("options");
+
+        /* change name "<fromdb>.collection" -> <todb>.collection */
+        const char *p = strchr(from_name, '.');
+        assert(p);
+        string to_name = todb + p;
+
+        bool wantIdIndex = false;
+        {
+            string err;
+            const char *toname = to_name.c_str();
+            /* we defer building id index for performance - building it in batch is much faster */
+            userCreateNS(toname, options, err, logForRepl, &wantIdIndex);
+        }
+        log(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
+        Query q;
+        if( snapshot )
+            q.snapshot();
+        copy(from_name, to_name.c_str(), false, logForRepl, masterSameProcess, slaveOk, q);
+
+        if( wantIdIndex ) {
+            /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
+               that occur during the initial sync.  inDBRepair makes dropDups be true.
+               the index build doesn't yield, so other cloning threads can't see our setting of inDBRepair.
+               */
+            bool old = inDBRepair;
+            try {
+                inDBRepair = true;
+                ensureIdIndexForNewNs(to_name.c_str());
+                inDBRepair = old;
+            }
+            catch(...) {
+                inDBRepair = old;
+                throw;
+            }
+        }
+
+        if ( progress )
+            progress->collectionDone();
+    }
+
+    /* the collections of one database, handed out to the cloning threads */
+    struct Cloner::Parallel : boost::noncopyable {
+        Parallel(list<BSONObj>& c) : m("Cloner::Parallel"), collections(c) { }
+        mongo::mutex m;
+        list<BSONObj>& collections; // not yet taken, under m
+        string errmsg;              // first failure, under m.  the other threads stop when it is set
+        string host;
+        string todb;
+        bool logForRepl;
+        bool slaveOk;
+        bool snapshot;
+        CloneProgress *progress;
+    };
+
+    /* clones collections from p until there are none left, over its own connection to the source */
+    void Cloner::cloneThread(Parallel *p) {
+        Client::initThread("cloner");
+        try {
+            Cloner c;
+            c.progress = p->progress;
+            {
+                string errmsg;
+                ConnectionString cs = ConnectionString::parse( p->host, errmsg );
+                auto_ptr<DBClientBase> con( cs.connect( errmsg ) );
+                uassert( 13697 , str::stream() << "cloner couldn't connect to " << p->host << ' ' << errmsg , con.get() );
+                uassert( 13698 , str::stream() << "cloner couldn't authenticate to " << p->host , replAuthenticate( con.get() ) );
+                c.conn = con;
+            }
+
+            while ( 1 ) {
+                BSONObj collection;
+                {
+                    scoped_lock lk( p->m );
+                    if ( p->collections.empty() || !p->errmsg.empty() )
+                        break;
+                    collection = p->collections.front();
+                    p->collections.pop_front();
+                }
+
+                writelock lk( p->todb );
+                Client::Context ctx( p->todb );
+                c.cloneOne( collection, p->todb, p->logForRepl, false, p->slaveOk, p->snapshot );
+            }
+        }
+        catch ( std::exception& e ) {
+            log() << "cloner thread failed: " << e.what() << endl;
+            scoped_lock lk( p->m );
+            if ( p->errmsg.empty() )
+                p->errmsg = str::stream() << "cloning failed: " << e.what();
+        }
+        cc().shutdown();
+    }
+
+    /* clone the collections of toClone with nThreads threads.  we are write locked on arrival; the
+       lock is released while the threads run so they can take it in turns.
+    */
+    bool Cloner::cloneInParallel(const char *masterHost, string& errmsg, list<BSONObj>& toClone, const string& todb,
+                                 bool logForRepl, bool slaveOk, bool snapshot, int nThreads) {
+        Parallel p( toClone );
+        p.host = masterHost;
+        p.todb = todb;
+        p.logForRepl = logForRepl;
+        p.slaveOk = slaveOk;
+        p.snapshot = snapshot;
+        p.progress = progress;
+
+        int n = min( nThreads , (int) toClone.size() );
+        log(1) << "cloning " << toClone.size() << " collections with " << n << " threads" << endl;
+        {
+            dbtemprelease r;
+            vector< shared_ptr<boost::thread> > threads;
+            for ( int i = 0; i < n; i++ )
+                threads.push_back( shared_ptr<boost::thread>( new boost::thread( boost::bind( &Cloner::cloneThread , &p ) ) ) );
+            for ( unsigned i = 0; i < threads.size(); i++ )
+                threads[i]->join();
+        }
+
+        if ( !p.errmsg.empty() ) {
+            errmsg = p.errmsg;
+            return false;
+        }
+        return true;
+    }
+
+    bool Cloner::go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot, int nThreads) {
 
         massert( 10289 ,  "useReplAuth is not written to replication log", !useReplAuth || !logForRepl );
 
@@ -333,47 +483,19 @@ namespace mongo {
             }
         }
 
-        for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
-            {
-                dbtemprelease r;
-            }
-            BSONObj collection = *i;
-            log(2) << "  really will clone: " << collection << endl;
-            const char * from_name = collection["name"].valuestr();
-            BSONObj options = collection.getObjectField("options");
+        if ( progress )
+            progress->startDb( fromdb , toClone.size() );
 
-            /* change name "<fromdb>.collection" -> <todb>.collection */
-            const char *p = strchr(from_name, '.');
-            assert(p);
-            string to_name = todb + p;
-
-            bool wantIdIndex = false;
-            {
-                string err;
-                const char *toname = to_name.c_str();
-                /* we defer building id index for performance - building it in batch is much faster */
-                userCreateNS(toname, options, err, logForRepl, &wantIdIndex);
-            }
-            log(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
-            Query q;
-            if( snapshot )
-                q.snapshot();
-            copy(from_name, to_name.c_str(), false, logForRepl, masterSameProcess, slaveOk, q);
-
-            if( wantIdIndex ) {
-                /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
-                   that occur during the initial sync.  inDBRepair makes dropDups be true.
-                   */
-                bool old = inDBRepair;
-                try {
-                    inDBRepair = true;
-                    ensureIdIndexForNewNs(to_name.c_str());
-                    inDBRepair = old;
-                }
-                catch(...) {
-                    inDBRepair = old;
-                    throw;
+        if ( nThreads > 1 && toClone.size() > 1 && !masterSameProcess ) {
+            if ( !cloneInParallel( masterHost, errmsg, toClone, todb, logForRepl, slaveOk, snapshot, nThreads ) )
+                return false;
+        }
+        else {
+            for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
+                {
+                    dbtemprelease r;
                 }
+                cloneOne( *i, todb, logForRepl, masterSameProcess, slaveOk, snapshot );
             }
         }
 
@@ -390,15 +512,58 @@ namespace mongo {
         return true;
     }
 
-    /* slaveOk     - if true it is ok if the source of the data is !ismaster.
-       useReplAuth - use the credentials we normally use as a replication slave for the cloning
-       snapshot    - use $snapshot mode for copying collections.  note this should not be used when it isn't required, as it will be slower.
-                     for example repairDatabase need not use it.
-    */
     bool cloneFrom(const char *masterHost, string& errmsg, const string& fromdb, bool logForReplication,
-                   bool slaveOk, bool useReplAuth, bool snapshot) {
+                   bool slaveOk, bool useReplAuth, bool snapshot, int nThreads, CloneProgress *progress) {
         Cloner c;
-        return c.go(masterHost, errmsg, fromdb, logForReplication, slaveOk, useReplAuth, snapshot);
+        c.setProgress(progress);
+        return c.go(masterHost, errmsg, fromdb, logForReplication, slaveOk, useReplAuth, snapshot, nThreads);
+    }
+
+    void CloneProgress::start() {
+        scoped_lock lk(_m);
+        _active = true;
+        _db = "";
+        _collections = _collectionsDone = 0;
+        _objects = 0;
+        _t.reset();
+    }
+
+    void CloneProgress::finish() {
+        scoped_lock lk(_m);
+        _active = false;
+    }
+
+    bool CloneProgress::active() const {
+        scoped_lock lk(_m);
+        return _active;
+    }
+
+    void CloneProgress::startDb(const string& db, unsigned n) {
+        scoped_lock lk(_m);
+        _db = db;
+        _collections = n;
+        _collectionsDone = 0;
+    }
+
+    void CloneProgress::collectionDone() {
+        scoped_lock lk(_m);
+        _collectionsDone++;
+    }
+
+    void CloneProgress::gotObjects(unsigned n) {
+        scoped_lock lk(_m);
+        _objects += n;
+    }
+
+    void CloneProgress::append(BSONObjBuilder& b) const {
+        scoped_lock lk(_m);
+        int secs = _t.seconds();
+        b.append("db", _db);
+        b.append("collections", (int) _collections);
+        b.append("collectionsCloned", (int) _collectionsDone);
+        b.append("objects", _objects);
+        b.append("objectsPerSec", secs ? _objects / secs : _objects);
+        b.append("secs", secs);
     }
 
     /* Usage:
@@ -0,0 +1,66 @@
+// cloner.h - copy a database (export/import basically)
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "jsobj.h"
+#include "../util/timer.h"
+
+namespace mongo {
+
+    /** how far along a clone of one or more databases is.  the cloning threads update it once per
+        batch; replSetGetStatus reads it during initial sync.
+    */
+    class CloneProgress : boost::noncopyable {
+    public:
+        CloneProgress() : _m("CloneProgress"), _active(false), _collections(0), _collectionsDone(0), _objects(0) { }
+
+        /** starting a new clone, counters go back to zero */
+        void start();
+        void finish();
+        bool active() const;
+
+        /** now cloning db, which has n collections to copy */
+        void startDb(const string& db, unsigned n);
+        void collectionDone();
+        void gotObjects(unsigned n);
+
+        /** { db, collections, collectionsCloned, objects, objectsPerSec, secs } */
+        void append(BSONObjBuilder& b) const;
+
+    private:
+        mutable mongo::mutex _m;
+        bool _active;
+        string _db;
+        unsigned _collections;
+        unsigned _collectionsDone;
+        long long _objects;
+        Timer _t;
+    };
+
+    /* slaveOk     - if true it is ok if the source of the data is !ismaster.
+       useReplAuth - use the credentials we normally use as a replication slave for the cloning
+       snapshot    - use $snapshot mode for copying collections.  note this should not be used when it isn't required, as it will be slower.
+                     for example repairDatabase need not use it.
+       nThreads    - clone up to this many collections at once, each over its own connection
+       progress    - if not null, updated as we go
+    */
+    bool cloneFrom(const char *masterHost, string& errmsg, const string& fromdb, bool logForReplication,
+                   bool slaveOk, bool useReplAuth, bool snapshot, int nThreads = 1, CloneProgress *progress = 0);
+
+}
@@ -29,7 +29,7 @@ namespace mongo {
         CmdLine() :
             port(DefaultDBPort), rest(false), jsonp(false), quiet(false), noTableScan(false), prealloc(true), smallfiles(sizeof(int*) == 4),
             quota(false), quotaFiles(8), cpu(false), durOptions(0), oplogSize(0), defaultProfile(0), slowMS(100), pretouch(0), moveParanoia( true ),
-            syncdelay(60), socket("/tmp") {
+            rangeDeleteYieldMillis(10), rangeDeleteMBPerSec(0), syncdelay(60), socket("/tmp") {
             // default may change for this later.
 #if defined(_DURABLEDEFAULTON)
             dur = true;
@@ -96,6 +96,8 @@ namespace mongo {
 
         int pretouch;          // --pretouch for replication application (experimental)
         bool moveParanoia;     // for move chunk paranoia
+        int rangeDeleteYieldMillis; // post migration cleanup yields after deleting this long
+        int rangeDeleteMBPerSec;    // post migration cleanup deletes no faster than this, 0 for no limit
         double syncdelay;      // seconds between fsyncs
 
         string socket;         // UNIX domain socket directory
@@ -19,9 +19,337 @@
 #include "../commands.h"
 #include "../instance.h"
 #include "../queryoptimizer.h"
+#include "../../scripting/engine.h"
+#include "mr.h"
 
 namespace mongo {
 
+    /** the per key states of a group */
+    class GroupStates : boost::noncopyable {
+    public:
+        virtual ~GroupStates() {}
+
+        /** a scope for $keyf and finalize */
+        virtual Scope * scope() = 0;
+
+        virtual int numKeys() const = 0;
+
+        /** reduces obj into the state for key */
+        virtual void add( const BSONObj& key , const BSONObj& obj ) = 0;
+
+        /** folds a partial state from a shard into the state for key */
+        virtual void merge( const BSONObj& key , const BSONObj& state ) = 0;
+
+        /** runs finalize over the states if there is one, then appends them as retval */
+        virtual void appendFinal( const string& finalize , BSONObjBuilder& result ) = 0;
+
+        /** appends the states unfinalized as retval : [ { key : <key> , value : <state> } , ... ] */
+        virtual void appendPartial( BSONObjBuilder& result ) = 0;
+
+        /** native if $reduce is an object, see mr::NativeReduceSpec */
+        static GroupStates * make( const string& dbname , const BSONElement& reduce , const BSONObj& initial );
+    };
+
+    /**
+     * states kept in a js scope as $arr
+     * objects are reduced into the state for their key with the user's reduce function
+     */
+    class JSGroupStates : public GroupStates {
+    public:
+        JSGroupStates( const string& dbname , const string& reduceCode , const char * reduceScope , const BSONObj& initial )
+            : _s( globalScriptEngine->getPooledScope( dbname ) ) , _seed( 0 ) {
+            _s->localConnect( dbname.c_str() );
+
+            if ( reduceScope )
+                _s->init( reduceScope );
+
+            _s->setObject( "$initial" , initial , true );
+
+            _s->exec( "$reduce = " + reduceCode , "reduce setup" , false , true , true , 100 );
+            _s->exec( "$arr = [];" , "reduce setup 2" , false , true , true , 100 );
+            _f = _s->createFunction(
+                     "function(){ "
+                     "  if ( $arr[n] == null ){ "
+                     "    next = {}; "
+                     "    Object.extend( next , $key ); "
+                     "    Object.extend( next , $initial , true ); "
+                     "    $arr[n] = next; "
+                     "    next = null; "
+                     "  } "
+                     "  $reduce( obj , $arr[n] ); "
+                     "}" );
+        }
+
+        ~JSGroupStates() {
+            try {
+                _s->exec( "$arr = [];" , "reduce setup 2" , false , true , true , 100 );
+                _s->gc();
+            }
+            catch ( ... ) {
+                // scope goes back to the pool either way
+            }
+        }
+
+        virtual Scope * scope() { return _s.get(); }
+
+        virtual int numKeys() const { return _map.size(); }
+
+        virtual void add( const BSONObj& key , const BSONObj& obj ) {
+            int& n = _map[key];
+            if ( n == 0 ) {
+                n = _map.size();
+                _s->setObject( "$key" , key , true );
+
+                uassert( 10043 ,  "group() can't handle more than 20000 unique keys" , n <= 20000 );
+            }
+
+            _s->setObject( "obj" , obj , true );
+            _s->setNumber( "n" , n - 1 );
+            if ( _s->invoke( _f , BSONObj() , 0 , true ) ) {
+                throw UserException( 9010 , (string)"reduce invoke failed: " + _s->getError() );
+            }
+        }
+
+        /**
+         * the first state seen for a key is taken as is, so keys that live on one shard come out
+         * the same as unsharded.  later ones go through the reduce, which has to be a $combine
+         */
+        virtual void merge( const BSONObj& key , const BSONObj& state ) {
+            if ( _map.count( key ) ) {
+                add( key , state );
+                return;
+            }
+
+            int n = _map.size() + 1;
+            _map[key] = n;
+            uassert( 10043 ,  "group() can't handle more than 20000 unique keys" , n <= 20000 );
+
+            if ( ! _seed )
+                _seed = _s->createFunction( "function(){ $arr[n] = Object.extend( {} , obj , true ); }" );
+            _s->setObject( "obj" , state , true );
+            _s->setNumber( "n" , n - 1 );
+            if ( _s->invoke( _seed , BSONObj() , 0 , true ) ) {
+                throw UserException( 9010 , (string)"reduce invoke failed: " + _s->getError() );
+            }
+        }
+
+        virtual void appendFinal( const string& finalize , BSONObjBuilder& result ) {
+            if (!finalize.empty())
+                runFinalize( _s.get() , finalize );
+
+            result.appendArray( "retval" , _s->getObject( "$arr" ) );
+        }
+
+        virtual void appendPartial( BSONObjBuilder& result ) {
+            vector<BSONObj> keys( _map.size() );
+            for ( map<BSONObj,int,BSONObjCmp>::const_iterator i = _map.begin(); i != _map.end(); ++i )
+                keys[i->second - 1] = i->first;
+
+            BSONObj arr = _s->getObject( "$arr" );
+            BSONArrayBuilder b( result.subarrayStart( "retval" ) );
+            BSONObjIterator i( arr );
+            for ( unsigned n = 0; i.more() && n < keys.size(); n++ ) {
+                BSONObjBuilder x( b.subobjStart() );
+                x.append( "key" , keys[n] );
+                x.appendAs( i.next() , "value" );
+                x.done();
+            }
+            b.done();
+        }
+
+    private:
+        auto_ptr<Scope> _s;
+        ScriptingFunction _f;
+        ScriptingFunction _seed;
+        map<BSONObj,int,BSONObjCmp> _map;
+
+    public:
+        /** replaces each state in $arr with what finalize returns, if anything */
+        static void runFinalize( Scope * s , const string& finalize ) {
+            s->exec( "$finalize = " + finalize , "finalize define" , false , true , true , 100 );
+            ScriptingFunction g = s->createFunction(
+                                      "function(){ "
+                                      "  for(var i=0; i < $arr.length; i++){ "
+                                      "  var ret = $finalize($arr[i]); "
+                                      "  if (ret !== undefined) "
+                                      "    $arr[i] = ret; "
+                                      "  } "
+                                      "}" );
+            s->invoke( g , BSONObj() , 0 , true );
+        }
+    };
+
+    /**
+     * states reduced in C++ with a mr::NativeReduceSpec; js is only used for $keyf and finalize.
+     * each state comes out as the key fields, then initial, then the reduced fields, with later
+     * ones replacing earlier ones of the same name, which is what the js version ends up with.
+     */
+    class NativeGroupStates : public GroupStates {
+    public:
+        NativeGroupStates( const string& dbname , const BSONObj& reduce , const BSONObj& initial )
+            : _dbname( dbname ) , _spec( reduce , false ) , _initial( initial ) {
+            uassert( 13673 , "native group $reduce has to name its fields: { <field> : { <op> : <path or number> } , ... }" ,
+                     ! _spec.scalar() );
+        }
+
+        ~NativeGroupStates() {
+            if ( _s.get() ) {
+                try {
+                    _s->exec( "$arr = []; $states = null;" , "reduce setup 2" , false , true , true , 100 );
+                    _s->gc();
+                }
+                catch ( ... ) {
+                }
+            }
+        }
+
+        virtual Scope * scope() {
+            if ( ! _s.get() ) {
+                _s = globalScriptEngine->getPooledScope( _dbname );
+                _s->localConnect( _dbname.c_str() );
+            }
+            return _s.get();
+        }
+
+        virtual int numKeys() const { return _keys.size(); }
+
+        virtual void add( const BSONObj& key , const BSONObj& obj ) {
+            _state( key ).add( obj );
+        }
+
+        virtual void merge( const BSONObj& key , const BSONObj& state ) {
+            _state( key ).merge( state );
+        }
+
+        virtual void appendFinal( const string& finalize , BSONObjBuilder& result ) {
+            BSONArrayBuilder b;
+            for ( unsigned i = 0; i < _keys.size(); i++ )
+                b.append( _stateObj( i ) );
+            BSONArray arr = b.arr();
+
+            if ( finalize.empty() ) {
+                result.appendArray( "retval" , arr );
+                return;
+            }
+
+            Scope * s = scope();
+            s->setObject( "$states" , BSON( "arr" << arr ) , false );
+            s->exec( "$arr = $states.arr;" , "finalize setup" , false , true , true , 100 );
+            JSGroupStates::runFinalize( s , finalize );
+            result.appendArray( "retval" , s->getObject( "$arr" ) );
+        }
+
+        virtual void appendPartial( BSONObjBuilder& result ) {
+            uassert( 13674 , "$avg can't be merged across shards; $sum the values and a count and divide in finalize" ,
+                     ! _spec.hasAvg() );
+
+            BSONArrayBuilder b( result.subarrayStart( "retval" ) );
+            for ( unsigned i = 0; i < _keys.size(); i++ ) {
+                BSONObjBuilder x( b.subobjStart() );
+                x.append( "key" , _keys[i] );
+                x.append( "value" , _stateObj( i ) );
+                x.done();
+            }
+            b.done();
+        }
+
+    private:
+        mr::NativeReduceState& _state( const BSONObj& key ) {
+            map<BSONObj,int,BSONObjCmp>::iterator i = _map.find( key );
+            if ( i != _map.end() )
+                return _states[i->second];
+
+            uassert( 10043 ,  "group() can't handle more than 20000 unique keys" , _keys.size() < 20000 );
+            _keys.push_back( key.getOwned() );
+            _map[_keys.back()] = _states.size();
+            _states.push_back( mr::NativeReduceState( _spec ) );
+            return _states.back();
+        }
+
+        BSONObj _stateObj( unsigned i ) const {
+            BSONObjBuilder r;
+            _states[i].append( r );
+            BSONObj reduced = r.obj();
+
+            const BSONObj* parts[] = { &_keys[i] , &_initial , &reduced };
+            BSONObjBuilder b;
+            set<string> seen;
+            for ( int p = 0; p < 3; p++ ) {
+                BSONObjIterator j( *parts[p] );
+                while ( j.more() ) {
+                    const char * name = j.next().fieldName();
+                    if ( ! seen.insert( name ).second )
+                        continue;
+                    for ( int q = 2; q >= 0; q-- ) {
+                        BSONElement e = (*parts[q])[name];
+                        if ( ! e.eoo() ) {
+                            b.append( e );
+                            break;
+                        }
+                    }
+                }
+            }
+            return b.obj();
+        }
+
+        string _dbname;
+        mr::NativeReduceSpec _spec;
+        BSONObj _initial;
+        auto_ptr<Scope> _s;
+        map<BSONObj,int,BSONObjCmp> _map;
+        vector<BSONObj> _keys;
+        vector<mr::NativeReduceState> _states;
+    };
+
+    GroupStates * GroupStates::make( const string& dbname , const BSONElement& reduce , const BSONObj& initial ) {
+        if ( reduce.type() == Object )
+            return new NativeGroupStates( dbname , reduce.embeddedObject() , initial );
+        return new JSGroupStates( dbname , reduce._asCode() , reduce.type() != CodeWScope ? 0 : reduce.codeWScopeScopeData() , initial );
+    }
+
+    /** the parts of a group command spec shared by the shard and merge sides */
+    struct GroupSpec {
+        BSONObj key;
+        string keyf;
+        BSONElement reduce;
+        BSONObj initial;
+        string finalize;
+
+        bool parse( const BSONObj& p , string& errmsg ) {
+            if ( p["key"].type() == Object ) {
+                key = p["key"].embeddedObjectUserCheck();
+                if ( ! p["$keyf"].eoo() ) {
+                    errmsg = "can't have key and $keyf";
+                    return false;
+                }
+            }
+            else if ( p["$keyf"].type() ) {
+                keyf = p["$keyf"]._asCode();
+            }
+            else {
+                // no key specified, will use entire object as key
+            }
+
+            reduce = p["$reduce"];
+            if ( reduce.eoo() ) {
+                errmsg = "$reduce has to be set";
+                return false;
+            }
+
+            BSONElement i = p["initial"];
+            if ( i.type() != Object ) {
+                errmsg = "initial has to be an object";
+                return false;
+            }
+            initial = i.embeddedObject();
+
+            if (p["finalize"].type())
+                finalize = p["finalize"]._asCode();
+
+            return true;
+        }
+    };
+
     class GroupCommand : public Command {
     public:
         GroupCommand() : Command("group") {}
@@ -45,46 +373,26 @@ namespace mongo {
             return obj.extractFields( keyPattern , true );
         }
 
+        /**
+         * @param partial leave out finalize and return per key states for group.shardedfinish to merge
+         */
         bool group( string realdbname , const string& ns , const BSONObj& query ,
-                    BSONObj keyPattern , string keyFunctionCode , string reduceCode , const char * reduceScope ,
-                    BSONObj initial , string finalize ,
+                    const GroupSpec& spec , bool partial ,
                     string& errmsg , BSONObjBuilder& result ) {
 
-
-            auto_ptr<Scope> s = globalScriptEngine->getPooledScope( realdbname );
-            s->localConnect( realdbname.c_str() );
-
-            if ( reduceScope )
-                s->init( reduceScope );
-
-            s->setObject( "$initial" , initial , true );
-
-            s->exec( "$reduce = " + reduceCode , "reduce setup" , false , true , true , 100 );
-            s->exec( "$arr = [];" , "reduce setup 2" , false , true , true , 100 );
-            ScriptingFunction f = s->createFunction(
-                                      "function(){ "
-                                      "  if ( $arr[n] == null ){ "
-                                      "    next = {}; "
-                                      "    Object.extend( next , $key ); "
-                                      "    Object.extend( next , $initial , true ); "
-                                      "    $arr[n] = next; "
-                                      "    next = null; "
-                                      "  } "
-                                      "  $reduce( obj , $arr[n] ); "
-                                      "}" );
+            auto_ptr<GroupStates> states( GroupStates::make( realdbname , spec.reduce , spec.initial ) );
+            Scope * s = 0;
 
             ScriptingFunction keyFunction = 0;
-            if ( keyFunctionCode.size() ) {
-                keyFunction = s->createFunction( keyFunctionCode.c_str() );
+            if ( spec.keyf.size() ) {
+                s = states->scope();
+                keyFunction = s->createFunction( spec.keyf.c_str() );
             }
 
 
-            double keysize = keyPattern.objsize() * 3;
+            double keysize = spec.key.objsize() * 3;
             double keynum = 1;
 
-            map<BSONObj,int,BSONObjCmp> map;
-            list<BSONObj> blah;
-
             shared_ptr<Cursor> cursor = bestGuessCursor(ns.c_str() , query , BSONObj() );
 
             while ( cursor->ok() ) {
@@ -96,43 +404,19 @@ namespace mongo {
                 BSONObj obj = cursor->current();
                 cursor->advance();
 
-                BSONObj key = getKey( obj , keyPattern , keyFunction , keysize / keynum , s.get() );
+                BSONObj key = getKey( obj , spec.key , keyFunction , keysize / keynum , s );
                 keysize += key.objsize();
                 keynum++;
 
-                int& n = map[key];
-                if ( n == 0 ) {
-                    n = map.size();
-                    s->setObject( "$key" , key , true );
-
-                    uassert( 10043 ,  "group() can't handle more than 20000 unique keys" , n <= 20000 );
-                }
-
-                s->setObject( "obj" , obj , true );
-                s->setNumber( "n" , n - 1 );
-                if ( s->invoke( f , BSONObj() , 0 , true ) ) {
-                    throw UserException( 9010 , (string)"reduce invoke failed: " + s->getError() );
-                }
-            }
-
-            if (!finalize.empty()) {
-                s->exec( "$finalize = " + finalize , "finalize define" , false , true , true , 100 );
-                ScriptingFunction g = s->createFunction(
-                                          "function(){ "
-                                          "  for(var i=0; i < $arr.length; i++){ "
-                                          "  var ret = $finalize($arr[i]); "
-                                          "  if (ret !== undefined) "
-                                          "    $arr[i] = ret; "
-                                          "  } "
-                                          "}" );
-                s->invoke( g , BSONObj() , 0 , true );
+                states->add( key , obj );
             }
 
-            result.appendArray( "retval" , s->getObject( "$arr" ) );
+            if ( partial )
+                states->appendPartial( result );
+            else
+                states->appendFinal( spec.finalize , result );
             result.append( "count" , keynum - 1 );
-            result.append( "keys" , (int)(map.size()) );
-            s->exec( "$arr = [];" , "reduce setup 2" , false , true , true , 100 );
-            s->gc();
+            result.append( "keys" , states->numKeys() );
 
             return true;
         }
@@ -157,46 +441,77 @@ namespace mongo {
 
             string ns = dbname + "." + p["ns"].String();
 
-            BSONObj key;
-            string keyf;
-            if ( p["key"].type() == Object ) {
-                key = p["key"].embeddedObjectUserCheck();
-                if ( ! p["$keyf"].eoo() ) {
-                    errmsg = "can't have key and $keyf";
-                    return false;
-                }
-            }
-            else if ( p["$keyf"].type() ) {
-                keyf = p["$keyf"]._asCode();
-            }
-            else {
-                // no key specified, will use entire object as key
-            }
-
-            BSONElement reduce = p["$reduce"];
-            if ( reduce.eoo() ) {
-                errmsg = "$reduce has to be set";
+            GroupSpec spec;
+            if ( ! spec.parse( p , errmsg ) )
                 return false;
-            }
 
-            BSONElement initial = p["initial"];
-            if ( initial.type() != Object ) {
-                errmsg = "initial has to be an object";
-                return false;
-            }
+            // set by mongos, which merges the results with group.shardedfinish
+            bool partial = jsobj["partial"].trueValue();
 
+            return group( dbname , ns , q , spec , partial , errmsg , result );
+        }
 
-            string finalize;
-            if (p["finalize"].type())
-                finalize = p["finalize"]._asCode();
+    } cmdGroup;
 
-            return group( dbname , ns , q ,
-                          key , keyf , reduce._asCode() , reduce.type() != CodeWScope ? 0 : reduce.codeWScopeScopeData() ,
-                          initial.embeddedObject() , finalize ,
-                          errmsg , result );
+    /**
+     * merges the partial results of group on each shard
+     * { group.shardedfinish : <group spec> , shards : { <shard> : <partial group result> , ... } }
+     *
+     * states for a key found on more than one shard are folded together with $combine, or by a
+     * native reduce.  a js $reduce adds one document to a state, so it can't be trusted to merge
+     * two states (prev.count++ would lose counts): without $combine such a key is an error.
+     */
+    class GroupFinishCommand : public Command {
+    public:
+        GroupFinishCommand() : Command( "group.shardedfinish" ) {}
+        virtual LockType locktype() const { return NONE; }
+        virtual bool slaveOk() const { return true; }
+        virtual void help( stringstream &help ) const {
+            help << "internal, merges the results of group run on each shard";
         }
 
-    } cmdGroup;
+        bool run(const string& dbname, BSONObj& jsobj, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            const BSONObj& p = jsobj.firstElement().embeddedObjectUserCheck();
+
+            GroupSpec spec;
+            if ( ! spec.parse( p , errmsg ) )
+                return false;
+
+            // native reduces merge their own output
+            BSONElement combine = p["$combine"];
+            if ( ! combine.eoo() && spec.reduce.type() != Object )
+                spec.reduce = combine;
+            bool canMerge = spec.reduce.type() == Object || ! combine.eoo();
+
+            auto_ptr<GroupStates> states( GroupStates::make( dbname , spec.reduce , spec.initial ) );
+            set<BSONObj,BSONObjCmp> seen; // keys merged so far, if they can't be merged twice
+
+            long long count = 0;
+            BSONObjIterator i( jsobj.getObjectField( "shards" ) );
+            while ( i.more() ) {
+                BSONObj res = i.next().Obj();
+                count += res["count"].numberLong();
+
+                BSONObjIterator j( res.getObjectField( "retval" ) );
+                while ( j.more() ) {
+                    BSONObj partial = j.next().Obj();
+                    BSONObj key = partial.getObjectField( "key" );
+                    if ( ! canMerge && ! seen.insert( key ).second ) {
+                        errmsg = str::stream() << "key " << key << " is on more than one shard;"
+                                 " group on a sharded collection needs $combine to merge $reduce states";
+                        return false;
+                    }
+                    states->merge( key , partial.getObjectField( "value" ) );
+                }
+            }
+
+            states->appendFinal( spec.finalize , result );
+            result.append( "count" , (double) count );
+            result.append( "keys" , states->numKeys() );
+            return true;
+        }
+
+    } cmdGroupFinish;
 
 
 } // namespace mongo
@@ -208,6 +208,253 @@ namespace mongo {
             _reduce( x , key , endSizeEstimate );
         }
 
+        NativeReduceSpec::NativeReduceSpec( const BSONObj& spec , bool forMapReduce ) {
+            BSONObjIterator i( spec );
+            while ( i.more() ) {
+                BSONElement e = i.next();
+
+                Accumulator a;
+                BSONElement op;
+                if ( e.fieldName()[0] == '$' ) {
+                    // { <op> : 1 } on plain values
+                    uassert( 13663 , "native reduce of plain values has to be { <op> : 1 }" ,
+                             spec.nFields() == 1 && e.isNumber() );
+                    op = e;
+                }
+                else {
+                    if ( e.type() == Object && e.embeddedObject().nFields() == 1 )
+                        op = e.embeddedObject().firstElement();
+                    uassert( 13664 , str::stream() << "native reduce field " << e.fieldName() << " has to be { <op> : <path or number> }" ,
+                             op.type() == String || op.isNumber() );
+                    a.field = e.fieldName();
+
+                    if ( op.type() == String )
+                        a.path = op.valuestr()[0] == '$' ? op.valuestr() + 1 : op.valuestr();
+                    else
+                        a.constant = op.wrap( "" );
+
+                    if ( forMapReduce )
+                        uassert( 13665 , str::stream() << "map/reduce reduces its own output, so field " << a.field << " has to be reduced from itself" ,
+                                 a.path == a.field );
+                }
+
+                if ( str::equals( op.fieldName() , "$sum" ) )
+                    a.op = Sum;
+                else if ( str::equals( op.fieldName() , "$min" ) )
+                    a.op = Min;
+                else if ( str::equals( op.fieldName() , "$max" ) )
+                    a.op = Max;
+                else if ( str::equals( op.fieldName() , "$avg" ) )
+                    a.op = Avg;
+                else
+                    uasserted( 13666 , str::stream() << "unknown native reduce op: " << op.fieldName() );
+
+                uassert( 13667 , "$avg can't be reduced again; $sum the values and a count and divide in finalize" ,
+                         ! forMapReduce || a.op != Avg );
+
+                _accs.push_back( a );
+            }
+            uassert( 13668 , "empty native reduce" , _accs.size() );
+        }
+
+        bool NativeReduceSpec::hasAvg() const {
+            for ( unsigned i = 0; i < _accs.size(); i++ ) {
+                if ( _accs[i].op == Avg )
+                    return true;
+            }
+            return false;
+        }
+
+        NativeReduceState::NativeReduceState( const NativeReduceSpec& spec )
+            : _spec( &spec ) , _values( spec.accumulators().size() ) {
+        }
+
+        void NativeReduceState::add( const BSONObj& in ) {
+            const vector<NativeReduceSpec::Accumulator>& accs = _spec->accumulators();
+            for ( unsigned i = 0; i < accs.size(); i++ ) {
+                const NativeReduceSpec::Accumulator& a = accs[i];
+                _add( _values[i] , a.op , a.path.empty() ? a.constant.firstElement() : in.getFieldDotted( a.path.c_str() ) );
+            }
+        }
+
+        void NativeReduceState::addValue( const BSONElement& v ) {
+            _add( _values[0] , _spec->accumulators()[0].op , v );
+        }
+
+        void NativeReduceState::merge( const BSONObj& out ) {
+            const vector<NativeReduceSpec::Accumulator>& accs = _spec->accumulators();
+            for ( unsigned i = 0; i < accs.size(); i++ ) {
+                massert( 13669 , "can't merge $avg" , accs[i].op != NativeReduceSpec::Avg );
+                _add( _values[i] , accs[i].op , out.getFieldDotted( accs[i].field.c_str() ) );
+            }
+        }
+
+        void NativeReduceState::_add( Value& v , NativeReduceSpec::Op op , const BSONElement& e ) {
+            switch ( op ) {
+            case NativeReduceSpec::Sum:
+            case NativeReduceSpec::Avg:
+                if ( ! e.isNumber() )
+                    return;
+                v.n++;
+                if ( e.type() == NumberDouble ) {
+                    v.d += e._numberDouble();
+                    v.isDouble = true;
+                }
+                else {
+                    v.l += e.numberLong();
+                }
+                return;
+            case NativeReduceSpec::Min:
+            case NativeReduceSpec::Max:
+                // like missing values, nulls don't take part
+                if ( e.eoo() || e.type() == jstNULL || e.type() == Undefined )
+                    return;
+                if ( ! v.best.isEmpty() ) {
+                    int c = e.woCompare( v.best.firstElement() , false );
+                    if ( op == NativeReduceSpec::Min ? c >= 0 : c <= 0 )
+                        return;
+                }
+                v.best = e.wrap( "" );
+                return;
+            }
+        }
+
+        void NativeReduceState::append( BSONObjBuilder& b ) const {
+            const vector<NativeReduceSpec::Accumulator>& accs = _spec->accumulators();
+            for ( unsigned i = 0; i < accs.size(); i++ )
+                _append( _values[i] , accs[i].op , b , accs[i].field );
+        }
+
+        void NativeReduceState::appendValue( BSONObjBuilder& b , const StringData& name ) const {
+            _append( _values[0] , _spec->accumulators()[0].op , b , name );
+        }
+
+        void NativeReduceState::_append( const Value& v , NativeReduceSpec::Op op , BSONObjBuilder& b , const StringData& name ) const {
+            switch ( op ) {
+            case NativeReduceSpec::Sum:
+                if ( v.isDouble )
+                    b.append( name , v.d + v.l );
+                else if ( v.l >= numeric_limits<int>::min() && v.l <= numeric_limits<int>::max() )
+                    b.append( name , (int) v.l );
+                else
+                    b.append( name , v.l );
+                return;
+            case NativeReduceSpec::Avg:
+                if ( v.n )
+                    b.append( name , ( v.d + v.l ) / v.n );
+                else
+                    b.appendNull( name );
+                return;
+            case NativeReduceSpec::Min:
+            case NativeReduceSpec::Max:
+                if ( v.best.isEmpty() )
+                    b.appendNull( name );
+                else
+                    b.appendAs( v.best.firstElement() , name );
+                return;
+            }
+        }
+
+        NativeMapper::NativeMapper( const BSONObj& spec ) : _spec( spec.getOwned() ) , _state( 0 ) {
+            _key = _spec["key"];
+            _value = _spec["value"];
+            uassert( 13670 , "native map has to be { key : <expr> , value : <expr> }" ,
+                     ! _key.eoo() && ! _value.eoo() && _spec.nFields() == 2 );
+        }
+
+        void NativeMapper::_append( BSONObjBuilder& b , const StringData& name , const BSONElement& expr , const BSONObj& doc ) {
+            if ( expr.type() == String && expr.valuestr()[0] == '$' ) {
+                BSONElement e = doc.getFieldDotted( expr.valuestr() + 1 );
+                if ( e.eoo() )
+                    b.appendNull( name );
+                else
+                    b.appendAs( e , name );
+            }
+            else if ( expr.type() == Object ) {
+                BSONObjBuilder sub( b.subobjStart( name ) );
+                BSONObjIterator i( expr.embeddedObject() );
+                while ( i.more() ) {
+                    BSONElement e = i.next();
+                    _append( sub , e.fieldName() , e , doc );
+                }
+                sub.done();
+            }
+            else {
+                b.appendAs( expr , name );
+            }
+        }
+
+        /**
+         * Emits the (key, value) tuple the spec describes, without going through js
+         */
+        void NativeMapper::map( const BSONObj& o ) {
+            BSONObjBuilder b;
+            _append( b , "0" , _key , o );
+            _append( b , "1" , _value , o );
+            BSONObj args = b.obj();
+            uassert( 13671 , "an emit can't be more than half max bson size" , args.objsize() < ( BSONObjMaxUserSize / 2 ) );
+            _state->emit( args );
+        }
+
+        BSONObj NativeReducer::reduce( const BSONList& tuples ) {
+            if (tuples.size() <= 1)
+                return tuples[0];
+
+            BSONObjBuilder b;
+            b.appendAs( tuples[0].firstElement() , "0" );
+            _reduce( tuples , b , "1" );
+            return b.obj();
+        }
+
+        BSONObj NativeReducer::finalReduce( const BSONList& tuples , Finalizer * finalizer ) {
+            BSONObj res;
+
+            if (tuples.size() == 1) {
+                BSONObjBuilder b( tuples[0].objsize() );
+                BSONObjIterator it( tuples[0] );
+                b.appendAs( it.next() , "_id" );
+                b.appendAs( it.next() , "value" );
+                res = b.obj();
+            }
+            else {
+                BSONObjBuilder b;
+                b.appendAs( tuples[0].firstElement() , "_id" );
+                _reduce( tuples , b , "value" );
+                res = b.obj();
+            }
+
+            if ( finalizer ) {
+                res = finalizer->finalize( res );
+            }
+
+            return res;
+        }
+
+        void NativeReducer::_reduce( const BSONList& tuples , BSONObjBuilder& b , const StringData& name ) {
+            NativeReduceState state( _spec );
+            for ( unsigned n = 0; n < tuples.size(); n++ ) {
+                BSONObjIterator j( tuples[n] );
+                j.next();
+                BSONElement v = j.next();
+                if ( _spec.scalar() ) {
+                    state.addValue( v );
+                }
+                else {
+                    uassert( 13672 , "native reduce by field needs object values" , v.type() == Object );
+                    state.add( v.embeddedObject() );
+                }
+            }
+
+            if ( _spec.scalar() ) {
+                state.appendValue( b , name );
+            }
+            else {
+                BSONObjBuilder sub( b.subobjStart( name ) );
+                state.append( sub );
+                sub.done();
+            }
+        }
+
         Config::Config( const string& _dbname , const BSONObj& cmdObj ) {
 
             dbname = _dbname;
@@ -268,11 +515,22 @@ namespace mongo {
                 if ( cmdObj["scope"].type() == Object )
                     scopeSetup = cmdObj["scope"].embeddedObjectUserCheck();
 
-                mapper.reset( new JSMapper( cmdObj["map"] ) );
-                reducer.reset( new JSReducer( cmdObj["reduce"] ) );
+                // map and reduce given as objects rather than code are run natively
+                if ( cmdObj["map"].type() == Object )
+                    mapper.reset( new NativeMapper( cmdObj["map"].embeddedObject() ) );
+                else
+                    mapper.reset( new JSMapper( cmdObj["map"] ) );
+
+                if ( cmdObj["reduce"].type() == Object )
+                    reducer.reset( new NativeReducer( cmdObj["reduce"].embeddedObject() ) );
+                else
+                    reducer.reset( new JSReducer( cmdObj["reduce"] ) );
+
                 if ( cmdObj["finalize"].type() && cmdObj["finalize"].trueValue() )
                     finalizer.reset( new JSFinalizer( cmdObj["finalize"] ) );
 
+                usesJS = cmdObj["map"].type() != Object || cmdObj["reduce"].type() != Object || finalizer;
+
                 if ( cmdObj["mapparams"].type() == Array ) {
                     mapParams = cmdObj["mapparams"].embeddedObjectUserCheck();
                 }
@@ -299,6 +557,12 @@ namespace mongo {
                 else
                     limit = 0;
             }
+
+            threads = 1;
+            if ( cmdObj["threads"].isNumber() ) {
+                threads = cmdObj["threads"].numberInt();
+                uassert( 13675 , "threads has to be between 1 and 64" , threads >= 1 && threads <= 64 );
+            }
         }
 
         /**
@@ -465,7 +729,7 @@ namespace mongo {
             getDur().commitIfNeeded();
         }
 
-        State::State( const Config& c ) : _config( c ), _size(0), _numEmits(0) {
+        State::State( const Config& c ) : _config( c ), _size(0), _dupCount(0), _numEmits(0) {
             _temp.reset( new InMemory() );
             _onDisk = _config.outType != Config::INMEMORY;
         }
@@ -494,19 +758,22 @@ namespace mongo {
          * Initialize the mapreduce operation, creating the inc collection
          */
         void State::init() {
-            // setup js
-            _scope.reset(globalScriptEngine->getPooledScope( _config.dbname ).release() );
-            _scope->localConnect( _config.dbname.c_str() );
+            if ( _config.usesJS ) {
+                // setup js
+                _scope.reset(globalScriptEngine->getPooledScope( _config.dbname ).release() );
+                _scope->localConnect( _config.dbname.c_str() );
 
-            if ( ! _config.scopeSetup.isEmpty() )
-                _scope->init( &_config.scopeSetup );
+                if ( ! _config.scopeSetup.isEmpty() )
+                    _scope->init( &_config.scopeSetup );
+            }
 
             _config.mapper->init( this );
             _config.reducer->init( this );
             if ( _config.finalizer )
                 _config.finalizer->init( this );
 
-            _scope->injectNative( "emit" , fast_emit );
+            if ( _scope )
+                _scope->injectNative( "emit" , fast_emit );
 
             if ( _onDisk ) {
                 // clear temp collections
@@ -721,6 +988,19 @@ namespace mongo {
             _add( _temp.get() , a , _size, _dupCount );
         }
 
+        void State::addTuples( const BSONList& tuples ) {
+            for ( unsigned i = 0; i < tuples.size(); i++ )
+                _add( _temp.get() , tuples[i] , _size , _dupCount );
+        }
+
+        InMemory * State::takeInMemory() {
+            InMemory * t = new InMemory();
+            t->swap( *_temp );
+            _size = 0;
+            _dupCount = 0;
+            return t;
+        }
+
         void State::_add( InMemory* im, const BSONObj& a , long& size, long& dupCount ) {
             BSONList& all = (*im)[a];
             all.push_back( a );
@@ -762,6 +1042,291 @@ namespace mongo {
             return BSONObj();
         }
 
+        MapThreads::MapThreads( const string& dbname , const BSONObj& cmdObj , int n , bool handBack )
+            : _dbname( dbname ) , _cmd( cmdObj.getOwned() ) , _handBack( handBack ) , _maxQueued( 2 * n ) ,
+              _m( "MapThreads" ) , _workers( n ) ,
+              _inputDone( false ) , _merging( false ) , _stop( false ) , _numEmits( 0 ) , _mapMicros( 0 ) {
+            for ( int i = 0; i < n; i++ )
+                _threads.push_back( new boost::thread( boost::bind( &MapThreads::_run , this , i ) ) );
+        }
+
+        MapThreads::~MapThreads() {
+            {
+                scoped_lock lk( _m );
+                _stop = true;
+                _cond.notify_all();
+            }
+            for ( unsigned i = 0; i < _threads.size(); i++ ) {
+                _threads[i]->join();
+                delete _threads[i];
+            }
+            for ( unsigned i = 0; i < _workers.size(); i++ ) {
+                delete _workers[i].table;
+                delete _workers[i].range;
+            }
+            for ( list<BSONList*>::iterator i = _queue.begin(); i != _queue.end(); ++i )
+                delete *i;
+            for ( list<InMemory*>::iterator i = _handedBack.begin(); i != _handedBack.end(); ++i )
+                delete *i;
+        }
+
+        void MapThreads::add( BSONList& batch ) {
+            if ( batch.empty() )
+                return;
+            BSONList * b = new BSONList();
+            b->swap( batch );
+            scoped_lock lk( _m );
+            _queue.push_back( b );
+            _cond.notify_all();
+        }
+
+        void MapThreads::waitForRoom( State& state ) {
+            while ( ! _poll( state , &MapThreads::_hasRoom ) )
+                ;
+        }
+
+        bool MapThreads::_hasRoom() const {
+            return _queue.size() < _maxQueued;
+        }
+
+        bool MapThreads::_allMapped() const {
+            for ( unsigned i = 0; i < _workers.size(); i++ ) {
+                if ( ! _workers[i].mapped )
+                    return false;
+            }
+            return true;
+        }
+
+        bool MapThreads::_allMerged() const {
+            for ( unsigned i = 0; i < _workers.size(); i++ ) {
+                if ( ! _workers[i].merged )
+                    return false;
+            }
+            return true;
+        }
+
+        bool MapThreads::_poll( State& state , bool (MapThreads::*ready)() const ) {
+            list<InMemory*> handedBack;
+            string error;
+            bool r;
+            {
+                scoped_lock lk( _m );
+                r = (this->*ready)();
+                if ( ! r && _handedBack.empty() && _error.empty() ) {
+                    boost::xtime xt;
+                    boost::xtime_get( &xt , boost::TIME_UTC );
+                    xt.nsec += 100 * 1000 * 1000;
+                    if ( xt.nsec >= 1000 * 1000 * 1000 ) {
+                        xt.nsec -= 1000 * 1000 * 1000;
+                        xt.sec++;
+                    }
+                    _cond.timed_wait( lk.boost() , xt );
+                    r = (this->*ready)();
+                }
+                handedBack.swap( _handedBack );
+                error = _error;
+            }
+
+            uassert( 13676 , str::stream() << "map/reduce thread failed: " << error , error.empty() );
+
+            for ( list<InMemory*>::iterator i = handedBack.begin(); i != handedBack.end(); ++i ) {
+                auto_ptr<InMemory> t( *i );
+                for ( InMemory::iterator j = t->begin(); j != t->end(); ++j )
+                    state.addTuples( j->second );
+                state.checkSize();
+            }
+
+            if ( *killCurrentOp.checkForInterruptNoAssert() ) {
+                _killWorkers();
+                killCurrentOp.checkForInterrupt();
+            }
+            return r;
+        }
+
+        void MapThreads::_killWorkers() {
+            vector<AtomicUInt> ops;
+            {
+                scoped_lock lk( _m );
+                for ( unsigned i = 0; i < _workers.size(); i++ ) {
+                    if ( _workers[i].opNum > 0 )
+                        ops.push_back( _workers[i].opNum );
+                }
+            }
+            for ( unsigned i = 0; i < ops.size(); i++ )
+                killCurrentOp.kill( ops[i] );
+        }
+
+        void MapThreads::finish( State& state ) {
+            {
+                scoped_lock lk( _m );
+                _inputDone = true;
+                _cond.notify_all();
+            }
+            while ( ! _poll( state , &MapThreads::_allMapped ) )
+                ;
+
+            for ( unsigned i = 0; i < _workers.size(); i++ ) {
+                _numEmits += _workers[i].numEmits;
+                _mapMicros += _workers[i].mapMicros;
+            }
+
+            _split();
+            {
+                scoped_lock lk( _m );
+                _merging = true;
+                _cond.notify_all();
+            }
+            while ( ! _poll( state , &MapThreads::_allMerged ) )
+                ;
+
+            // the ranges don't overlap, so this only adds single tuples
+            for ( unsigned i = 0; i < _workers.size(); i++ ) {
+                if ( ! _workers[i].range )
+                    continue;
+                for ( InMemory::iterator j = _workers[i].range->begin(); j != _workers[i].range->end(); ++j )
+                    state.addTuples( j->second );
+                state.checkSize();
+            }
+        }
+
+        /** evenly spaced keys of the biggest table, so each thread gets about the same share */
+        void MapThreads::_split() {
+            InMemory * biggest = 0;
+            for ( unsigned i = 0; i < _workers.size(); i++ ) {
+                if ( ! biggest || _workers[i].table->size() > biggest->size() )
+                    biggest = _workers[i].table;
+            }
+
+            size_t n = _workers.size();
+            size_t pos = 0;
+            size_t next = 1;
+            for ( InMemory::iterator i = biggest->begin(); i != biggest->end() && next < n; ++i, ++pos ) {
+                if ( pos == biggest->size() * next / n ) {
+                    if ( pos > 0 )
+                        _splits.push_back( i->first );
+                    next++;
+                }
+            }
+        }
+
+        void MapThreads::_run( unsigned i ) {
+            Client::initThread( "mrWorker" );
+            // an op of its own, so killing the map/reduce can interrupt the javascript here
+            cc().curop()->reset();
+            {
+                scoped_lock lk( _m );
+                _workers[i].opNum = cc().curop()->opNum();
+            }
+
+            Worker& w = _workers[i];
+            try {
+                Config config( _dbname , _cmd );
+                config.outType = Config::INMEMORY;
+                State state( config );
+                state.init();
+
+                State** s = new State*();
+                s[0] = &state;
+                _tl.reset( s );
+
+                if ( state.scope() ) {
+                    Scope::NoDBAccess no = state.scope()->disableDBAccess( "can't access db inside a map/reduce with threads" );
+                    _map( w , state );
+                    _merge( i , state );
+                }
+                else {
+                    _map( w , state );
+                    _merge( i , state );
+                }
+            }
+            catch ( std::exception& e ) {
+                scoped_lock lk( _m );
+                if ( _error.empty() )
+                    _error = e.what();
+                _cond.notify_all();
+            }
+            catch ( ... ) {
+                scoped_lock lk( _m );
+                if ( _error.empty() )
+                    _error = "unknown exception";
+                _cond.notify_all();
+            }
+            _tl.reset();
+
+            if ( globalScriptEngine )
+                globalScriptEngine->threadDone();
+            cc().shutdown();
+        }
+
+        void MapThreads::_map( Worker& w , State& state ) {
+            Mapper * mapper = state.config().mapper.get();
+            while ( 1 ) {
+                auto_ptr<BSONList> batch;
+                {
+                    scoped_lock lk( _m );
+                    while ( _queue.empty() && ! _inputDone && ! _stop )
+                        _cond.wait( lk.boost() );
+                    if ( _stop )
+                        return;
+                    if ( _queue.empty() )
+                        break;
+                    batch.reset( _queue.front() );
+                    _queue.pop_front();
+                    _cond.notify_all();
+                }
+
+                killCurrentOp.checkForInterrupt( false );
+
+                Timer t;
+                for ( unsigned i = 0; i < batch->size(); i++ )
+                    mapper->map( (*batch)[i] );
+                w.mapMicros += t.micros();
+
+                state.checkSize();
+                if ( _handBack && state.inMemorySize() >= 1024 * 100 ) {
+                    InMemory * t = state.takeInMemory();
+                    scoped_lock lk( _m );
+                    _handedBack.push_back( t );
+                    _cond.notify_all();
+                }
+            }
+
+            state.reduceInMemory();
+
+            scoped_lock lk( _m );
+            w.numEmits = state.numEmits();
+            w.table = state.takeInMemory();
+            w.mapped = true;
+            _cond.notify_all();
+        }
+
+        void MapThreads::_merge( unsigned i , State& state ) {
+            {
+                scoped_lock lk( _m );
+                while ( ! _merging && ! _stop )
+                    _cond.wait( lk.boost() );
+                if ( _stop )
+                    return;
+            }
+
+            // keys in [ _splits[i-1] , _splits[i] ), the tables are only read from here on
+            if ( i <= _splits.size() ) {
+                for ( unsigned j = 0; j < _workers.size(); j++ ) {
+                    InMemory& table = *_workers[j].table;
+                    InMemory::iterator k = i == 0 ? table.begin() : table.lower_bound( _splits[i-1] );
+                    InMemory::iterator end = i == _splits.size() ? table.end() : table.lower_bound( _splits[i] );
+                    for ( ; k != end; ++k )
+                        state.addTuples( k->second );
+                }
+                state.reduceInMemory();
+            }
+
+            scoped_lock lk( _m );
+            _workers[i].range = state.takeInMemory();
+            _workers[i].merged = true;
+            _cond.notify_all();
+        }
+
         /**
          * This class represents a map/reduce command executed on a single server
          */
@@ -822,6 +1387,13 @@ namespace mongo {
                     wassert( config.limit < 0x4000000 ); // see case on next line to 32 bit unsigned
                     ProgressMeterHolder pm( op->setMessage( "m/r: (1/3) emit phase" , state.incomingDocuments() ) );
                     long long mapTime = 0;
+
+                    // with threads the documents are mapped elsewhere, this thread just scans
+                    scoped_ptr<MapThreads> mapThreads;
+                    if ( config.threads > 1 )
+                        mapThreads.reset( new MapThreads( dbname , cmd , config.threads , state.isOnDisk() ) );
+                    BSONList batch;
+
                     {
                         readlock lock( config.ns );
                         Client::Context ctx( config.ns );
@@ -858,14 +1430,23 @@ namespace mongo {
                                 continue;
 
                             // do map
-                            if ( config.verbose ) mt.reset();
-                            config.mapper->map( o );
-                            if ( config.verbose ) mapTime += mt.micros();
+                            if ( mapThreads ) {
+                                batch.push_back( o.getOwned() );
+                                if ( batch.size() >= 1000 )
+                                    mapThreads->add( batch );
+                            }
+                            else {
+                                if ( config.verbose ) mt.reset();
+                                config.mapper->map( o );
+                                if ( config.verbose ) mapTime += mt.micros();
+                            }
 
                             num++;
                             if ( num % 100 == 0 ) {
                                 // try to yield lock regularly
                                 ClientCursor::YieldLock yield (cursor.get());
+                                if ( mapThreads )
+                                    mapThreads->waitForRoom( state );
                                 Timer t;
                                 // check if map needs to be dumped to disk
                                 state.checkSize();
@@ -884,13 +1465,20 @@ namespace mongo {
                                 break;
                         }
                     }
+
+                    if ( mapThreads ) {
+                        mapThreads->add( batch );
+                        mapThreads->finish( state );
+                        mapTime = mapThreads->mapMicros();
+                    }
                     pm.finished();
 
                     killCurrentOp.checkForInterrupt();
                     // update counters
                     countsBuilder.appendNumber( "input" , num );
-                    countsBuilder.appendNumber( "emit" , state.numEmits() );
-                    if ( state.numEmits() )
+                    long long numEmits = state.numEmits() + ( mapThreads ? mapThreads->numEmits() : 0 );
+                    countsBuilder.appendNumber( "emit" , numEmits );
+                    if ( numEmits )
                         shouldHaveData = true;
 
                     timingBuilder.append( "mapTime" , mapTime / 1000 );
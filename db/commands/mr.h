@@ -128,6 +128,114 @@ namespace mongo {
 
         };
 
+        // ------------  native implementations -----------
+
+        /**
+         * a reduce declared in bson rather than js, run in C++ without the js engine:
+         *   { <field> : { <op> : <path or number> } , ... }
+         * op is $sum, $min, $max or $avg.  paths are dotted field names in the input object,
+         * numbers are constants, so { n : { $sum : 1 } } counts.
+         *
+         * map/reduce runs its reduce over its own output, so there each path must name the
+         * field it is reduced into, $avg is not allowed, and { <op> : 1 } reduces values that
+         * aren't objects.
+         */
+        class NativeReduceSpec {
+        public:
+            enum Op { Sum , Min , Max , Avg };
+
+            struct Accumulator {
+                string field;     // output field, empty when reducing plain values
+                Op op;
+                string path;      // input field, empty if constant
+                BSONObj constant; // wrapped
+            };
+
+            /** @param forMapReduce check the output can be reduced again */
+            NativeReduceSpec( const BSONObj& spec , bool forMapReduce );
+
+            /** reducing plain values rather than objects */
+            bool scalar() const { return _accs[0].field.empty(); }
+
+            bool hasAvg() const;
+
+            const vector<Accumulator>& accumulators() const { return _accs; }
+
+        private:
+            vector<Accumulator> _accs;
+        };
+
+        /** the running result of a NativeReduceSpec for one key */
+        class NativeReduceState {
+        public:
+            NativeReduceState( const NativeReduceSpec& spec );
+
+            /** reduces an input object: a document for group, an emitted value for map/reduce */
+            void add( const BSONObj& in );
+
+            /** reduces a plain value */
+            void addValue( const BSONElement& v );
+
+            /** folds in the output of another state for the same spec */
+            void merge( const BSONObj& out );
+
+            /** appends the output fields */
+            void append( BSONObjBuilder& b ) const;
+
+            /** appends the plain value as name */
+            void appendValue( BSONObjBuilder& b , const StringData& name ) const;
+
+        private:
+            struct Value {
+                Value() : n( 0 ) , l( 0 ) , d( 0 ) , isDouble( false ) {}
+                long long n;   // numbers seen, for $avg
+                long long l;   // sum of integers
+                double d;      // sum of doubles
+                bool isDouble;
+                BSONObj best;  // $min/$max so far, wrapped
+            };
+
+            void _add( Value& v , NativeReduceSpec::Op op , const BSONElement& e );
+            void _append( const Value& v , NativeReduceSpec::Op op , BSONObjBuilder& b , const StringData& name ) const;
+
+            const NativeReduceSpec * _spec;
+            vector<Value> _values;
+        };
+
+        /**
+         * a map declared in bson: { key : <expr> , value : <expr> }
+         * an expr is "$<path>" for a field of the document, an object of exprs, or a constant
+         */
+        class NativeMapper : public Mapper {
+        public:
+            NativeMapper( const BSONObj& spec );
+            virtual void init( State * state ) { _state = state; }
+            virtual void map( const BSONObj& o );
+
+        private:
+            static void _append( BSONObjBuilder& b , const StringData& name , const BSONElement& expr , const BSONObj& doc );
+
+            BSONObj _spec;
+            BSONElement _key;
+            BSONElement _value;
+            State * _state;
+        };
+
+        class NativeReducer : public Reducer {
+        public:
+            NativeReducer( const BSONObj& spec ) : _spec( spec , true ) {}
+            virtual void init( State * state ) {}
+
+            virtual BSONObj reduce( const BSONList& tuples );
+            virtual BSONObj finalReduce( const BSONList& tuples , Finalizer * finalizer );
+
+        private:
+            /** reduces the values of tuples into b as name */
+            void _reduce( const BSONList& tuples , BSONObjBuilder& b , const StringData& name );
+
+            NativeReduceSpec _spec;
+        };
+
         // -----------------
 
 
@@ -169,6 +277,12 @@ namespace mongo {
             BSONObj mapParams;
             BSONObj scopeSetup;
 
+            // false when map, reduce and finalize are all native
+            bool usesJS;
+
+            // threads running the map stage, see MapThreads
+            int threads;
+
             // output tables
             string incLong;
             string tempLong;
@@ -256,7 +370,7 @@ namespace mongo {
 
             // ------ simple accessors -----
 
-            /** State maintains ownership, do no use past State lifetime */
+            /** State maintains ownership, do no use past State lifetime.  null if ! usesJS */
             Scope* scope() { return _scope.get(); }
 
             const Config& config() { return _config; }
@@ -265,6 +379,15 @@ namespace mongo {
 
             long long numEmits() const { return _numEmits; }
 
+            /** bytes in the in memory map */
+            long inMemorySize() const { return _size; }
+
+            /** adds tuples to the in memory map without counting them as emits */
+            void addTuples( const BSONList& tuples );
+
+            /** hands the in memory map over to the caller, leaving an empty one */
+            InMemory * takeInMemory();
+
         protected:
 
             void _insertToInc( BSONObj& o );
@@ -285,6 +408,93 @@ namespace mongo {
 
         BSONObj fast_emit( const BSONObj& args );
 
+        /**
+         * runs the map stage on several threads, each with its own Config, State and js scope.
+         * the thread scanning the collection keeps the db lock and feeds them batches of
+         * documents; they never touch the database.
+         *
+         * when the input is done each thread reduces its own table, then the keys are split into
+         * ranges and each thread reduces one range across all the tables, so the merge runs in
+         * parallel too.  for an on disk output, tables that get big during the map stage are
+         * handed back to the scanning thread to go through State::checkSize.
+         */
+        class MapThreads : boost::noncopyable {
+        public:
+            MapThreads( const string& dbname , const BSONObj& cmdObj , int n , bool handBack );
+
+            /** stops and joins the threads */
+            ~MapThreads();
+
+            /** queues a batch of owned documents, leaving batch empty */
+            void add( BSONList& batch );
+
+            /**
+             * blocks until the queue has room, meanwhile moving tables handed back into state.
+             * call with the db lock released.
+             */
+            void waitForRoom( State& state );
+
+            /**
+             * ends the input and waits for the threads to reduce their tables, then has them
+             * reduce by key range and adds the result to state.  call without the db lock.
+             */
+            void finish( State& state );
+
+            long long numEmits() const { return _numEmits; }
+            long long mapMicros() const { return _mapMicros; }
+
+        private:
+            struct Worker {
+                Worker() : table( 0 ) , range( 0 ) , mapped( false ) , merged( false ) , numEmits( 0 ) , mapMicros( 0 ) {}
+                InMemory * table; // reduced, after the map stage
+                InMemory * range; // the keys in its range reduced across all tables
+                bool mapped;
+                bool merged;
+                long long numEmits;
+                long long mapMicros;
+                AtomicUInt opNum; // of the thread's own CurOp, 0 until it starts
+            };
+
+            void _run( unsigned i );
+            void _map( Worker& w , State& state );
+            void _merge( unsigned i , State& state );
+
+            /**
+             * moves tables handed back into state, first waiting a little for the threads if
+             * ready is false.  rethrows a thread's error, checks for interrupts.
+             * @return ready, checked under the lock
+             */
+            bool _poll( State& state , bool (MapThreads::*ready)() const );
+
+            /** the workers have their own ops, so a kill of ours has to be passed on */
+            void _killWorkers();
+            bool _hasRoom() const;
+            bool _allMapped() const;
+            bool _allMerged() const;
+
+            void _split();
+
+            const string _dbname;
+            const BSONObj _cmd;
+            const bool _handBack;
+            const unsigned _maxQueued;
+
+            mongo::mutex _m;
+            boost::condition _cond;
+            vector<Worker> _workers;
+            vector<boost::thread*> _threads;
+            list<BSONList*> _queue;
+            list<InMemory*> _handedBack;
+            vector<BSONObj> _splits;
+            bool _inputDone;
+            bool _merging;
+            bool _stop;
+            string _error;
+
+            long long _numEmits;
+            long long _mapMicros;
+        };
+
     } // end mr namespace
 }
 
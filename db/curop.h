@@ -153,8 +153,9 @@ namespace mongo {
 
         void leave( Client::Context * context ) {
             unsigned long long now = curTimeMicros64();
-            Top::global.record( _ns , _op , _lockType , now - _checkpoint , _command );
+            Top::global.record( _ns , _op , _lockType , now - _checkpoint , _command , _pendingLockWaitMicros );
             _checkpoint = now;
+            _pendingLockWaitMicros = 0;
         }
 
         void reset() {
@@ -177,12 +178,18 @@ namespace mongo {
 
         void waitingForLock( int type ) {
             _waitingForLock = true;
+            _lockWaitStart = curTimeMicros64();
             if ( type > 0 )
                 _lockType = 1;
             else
                 _lockType = -1;
         }
-        void gotLock()             { _waitingForLock = false; }
+        void gotLock() {
+            _waitingForLock = false;
+            long long w = curTimeMicros64() - _lockWaitStart;
+            _timeAcquiringMicros[ _lockType > 0 ? 1 : 0 ] += w;
+            _pendingLockWaitMicros += w;
+        }
         OpDebug& debug()           { return _debug; }
         int profileLevel() const   { return _dbprofile; }
         const char * getNS() const { return _ns; }
@@ -201,6 +208,8 @@ namespace mongo {
 
         int getLockType() const { return _lockType; }
         bool isWaitingForLock() const { return _waitingForLock; }
+        /** micros spent waiting to acquire dbMutex by this op. type < 0 for read, > 0 for write */
+        long long timeAcquiringMicros( int type ) const { return _timeAcquiringMicros[ type > 0 ? 1 : 0 ]; }
         int getOp() const { return _op; }
 
         /** micros */
@@ -285,6 +294,9 @@ namespace mongo {
         bool _command;
         int _lockType; // see concurrency.h for values
         bool _waitingForLock;
+        unsigned long long _lockWaitStart;
+        long long _timeAcquiringMicros[2]; // [0] read, [1] write
+        long long _pendingLockWaitMicros; // not yet reported to Top
         int _dbprofile; // 0=off, 1=slow, 2=all
         AtomicUInt _opNum;
         char _ns[Namespace::MaxNsLen+2];
@@ -301,6 +313,9 @@ namespace mongo {
             _dbprofile = 0;
             _end = 0;
             _waitingForLock = false;
+            _lockWaitStart = 0;
+            _timeAcquiringMicros[0] = _timeAcquiringMicros[1] = 0;
+            _pendingLockWaitMicros = 0;
             _message = "";
             _progressMeter.finished();
             _killed = false;
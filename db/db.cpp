@@ -685,6 +685,7 @@ int main(int argc, char* argv[]) {
 
     rs_options.add_options()
     ("replSet", po::value<string>(), "arg is <setname>[/<optionalseedhostlist>]")
+    ("initialSyncThreads", po::value<int>(), "number of collections cloned at once during initial sync (default 4)")
     ;
 
     sharding_options.add_options()
@@ -903,6 +904,14 @@ int main(int argc, char* argv[]) {
             /* seed list of hosts for the repl set */
             cmdLine._replSet = params["replSet"].as<string>().c_str();
         }
+        if (params.count("initialSyncThreads")) {
+            int n = params["initialSyncThreads"].as<int>();
+            if ( n < 1 || n > 64 ) {
+                out() << "--initialSyncThreads must be between 1 and 64" << endl;
+                dbexit( EXIT_BADOPTIONS );
+            }
+            replSettings.initialSyncThreads = n;
+        }
         if (params.count("only")) {
             cmdLine.only = params["only"].as<string>().c_str();
         }
@@ -36,6 +36,7 @@
 #include "lasterror.h"
 #include "security.h"
 #include "queryoptimizer.h"
+#include "plancache.h"
 #include "../scripting/engine.h"
 #include "stats/counters.h"
 #include "background.h"
@@ -387,6 +388,12 @@ namespace mongo {
 
                 result.append( "globalLock" , t.obj() );
             }
+
+            {
+                BSONObjBuilder t( result.subobjStart( "locks" ) );
+                Top::global.appendLockStats( t );
+                t.done();
+            }
             timeBuilder.appendNumber( "after basic" , Listener::getElapsedTimeMillis() - start );
 
             {
@@ -1212,6 +1219,15 @@ namespace mongo {
             result.append( "lastExtentSize" , nsd->lastExtentSize / scale );
             result.append( "paddingFactor" , nsd->paddingFactor );
             result.append( "flags" , nsd->flags );
+            result.appendBool( "usePowerOf2Sizes" , nsd->isFlagSet( NamespaceDetails::Flag_UsePowerOf2Sizes ) );
+
+            // free space on the deleted lists; large relative to storageSize means fragmentation
+            long long deletedCount, deletedSize;
+            bool deletedComplete = nsd->deletedStats( &deletedCount , &deletedSize , 1000 );
+            result.appendNumber( "deletedCount" , deletedCount );
+            result.appendNumber( "deletedSize" , deletedSize / scale );
+            if ( ! deletedComplete )
+                result.appendBool( "deletedStatsPartial" , true );
 
             BSONObjBuilder indexSizes;
             result.appendNumber( "totalIndexSize" , getIndexSizeForCollection(dbname, ns, &indexSizes, scale) / scale );
@@ -1229,6 +1245,27 @@ namespace mongo {
         }
     } cmdCollectionStatis;
 
+    class PlanCacheStats : public Command {
+    public:
+        PlanCacheStats() : Command( "planCacheStats" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream &help ) const {
+            help << "{ planCacheStats:\"posts\" } the query plans recorded for a collection, and how they have done\n"
+                 << "{ planCacheStats:1 } just the totals for all collections";
+        }
+        bool run(const string& dbname, BSONObj& jsobj, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            BSONElement e = jsobj.firstElement();
+            if ( e.type() == String )
+                QueryPlanCache::get().appendStats( dbname + "." + e.valuestr() , result );
+
+            BSONObjBuilder b( result.subobjStart( "cache" ) );
+            QueryPlanCache::get().appendSummary( b );
+            b.done();
+            return true;
+        }
+    } cmdPlanCacheStats;
+
     class DBStats : public Command {
     public:
         DBStats() : Command( "dbStats", false, "dbstats" ) {}
@@ -1404,6 +1441,53 @@ namespace mongo {
         }
     } cmdConvertToCapped;
 
+    /* { collMod : <collection> , usePowerOf2Sizes : <bool> } */
+    class CmdCollMod : public Command {
+    public:
+        CmdCollMod() : Command( "collMod" ) {}
+        virtual bool slaveOk() const { return false; }
+        virtual LockType locktype() const { return WRITE; }
+        virtual bool logTheOp() { return true; }
+        virtual void help( stringstream &help ) const {
+            help << "Sets collection options.\n"
+                 "Example: { collMod: 'foo', usePowerOf2Sizes: true }";
+        }
+        bool run(const string& dbname, BSONObj& jsobj, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            string ns = dbname + "." + jsobj.firstElement().valuestr();
+            Client::Context ctx( ns );
+            NamespaceDetails *nsd = nsdetails( ns.c_str() );
+            if ( ! nsd ) {
+                errmsg = "ns does not exist";
+                return false;
+            }
+
+            bool ok = true;
+            BSONObjIterator i( jsobj );
+            i.next(); // collMod
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                if ( str::equals( "usePowerOf2Sizes" , e.fieldName() ) ) {
+                    if ( nsd->capped ) {
+                        errmsg = "can't use usePowerOf2Sizes with a capped collection";
+                        ok = false;
+                        continue;
+                    }
+                    result.appendBool( "usePowerOf2Sizes_old" , nsd->isFlagSet( NamespaceDetails::Flag_UsePowerOf2Sizes ) );
+                    if ( e.trueValue() )
+                        nsd->setFlag( NamespaceDetails::Flag_UsePowerOf2Sizes );
+                    else
+                        nsd->clearFlag( NamespaceDetails::Flag_UsePowerOf2Sizes );
+                    result.appendBool( "usePowerOf2Sizes_new" , e.trueValue() );
+                }
+                else {
+                    errmsg = str::stream() << "unknown option to collMod: " << e.fieldName();
+                    ok = false;
+                }
+            }
+            return ok;
+        }
+    } cmdCollMod;
+
     /* Find and Modify an object returning either the old (default) or new value*/
     class CmdFindAndModify : public Command {
     public:
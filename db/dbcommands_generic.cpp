@@ -86,6 +86,8 @@ namespace mongo {
             help << "  notablescan\n";
             help << "  logLevel\n";
             help << "  syncdelay\n";
+            help << "  rangeDeleteYieldMillis\n";
+            help << "  rangeDeleteMBPerSec\n";
             help << "{ getParameter:'*' } to get everything\n";
         }
         bool run(const string& dbname, BSONObj& cmdObj, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
@@ -108,6 +110,12 @@ namespace mongo {
             if( all || cmdObj.hasElement("replApplyBatchSize") ) {
                 result.append("replApplyBatchSize", replApplyBatchSize);
             }
+            if( all || cmdObj.hasElement("rangeDeleteYieldMillis") ) {
+                result.append("rangeDeleteYieldMillis", cmdLine.rangeDeleteYieldMillis);
+            }
+            if( all || cmdObj.hasElement("rangeDeleteMBPerSec") ) {
+                result.append("rangeDeleteMBPerSec", cmdLine.rangeDeleteMBPerSec);
+            }
 
             if ( before == result.len() ) {
                 errmsg = "no option found to get";
@@ -130,6 +138,8 @@ namespace mongo {
             help << "  notablescan\n";
             help << "  logLevel\n";
             help << "  quiet\n";
+            help << "  rangeDeleteYieldMillis\n";
+            help << "  rangeDeleteMBPerSec\n";
         }
         bool run(const string& dbname, BSONObj& cmdObj, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
             int s = 0;
@@ -163,6 +173,26 @@ namespace mongo {
                 replApplyBatchSize = e.numberInt();
                 s++;
             }
+            if( cmdObj.hasElement( "rangeDeleteYieldMillis" ) ) {
+                int n = cmdObj["rangeDeleteYieldMillis"].numberInt();
+                if ( n < 0 ) {
+                    errmsg = "rangeDeleteYieldMillis has to be >= 0";
+                    return false;
+                }
+                result.append("was", cmdLine.rangeDeleteYieldMillis );
+                cmdLine.rangeDeleteYieldMillis = n;
+                s++;
+            }
+            if( cmdObj.hasElement( "rangeDeleteMBPerSec" ) ) {
+                int n = cmdObj["rangeDeleteMBPerSec"].numberInt();
+                if ( n < 0 ) {
+                    errmsg = "rangeDeleteMBPerSec has to be >= 0";
+                    return false;
+                }
+                result.append("was", cmdLine.rangeDeleteMBPerSec );
+                cmdLine.rangeDeleteMBPerSec = n;
+                s++;
+            }
 
             if( s == 0 ) {
                 errmsg = "no option found to set, use '*' to get all ";
@@ -234,7 +234,8 @@ namespace mongo {
         return me.obj();
     }
 
-    long long Helpers::removeRange( const string& ns , const BSONObj& min , const BSONObj& max , bool yield , bool maxInclusive , RemoveCallback * callback ) {
+    long long Helpers::removeRange( const string& ns , const BSONObj& min , const BSONObj& max , bool yield , bool maxInclusive ,
+                                    RemoveCallback * callback , RemoveRangeThrottle * throttle ) {
         BSONObj keya , keyb;
         BSONObj minClean = toKeyFormat( min , keya );
         BSONObj maxClean = toKeyFormat( max , keyb );
@@ -249,37 +250,85 @@ namespace mongo {
         assert( ii >= 0 );
 
         long long num = 0;
+        long long bytes = 0;
+        Timer total;
+        Timer sinceYield;
 
         IndexDetails& i = nsd->idx( ii );
 
-        shared_ptr<Cursor> c( new BtreeCursor( nsd , ii , i , minClean , maxClean , maxInclusive, 1 ) );
+        BtreeCursor * bc = new BtreeCursor( nsd , ii , i , minClean , maxClean , maxInclusive, 1 );
+        shared_ptr<Cursor> c( bc );
         auto_ptr<ClientCursor> cc( new ClientCursor( QueryOption_NoCursorTimeout , c , ns ) );
         cc->setDoingDeletes( true );
 
+        vector<DiskLoc> run;
         while ( c->ok() ) {
-            DiskLoc rloc = c->currLoc();
-
-            if ( callback )
-                callback->goingToDelete( c->current() );
-
-            c->advance();
+            // the keys left in the range in the cursor's bucket are next to each other, so in a
+            // leaf they come out of the shard key index together, with one rebalance, rather
+            // than a search from the root and a rebalance for each.  other indexes are unindexed
+            // by key as usual
+            const DiskLoc bucket = bc->getBucket();
+            const int from = bc->getKeyOfs();
+            int to = from;
+            run.clear();
+            while ( c->ok() && bc->getBucket() == bucket && run.size() < 100 ) {
+                run.push_back( c->currLoc() );
+                to = bc->getKeyOfs() + 1;
+                c->advance();
+            }
             c->noteLocation();
 
-            logOp( "d" , ns.c_str() , rloc.obj()["_id"].wrap() );
-            theDataFileMgr.deleteRecord(ns.c_str() , rloc.rec(), rloc);
-            num++;
+            const bool leaf = bucket.btree()->isLeaf();
+            for ( vector<DiskLoc>::iterator j = run.begin(); j != run.end(); ++j ) {
+                DiskLoc rloc = *j;
+                if ( callback )
+                    callback->goingToDelete( rloc.obj() );
+
+                logOp( "d" , ns.c_str() , rloc.obj()["_id"].wrap() );
+                bytes += rloc.rec()->netLength();
+                theDataFileMgr.deleteRecord( ns.c_str() , rloc.rec() , rloc , false , false , leaf ? ii : -1 );
+                num++;
+            }
+            if ( leaf ) {
+                // any unused keys between the ones we saw are dead markers and go too
+                bucket.btree()->delLeafKeys( bucket , i , from , to );
+            }
 
             c->checkLocation();
 
             getDur().commitIfNeeded();
 
-            if ( yield && ! cc->yieldSometimes() ) {
+            if ( ! yield )
+                continue;
+
+            int sleepMicros = -1;
+            if ( throttle && throttle->maxBytesPerSec ) {
+                // how far ahead of the allowed rate we are
+                long long ahead = bytes * 1000000 / throttle->maxBytesPerSec - (long long) total.micros();
+                if ( ahead > 0 )
+                    sleepMicros = (int) std::min( ahead , 1000000LL );
+            }
+
+            bool ok;
+            if ( sleepMicros > 0 || ( throttle && throttle->yieldMillis && sinceYield.millis() >= throttle->yieldMillis ) ) {
+                ok = cc->yield( std::max( sleepMicros , 0 ) );
+                sinceYield.reset();
+            }
+            else {
+                ok = cc->yieldSometimes();
+            }
+
+            if ( ! ok ) {
                 // cursor got finished by someone else, so we're done
                 cc.release(); // if the collection/db is dropped, cc may be deleted
                 break;
             }
         }
 
+        if ( throttle ) {
+            throttle->bytes = bytes;
+            throttle->millis = total.millis();
+        }
         return num;
     }
 
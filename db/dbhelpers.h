@@ -109,8 +109,18 @@ namespace mongo {
             virtual ~RemoveCallback() {}
             virtual void goingToDelete( const BSONObj& o ) = 0;
         };
+        /* how hard a removeRange that yields may lean on the lock, and what it did */
+        struct RemoveRangeThrottle {
+            RemoveRangeThrottle() : yieldMillis(0), maxBytesPerSec(0), bytes(0), millis(0) { }
+            int yieldMillis;          // yield after deleting this long even if no one is waiting.  0 means only yield for waiters
+            long long maxBytesPerSec; // sleep while yielded so we delete no faster than this.  0 means no limit
+            long long bytes;          // out: size of the documents deleted
+            long long millis;         // out: time taken, including yields
+        };
+
         /* removeRange: operation is oplog'd */
-        static long long removeRange( const string& ns , const BSONObj& min , const BSONObj& max , bool yield = false , bool maxInclusive = false , RemoveCallback * callback = 0 );
+        static long long removeRange( const string& ns , const BSONObj& min , const BSONObj& max , bool yield = false , bool maxInclusive = false ,
+                                      RemoveCallback * callback = 0 , RemoveRangeThrottle * throttle = 0 );
 
         /* Remove all objects from a collection.
         You do not need to set the database before calling.
@@ -23,12 +23,14 @@
        we will build an output buffer ourself and then use O_DIRECT
        we could be in read lock for this
        for very large objects write directly to redo log in situ?
+       the section is then compressed (on several threads if big); the compressed form is what is journaled
      WRITETOJOURNAL
        we could be unlocked (the main db lock that is...) for this, with sufficient care, but there is some complexity
          have to handle falling behind which would use too much ram (going back into a read lock would suffice to stop that).
          for now (1.7.5/1.8.0) we are in read lock which is not ideal.
      WRITETODATAFILES
        apply the writes back to the non-private MMF after they are for certain in redo log
+       big sections are split by data file across worker threads
      REMAPPRIVATEVIEW
        we could in a write lock quickly flip readers back to the main view, then stay in read lock and do our real
          remapping. with many files (e.g., 1000), remapping could be time consuming (several ms), so we don't want
@@ -68,6 +70,11 @@ namespace mongo {
 
         CommitJob commitJob;
 
+        ThreadPool& durThreadPool() {
+            static ThreadPool *p = new ThreadPool(DurWorkerThreads); // never freed, see RecoveryJob::_instance
+            return *p;
+        }
+
         Stats stats;
 
         void Stats::S::reset() {
@@ -86,8 +93,12 @@ namespace mongo {
         }
                         string _CSVHeader();
 
+        double Stats::S::compressionRatio() const {
+            return _journaledBytes ? _uncompressedBytes / (double) _journaledBytes : 0;
+        }
+
         string Stats::S::_CSVHeader() { 
-            return "commits\tjournaledMB\twriteToDataFilesMB\tcommitsInWriteLock\tearlyCommits\tprepLogBuffer\twriteToJournal\twriteToDataFiles\tremapPrivateView";
+            return "commits\tjournaledMB\tcompression\twriteToDataFilesMB\tcommitsInWriteLock\tearlyCommits\tprepLogBuffer\twriteToJournal\twriteToDataFiles\tremapPrivateView";
         }
 
         string Stats::S::_asCSV() { 
@@ -95,6 +106,7 @@ namespace mongo {
             ss << 
                 _commits << '\t' << 
                 _journaledBytes / 1000000.0 << '\t' << 
+                compressionRatio() << '\t' << 
                 _writeToDataFilesBytes / 1000000.0 << '\t' << 
                 _commitsInWriteLock << '\t' << 
                 _earlyCommits <<  '\t' << 
@@ -109,6 +121,7 @@ namespace mongo {
             return BSON(
                        "commits" << _commits <<
                        "journaledMB" << _journaledBytes / 1000000.0 <<
+                       "compression" << compressionRatio() <<
                        "writeToDataFilesMB" << _writeToDataFilesBytes / 1000000.0 <<
                        "commitsInWriteLock" << _commitsInWriteLock <<
                        "earlyCommits" << _earlyCommits << 
@@ -466,7 +479,7 @@ namespace mongo {
             // todo : write to the journal outside locks, as this write can be slow.
             //        however, be careful then about remapprivateview as that cannot be done 
             //        if new writes are then pending in the private maps.
-            WRITETOJOURNAL(commitJob._ab);
+            WRITETOJOURNAL(commitJob._abCompressed);
 
             // data is now in the journal, which is sufficient for acknowledging getLastError.
             // (ok to crash after that)
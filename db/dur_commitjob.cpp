@@ -135,7 +135,7 @@ namespace mongo {
             _nSinceCommitIfNeededCall = 0;
         }
 
-        CommitJob::CommitJob() : _ab(4 * 1024 * 1024) , _hasWritten(false), 
+        CommitJob::CommitJob() : _ab(4 * 1024 * 1024) , _abCompressed(1024 * 1024) , _hasWritten(false), 
             _bytes(0), _nSinceCommitIfNeededCall(0) { }
 
         void CommitJob::note(void* p, int len) {
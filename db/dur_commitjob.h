@@ -22,6 +22,7 @@
 #include "../util/alignedbuilder.h"
 #include "../util/mongoutils/hash.h"
 #include "../util/concurrency/synchronization.h"
+#include "../util/concurrency/thread_pool.h"
 #include "cmdline.h"
 #include "durop.h"
 #include "dur.h"
@@ -160,7 +161,8 @@ namespace mongo {
         */
         class CommitJob : boost::noncopyable {
         public:
-            AlignedBuilder _ab; // for direct i/o writes to journal
+            AlignedBuilder _ab; // the section as built by PREPLOGBUFFER; WRITETODATAFILES applies it from here
+            AlignedBuilder _abCompressed; // _ab compressed; this is what goes to the journal, via direct i/o
 
             CommitJob();
 
@@ -217,5 +219,11 @@ namespace mongo {
 
         extern CommitJob commitJob;
 
+        /** worker threads for the cpu bound parts of a big group commit: compressing the journal
+            section and WRITETODATAFILES.  only the group commit uses it and it joins before moving on.
+        */
+        const int DurWorkerThreads = 4;
+        ThreadPool& durThreadPool();
+
     }
 }
@@ -34,7 +34,8 @@ namespace mongo {
 
             // x4142 is asci--readable if you look at the file with head/less -- thus the starting values were near
             // that.  simply incrementing the version # is safe on a fwd basis.
-            enum { CurrentVersion = 0x4148 };
+            // 0x4149 : section bodies are compressed, see JSectHeader.  we can still recover 0x4148 files.
+            enum { CurrentVersion = 0x4149, UncompressedVersion = 0x4148 };
             unsigned short _version;
 
             // these are just for diagnostic ease (make header more useful as plain text)
@@ -49,12 +50,19 @@ namespace mongo {
             char reserved3[8026]; // 8KB total for the file header
             char txt2[2];         // "\n\n" at the end
 
-            bool versionOk() const { return _version == CurrentVersion; }
+            bool versionOk() const { return _version == CurrentVersion || _version == UncompressedVersion; }
+            bool compressed() const { return _version == CurrentVersion; }
             bool valid() const { return magic[0] == 'j' && txt2[1] == '\n' && fileId; }
         };
 
         /** "Section" header.  A section corresponds to a group commit.
             len is length of the entire section including header and footer.
+
+            In a compressed journal file (JHeader::compressed()) the header is followed by an unsigned
+            compressed length and then the compress()ed bytes of everything that came after the header
+            in the uncompressed section, through the JSectFooter.  len is then the length on disk.  The
+            footer hash is over the uncompressed section, whose header len is that of the uncompressed
+            section rounded up to Alignment.
         */
         struct JSectHeader {
             unsigned len;                  // length in bytes of the whole section
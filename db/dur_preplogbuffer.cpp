@@ -33,6 +33,7 @@
 #include "../util/mongoutils/hash.h"
 #include "../util/mongoutils/str.h"
 #include "../util/alignedbuilder.h"
+#include "../util/compress.h"
 #include "../util/timer.h"
 #include "dur_stats.h"
 
@@ -135,8 +136,9 @@ namespace mongo {
         /** we will build an output buffer ourself and then use O_DIRECT
             we could be in read lock for this
             caller handles locking
+            @return length of the section through its footer, that is without the padding
         */
-        void _PREPLOGBUFFER() {
+        unsigned _PREPLOGBUFFER() {
             assert( cmdLine.dur );
 
             {
@@ -179,12 +181,42 @@ namespace mongo {
                 dassert( bb.len() % Alignment == 0 );
             }
 
-            return;
+            return lenWillBe;
         }
+
+        /** build commitJob._abCompressed, the on disk form of the section in commitJob._ab.
+            see JSectHeader for the layout.
+            @param len length of the uncompressed section through its footer
+        */
+        static void _COMPRESSLOGBUFFER(unsigned len) {
+            static string compressed; // only the group commit uses this, under groupCommitMutex
+
+            const AlignedBuilder& bb = commitJob._ab;
+            const unsigned bodyLen = len - sizeof(JSectHeader);
+            if( bodyLen > 1024 * 1024 )
+                compress(bb.buf() + sizeof(JSectHeader), bodyLen, &compressed, durThreadPool());
+            else
+                compress(bb.buf() + sizeof(JSectHeader), bodyLen, &compressed);
+
+            AlignedBuilder& cb = commitJob._abCompressed;
+            cb.reset();
+            cb.appendBuf(bb.buf(), sizeof(JSectHeader));
+            cb.appendNum((unsigned) compressed.size());
+            cb.appendBuf(compressed.data(), compressed.size());
+
+            unsigned L = (cb.len() + Alignment-1) & (~(Alignment-1));
+            ((JSectHeader*) cb.atOfs(0))->len = L;
+            cb.skip(L - cb.len());
+            dassert( cb.len() % Alignment == 0 );
+
+            stats.curr->_uncompressedBytes += bb.len();
+        }
+
         void PREPLOGBUFFER() {
             Timer t;
             j.assureLogFileOpen(); // so fileId is set
-            _PREPLOGBUFFER();
+            unsigned len = _PREPLOGBUFFER();
+            _COMPRESSLOGBUFFER(len);
             stats.curr->_prepLogBufferMicros += t.micros();
         }
 
@@ -22,6 +22,7 @@
 #include "dur_recover.h"
 #include "dur_journal.h"
 #include "dur_journalformat.h"
+#include "dur_commitjob.h"
 #include "durop.h"
 #include "namespace.h"
 #include "../util/mongoutils/str.h"
@@ -31,6 +32,8 @@
 #include "db.h"
 #include "../util/unittest.h"
 #include "../util/checksum.h"
+#include "../util/compress.h"
+#include "../util/alignedbuilder.h"
 #include "cmdline.h"
 #include "curop.h"
 #include "mongommf.h"
@@ -58,6 +61,9 @@ namespace mongo {
             shared_ptr<DurOp> op;
         };
 
+        /** below this many bytes of basic writes, WRITETODATAFILES isn't worth handing to other threads */
+        const size_t ParallelWriteMinBytes = 1024 * 1024;
+
         void removeJournalFiles();
         path getJournalDir();
 
@@ -265,6 +271,17 @@ namespace mongo {
         void RecoveryJob::applyEntries(const vector<ParsedJournalEntry> &entries) {
             bool apply = (cmdLine.durOptions & CmdLine::DurScanOnly) == 0;
             bool dump = cmdLine.durOptions & CmdLine::DurDumpJournal;
+
+            if( apply && !dump && !_recovering && entries.size() > 1 ) {
+                size_t bytes = 0;
+                for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i )
+                    bytes += i->e->len;
+                if( bytes >= ParallelWriteMinBytes ) {
+                    applyEntriesParallel(entries);
+                    return;
+                }
+            }
+
             if( dump )
                 log() << "BEGIN section" << endl;
 
@@ -276,6 +293,42 @@ namespace mongo {
                 log() << "END section" << endl;
         }
 
+        void RecoveryJob::writeEntries(const vector<const ParsedJournalEntry*> *entries) {
+            try {
+                for( vector<const ParsedJournalEntry*>::const_iterator i = entries->begin(); i != entries->end(); ++i )
+                    write(**i);
+            }
+            catch(std::exception& e) {
+                log() << "dur exception in WRITETODATAFILES worker " << e.what() << endl;
+                _writeFailures++;
+            }
+        }
+
+        /** WRITETODATAFILES for a big section.  basic writes to different data files touch disjoint
+            memory, so we partition the entries by file and have each worker memcpy a partition.  writes
+            to one file stay in journal order.  outside of recovery a section is only basic writes --
+            JournalSectionIterator doesn't return DurOps then.
+        */
+        void RecoveryJob::applyEntriesParallel(const vector<ParsedJournalEntry> &entries) {
+            vector< vector<const ParsedJournalEntry*> > parts(DurWorkerThreads);
+            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                assert( i->e );
+                unsigned h = i->e->getFileNo();
+                for( const char *p = i->dbName; *p; p++ )
+                    h = h * 31 + *p;
+                parts[h % DurWorkerThreads].push_back(&*i);
+            }
+
+            _writeFailures.zero();
+            ThreadPool& pool = durThreadPool();
+            for( unsigned i = 0; i < parts.size(); i++ ) {
+                if( !parts[i].empty() )
+                    pool.schedule(&RecoveryJob::writeEntries, this, &parts[i]);
+            }
+            pool.join();
+            massert(13655, "dur error applying writes to data files", _writeFailures.get() == 0);
+        }
+
         void RecoveryJob::processSection(const void *p, unsigned len) {
             scoped_lock lk(_mx);
 
@@ -301,6 +354,30 @@ namespace mongo {
             applyEntries(entries);
         }
 
+        /** a section from a compressed journal file.  uncompress it and rebuild the section
+            PREPLOGBUFFER made, then process that.
+        */
+        void RecoveryJob::processCompressedSection(const void *p, unsigned len) {
+            BufReader br(p, len);
+            JSectHeader h;
+            br.read(h);
+            unsigned compressedLen;
+            br.read(compressedLen);
+            const char *compressed = (const char *) br.skip(compressedLen);
+
+            string body;
+            massert(13656, "dur journal section failed to uncompress", uncompress(compressed, compressedLen, &body));
+
+            // the footer hash was computed with the uncompressed section's length in the header
+            const unsigned lenWillBe = sizeof(JSectHeader) + body.size();
+            h.len = (lenWillBe + Alignment-1) & (~(Alignment-1));
+
+            AlignedBuilder b(lenWillBe);
+            b.appendStruct(h);
+            b.appendBuf(body.data(), body.size());
+            processSection(b.buf(), b.len());
+        }
+
         /** apply a specific journal file, that is already mmap'd
             @param p start of the memory mapped file
             @return true if this is detected to be the last file (ends abruptly)
@@ -308,6 +385,7 @@ namespace mongo {
         bool RecoveryJob::processFileBuffer(const void *p, unsigned len) {
             try {
                 unsigned long long fileId;
+                bool compressed;
                 BufReader br(p,len);
 
                 {
@@ -320,6 +398,7 @@ namespace mongo {
                     }
                     uassert(13537, "journal header invalid", h.valid());
                     fileId = h.fileId;
+                    compressed = h.compressed();
                     if(cmdLine.durOptions & CmdLine::DurDumpJournal) { 
                         log() << "JHeader::fileId=" << fileId << endl;
                     }
@@ -336,7 +415,10 @@ namespace mongo {
                         }
                         return true;
                     }
-                    processSection(br.skip(h.len), h.len);
+                    if( compressed )
+                        processCompressedSection(br.skip(h.len), h.len);
+                    else
+                        processSection(br.skip(h.len), h.len);
 
                     // ctrl c check
                     killCurrentOp.checkForInterrupt(false);
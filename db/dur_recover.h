@@ -19,6 +19,7 @@ namespace mongo {
             void go(vector<path>& files);
             ~RecoveryJob();
             void processSection(const void *, unsigned len);
+            void processCompressedSection(const void *, unsigned len);
             void close(); // locks and calls _close()
 
             static RecoveryJob & get() { return _instance; }
@@ -26,6 +27,8 @@ namespace mongo {
             void write(const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const vector<ParsedJournalEntry> &entries);
+            void applyEntriesParallel(const vector<ParsedJournalEntry> &entries);
+            void writeEntries(const vector<const ParsedJournalEntry*> *entries);
             bool processFileBuffer(const void *, unsigned len);
             bool processFile(path journalfile);
             void _close(); // doesn't lock
@@ -38,6 +41,7 @@ namespace mongo {
             mongo::mutex _mx; // protects _mmfs
 
             bool _recovering; // are we in recovery or WRITETODATAFILES
+            AtomicUInt _writeFailures; // from applyEntriesParallel's workers
 
             static RecoveryJob &_instance;
         };
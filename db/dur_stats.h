@@ -16,10 +16,12 @@ namespace mongo {
                 string _asCSV();
                 string _CSVHeader();
                 void reset();
+                double compressionRatio() const;
 
                 unsigned _commits;
                 unsigned _earlyCommits; // count of early commits from commitIfNeeded() or from getDur().commitNow()
                 unsigned long long _journaledBytes;
+                unsigned long long _uncompressedBytes; // what _journaledBytes was before compression
                 unsigned long long _writeToDataFilesBytes;
 
                 unsigned long long _prepLogBufferMicros;
@@ -33,8 +33,8 @@ namespace mongo {
             that which is going to be a remapped on its private view - but that might not be all
             views.
 
-            (2) todo should we do this using N threads?  would be quite easy
-                see Hackenberg paper table 5 and 6.  2 threads might be a good balance.
+            (2) big sections are done using N threads, partitioned by data file.  see
+                RecoveryJob::applyEntriesParallel and Hackenberg paper table 5 and 6.
 
             (3) with enough work, we could do this outside the read lock.  it's a bit tricky though.
                 - we couldn't do it from the private views then as they may be changing.  would have to then
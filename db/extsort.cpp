@@ -32,7 +32,8 @@ namespace mongo {
 
     BSONObjExternalSorter::BSONObjExternalSorter( const BSONObj & order , long maxFileSize )
         : _order( order.getOwned() ) , _maxFilesize( maxFileSize ) ,
-          _arraySize(1000000), _cur(0), _curSizeSoFar(0), _sorted(0) {
+          _arraySize(1000000), _cur(0), _curSizeSoFar(0), _sorted(0) ,
+          _threads(0), _errMutex("BSONObjExternalSorter"), _runsPending(0) {
 
         stringstream rootpath;
         rootpath << dbpath;
@@ -48,6 +49,9 @@ namespace mongo {
     }
 
     BSONObjExternalSorter::~BSONObjExternalSorter() {
+        if ( _pool )
+            _pool->join();
+
         if ( _cur ) {
             delete _cur;
             _cur = 0;
@@ -65,6 +69,16 @@ namespace mongo {
         _cur->sort( BSONObjExternalSorter::extSortComp );
     }
 
+    void BSONObjExternalSorter::useThreads( int n ) {
+        assert( _cur == 0 && n > 0 );
+        _threads = n;
+        _pool.reset( new ThreadPool( n ) );
+        // n runs being sorted and one being filled.  every run preallocates _arraySize
+        // entries, so that has to shrink as well as the byte limit
+        _maxFilesize /= n + 1;
+        _arraySize = max( _arraySize / ( n + 1 ) , 1000 );
+    }
+
     void BSONObjExternalSorter::sort() {
         uassert( 10048 ,  "already sorted" , ! _sorted );
 
@@ -85,6 +99,12 @@ namespace mongo {
             _cur = 0;
         }
 
+        if ( _pool ) {
+            _pool->join();
+            scoped_lock lk( _errMutex );
+            uassert( 13657 , "external sort failed writing a run: " + _err , _err.empty() );
+        }
+
         if ( _files.size() == 0 )
             return;
 
@@ -118,68 +138,218 @@ namespace mongo {
         if ( _cur->size() == 0 )
             return;
 
-        _sortInMem();
-
         stringstream ss;
         ss << _root.string() << "/file." << _files.size();
         string file = ss.str();
+        _files.push_back( file );
+
+        if ( !_pool ) {
+            writeRun( _cur , file , true );
+            _cur->clear();
+            return;
+        }
+
+        {
+            scoped_lock lk( _errMutex );
+            uassert( 13658 , "external sort failed writing a run: " + _err , _err.empty() );
+            // bound the memory held by runs waiting for a thread
+            while ( _runsPending >= _threads ) {
+                boost::xtime xt;
+                boost::xtime_get( &xt , boost::TIME_UTC );
+                xt.nsec += 100 * 1000 * 1000;
+                if ( xt.nsec >= 1000 * 1000 * 1000 ) {
+                    xt.nsec -= 1000 * 1000 * 1000;
+                    xt.sec++;
+                }
+                _runWritten.timed_wait( lk.boost() , xt );
+                killCurrentOp.checkForInterrupt();
+            }
+            _runsPending++;
+        }
+        _pool->schedule( &BSONObjExternalSorter::writeRunThread , this , _cur , file );
+        _cur = 0;
+    }
+
+    void BSONObjExternalSorter::writeRun( InMemory * run , const string& file , bool onClientThread ) {
+        // sort pointers rather than moving the BSONObjs, whose copies touch reference counts
+        vector<Data*> v;
+        v.reserve( run->size() );
+        for ( InMemory::iterator i=run->begin(); i != run->end(); ++i )
+            v.push_back( &*i );
+        std::sort( v.begin() , v.end() , MyCmp( _order , onClientThread ) );
 
         ofstream out;
         out.open( file.c_str() , ios_base::out | ios_base::binary );
         assertStreamGood( 10051 ,  (string)"couldn't open file: " + file , out );
 
-        int num = 0;
-        for ( InMemory::iterator i=_cur->begin(); i != _cur->end(); ++i ) {
-            Data p = *i;
-            out.write( p.first.objdata() , p.first.objsize() );
-            out.write( (char*)(&p.second) , sizeof( DiskLoc ) );
-            num++;
+        for ( vector<Data*>::iterator i = v.begin(); i != v.end(); ++i ) {
+            Data *p = *i;
+            out.write( p->first.objdata() , p->first.objsize() );
+            out.write( (char*)(&p->second) , sizeof( DiskLoc ) );
         }
 
-        _cur->clear();
-
-        _files.push_back( file );
         out.close();
+        assertStreamGood( 10051 ,  (string)"couldn't write file: " + file , out );
 
-        log(2) << "Added file: " << file << " with " << num << "objects for external sort" << endl;
+        log(2) << "Added file: " << file << " with " << v.size() << "objects for external sort" << endl;
+    }
+
+    void BSONObjExternalSorter::writeRunThread( InMemory * run , string file ) {
+        try {
+            writeRun( run , file , false );
+        }
+        catch ( std::exception& e ) {
+            scoped_lock lk( _errMutex );
+            if ( _err.empty() )
+                _err = e.what();
+        }
+        delete run;
+
+        scoped_lock lk( _errMutex );
+        _runsPending--;
+        _runWritten.notify_one();
     }
 
     // ---------------------------------
 
+    namespace {
+        const unsigned MergeBatchSize = 10000;
+        const unsigned MergeBatchesAhead = 4;
+        const int MinusInfinity = -1; // only while building the loser tree
+    }
+
     BSONObjExternalSorter::Iterator::Iterator( BSONObjExternalSorter * sorter ) :
-        _cmp( sorter->_order ) , _in( 0 ) {
+        _cmp( sorter->_order , sorter->_threads == 0 ) , _in( 0 ) ,
+        _m( "BSONObjExternalSorter::Iterator" ) , _mergeDone( false ) , _stop( false ) , _batchPos( 0 ) {
 
         for ( list<string>::iterator i=sorter->_files.begin(); i!=sorter->_files.end(); i++ ) {
             _files.push_back( new FileIterator( *i ) );
-            _stash.push_back( pair<Data,bool>( Data( BSONObj() , DiskLoc() ) , false ) );
         }
 
         if ( _files.size() == 0 && sorter->_cur ) {
             _in = sorter->_cur;
             _it = sorter->_cur->begin();
+            return;
         }
 
+        int k = _files.size();
+        _heads.resize( k );
+        _done.resize( k );
+        _tree.assign( k , MinusInfinity );
+        for ( int i = k - 1; i >= 0; i-- ) {
+            _done[i] = ! _files[i]->more();
+            if ( ! _done[i] )
+                _heads[i] = _files[i]->next();
+            adjust( i );
+        }
 
+        if ( sorter->_threads && k > 0 )
+            _thread.reset( new boost::thread( boost::bind( &Iterator::mergeThread , this ) ) );
     }
 
     BSONObjExternalSorter::Iterator::~Iterator() {
+        if ( _thread ) {
+            {
+                scoped_lock lk( _m );
+                _stop = true;
+                _cond.notify_all();
+            }
+            _thread->join();
+        }
         for ( vector<FileIterator*>::iterator i=_files.begin(); i!=_files.end(); i++ )
             delete *i;
         _files.clear();
     }
 
+    /** exhausted files sort last */
+    bool BSONObjExternalSorter::Iterator::lessFile( int a , int b ) const {
+        if ( a == MinusInfinity )
+            return b != MinusInfinity;
+        if ( b == MinusInfinity || _done[a] )
+            return false;
+        if ( _done[b] )
+            return true;
+        return _cmp( _heads[a] , _heads[b] );
+    }
+
+    /** replay the matches on the path from a file whose head changed up to the root */
+    void BSONObjExternalSorter::Iterator::adjust( int file ) {
+        int k = _tree.size();
+        int winner = file;
+        for ( int t = ( file + k ) / 2; t > 0; t /= 2 ) {
+            if ( lessFile( _tree[t] , winner ) )
+                swap( _tree[t] , winner );
+        }
+        _tree[0] = winner;
+    }
+
+    BSONObjExternalSorter::Data BSONObjExternalSorter::Iterator::mergeNext() {
+        int w = _tree[0];
+        Data d = _heads[w];
+        if ( _files[w]->more() )
+            _heads[w] = _files[w]->next();
+        else
+            _done[w] = true;
+        adjust( w );
+        return d;
+    }
+
+    void BSONObjExternalSorter::Iterator::mergeThread() {
+        try {
+            while ( 1 ) {
+                vector<Data> b;
+                b.reserve( MergeBatchSize );
+                while ( b.size() < MergeBatchSize && mergeMore() )
+                    b.push_back( mergeNext() );
+
+                scoped_lock lk( _m );
+                while ( _ready.size() >= MergeBatchesAhead && !_stop )
+                    _cond.wait( lk.boost() );
+                if ( _stop )
+                    return;
+                _ready.push_back( vector<Data>() );
+                _ready.back().swap( b );
+                if ( ! mergeMore() )
+                    _mergeDone = true;
+                _cond.notify_all();
+                if ( _mergeDone )
+                    return;
+            }
+        }
+        catch ( std::exception& e ) {
+            scoped_lock lk( _m );
+            _err = e.what();
+            _mergeDone = true;
+            _cond.notify_all();
+        }
+    }
+
+    void BSONObjExternalSorter::Iterator::fetchBatch() {
+        _batch.clear();
+        _batchPos = 0;
+        scoped_lock lk( _m );
+        while ( _ready.empty() && !_mergeDone )
+            _cond.wait( lk.boost() );
+        massert( 13659 , "external sort merge failed: " + _err , _err.empty() );
+        if ( _ready.empty() )
+            return;
+        _batch.swap( _ready.front() );
+        _ready.pop_front();
+        _cond.notify_all();
+    }
+
     bool BSONObjExternalSorter::Iterator::more() {
 
         if ( _in )
             return _it != _in->end();
 
-        for ( vector<FileIterator*>::iterator i=_files.begin(); i!=_files.end(); i++ )
-            if ( (*i)->more() )
-                return true;
-        for ( vector< pair<Data,bool> >::iterator i=_stash.begin(); i!=_stash.end(); i++ )
-            if ( i->second )
-                return true;
-        return false;
+        if ( _thread ) {
+            if ( _batchPos >= _batch.size() )
+                fetchBatch();
+            return _batchPos < _batch.size();
+        }
+
+        return mergeMore();
     }
 
     BSONObjExternalSorter::Data BSONObjExternalSorter::Iterator::next() {
@@ -190,29 +360,15 @@ namespace mongo {
             return d;
         }
 
-        Data best;
-        int slot = -1;
-
-        for ( unsigned i=0; i<_stash.size(); i++ ) {
-
-            if ( ! _stash[i].second ) {
-                if ( _files[i]->more() )
-                    _stash[i] = pair<Data,bool>( _files[i]->next() , true );
-                else
-                    continue;
-            }
-
-            if ( slot == -1 || _cmp( best , _stash[i].first ) == 0 ) {
-                best = _stash[i].first;
-                slot = i;
-            }
-
+        if ( _thread ) {
+            if ( _batchPos >= _batch.size() )
+                fetchBatch();
+            assert( _batchPos < _batch.size() );
+            return _batch[ _batchPos++ ];
         }
 
-        assert( slot >= 0 );
-        _stash[slot].second = false;
-
-        return best;
+        assert( mergeMore() );
+        return mergeNext();
     }
 
     // -----------------------------------
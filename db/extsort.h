@@ -23,6 +23,7 @@
 #include "namespace-inl.h"
 #include "curop-inl.h"
 #include "../util/array.h"
+#include "../util/concurrency/thread_pool.h"
 
 namespace mongo {
 
@@ -63,18 +64,24 @@ namespace mongo {
 
         class MyCmp {
         public:
-            MyCmp( const BSONObj & order = BSONObj() ) : _order( order ) {}
+            /** @param onClientThread false if used off the thread of the operation - no interrupt checks */
+            MyCmp( const BSONObj & order = BSONObj() , bool onClientThread = true ) :
+                _order( order ) , _onClientThread( onClientThread ) {}
             bool operator()( const Data &l, const Data &r ) const {
-                RARELY killCurrentOp.checkForInterrupt();
-                _compares++;
+                if ( _onClientThread ) {
+                    RARELY killCurrentOp.checkForInterrupt();
+                    _compares++;
+                }
                 int x = l.first.woCompare( r.first , _order );
                 if ( x )
                     return x < 0;
                 return l.second.compare( r.second ) < 0;
             };
+            bool operator()( const Data *l, const Data *r ) const { return (*this)( *l , *r ); }
 
         private:
             BSONObj _order;
+            bool _onClientThread;
         };
 
     public:
@@ -90,13 +97,36 @@ namespace mongo {
             Data next();
 
         private:
+            // k-way merge of the files with a loser tree: _tree[0] is the file whose head is
+            // smallest, _tree[1..k-1] hold the losers of the matches at each internal node
+            bool lessFile( int a , int b ) const;
+            void adjust( int file );
+            bool mergeMore() const { return !_tree.empty() && !_done[ _tree[0] ]; }
+            Data mergeNext();
+
+            // for a threaded sorter the merge runs ahead of the caller on its own thread,
+            // handing over batches of results
+            void mergeThread();
+            void fetchBatch();
+
             MyCmp _cmp;
             vector<FileIterator*> _files;
-            vector< pair<Data,bool> > _stash;
+            vector<Data> _heads;
+            vector<bool> _done;
+            vector<int> _tree;
 
             InMemory * _in;
             InMemory::iterator _it;
 
+            scoped_ptr<boost::thread> _thread;
+            mongo::mutex _m;
+            boost::condition _cond;
+            list< vector<Data> > _ready;
+            bool _mergeDone;
+            bool _stop;
+            string _err;
+            vector<Data> _batch;
+            unsigned _batchPos;
         };
 
         BSONObjExternalSorter( const BSONObj & order = BSONObj() , long maxFileSize = 1024 * 1024 * 100 );
@@ -121,6 +151,12 @@ namespace mongo {
 
         long getCurSizeSoFar() { return _curSizeSoFar; }
 
+        /** sort and write runs on n threads while the caller keeps adding, and merge on a
+            thread of its own.  up to n+1 runs are in memory at once, so each run gets 1/(n+1)
+            of the size and entries.  call before add().
+        */
+        void useThreads( int n );
+
         void hintNumObjects( long long numObjects ) {
             if ( numObjects < _arraySize )
                 _arraySize = (int)(numObjects + 100);
@@ -132,6 +168,8 @@ namespace mongo {
 
         void sort( string file );
         void finishMap();
+        void writeRun( InMemory * run , const string& file , bool onClientThread );
+        void writeRunThread( InMemory * run , string file );
 
         BSONObj _order;
         long _maxFilesize;
@@ -144,6 +182,13 @@ namespace mongo {
         list<string> _files;
         bool _sorted;
 
+        int _threads;
+        scoped_ptr<ThreadPool> _pool;
+        mongo::mutex _errMutex; // guards _err and _runsPending
+        string _err; // from writeRunThread
+        int _runsPending; // scheduled on _pool and not yet written
+        boost::condition _runWritten;
+
         static unsigned long long _compares;
     };
 }
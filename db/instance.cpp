@@ -31,6 +31,7 @@
 #include "../s/d_logic.h"
 #include "../util/file_allocator.h"
 #include "../util/goodies.h"
+#include "../util/timer.h"
 #include "cmdline.h"
 #if !defined(_WIN32)
 #include <sys/file.h>
@@ -499,6 +500,9 @@ namespace mongo {
 
     QueryResult* emptyMoreResult(long long);
 
+    /* how long a getMore on an awaitData cursor waits for data before returning nothing */
+    static const int AwaitDataMillis = 2000;
+
     bool receivedGetMore(DbResponse& dbresponse, Message& m, CurOp& curop ) {
         StringBuilder& ss = curop.debug().str;
         bool ok = true;
@@ -513,51 +517,45 @@ namespace mongo {
         if( ntoreturn )
             ss << " ntoreturn:" << ntoreturn;
 
-        time_t start = 0;
+        Timer waiting;
         int pass = 0;
         bool exhaust = false;
-        QueryResult* msgdata;
+        auto_ptr<Message> resp( new Message() );
         while( 1 ) {
             try {
                 readlock lk;
                 Client::Context ctx(ns);
-                msgdata = processGetMore(ns, ntoreturn, cursorid, curop, pass, exhaust);
+                processGetMore(ns, ntoreturn, cursorid, curop, pass, exhaust, *resp);
             }
-            catch ( GetMoreWaitException& ) {
+            catch ( GetMoreWaitException& e ) {
                 exhaust = false;
                 massert(13073, "shutting down", !inShutdown() );
-                if( pass == 0 ) {
-                    start = time(0);
-                }
-                else {
-                    if( time(0) - start >= 4 ) {
-                        // after about 4 seconds, return.  this is a sanity check.  pass stops at 1000 normally
-                        // for DEV this helps and also if sleep is highly inaccurate on a platform.  we want to
-                        // return occasionally so slave can checkpoint.
-                        pass = 10000;
-                    }
-                }
+                if( pass == 0 )
+                    waiting.reset();
                 pass++;
-                DEV
-                sleepmillis(20);
-                else
-                    sleepmillis(2);
+                int left = AwaitDataMillis - waiting.millis();
+                if( left <= 0 ) {
+                    // return empty now and then so a slave can checkpoint
+                    pass = 10000;
+                    continue;
+                }
+                // an insert into ns wakes us.  wake now and then anyway to notice shutdown
+                CappedInsertNotifier::wait( ns , e.version , min( left , 500 ) );
                 continue;
             }
             catch ( AssertionException& e ) {
                 exhaust = false;
                 ss << " exception " << e.toString();
-                msgdata = emptyMoreResult(cursorid);
+                resp->reset();
+                resp->setData(emptyMoreResult(cursorid), true);
                 ok = false;
             }
             break;
         };
 
-        Message *resp = new Message();
-        resp->setData(msgdata, true);
         ss << " bytes:" << resp->header()->dataLen();
-        ss << " nreturned:" << msgdata->nReturned;
-        dbresponse.response = resp;
+        ss << " nreturned:" << ((QueryResult *) resp->header())->nReturned;
+        dbresponse.response = resp.release();
         dbresponse.responseTo = m.header()->id;
         if( exhaust ) {
             ss << " exhaust ";
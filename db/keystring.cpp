@@ -0,0 +1,171 @@
+// keystring.cpp
+
+/**
+*    Copyright (C) 2008 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "keystring.h"
+#include "../util/hex.h"
+#include "../util/mongoutils/str.h"
+
+using namespace mongoutils;
+
+namespace mongo {
+
+    void KeyString::reset( const BSONObj& key , const Ordering& o ) {
+        _buf.clear();
+        BSONObjIterator i( key );
+        int n = 0;
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            size_t pos = _buf.size();
+            appendElement( e , false );
+            if ( o.get( n ) < 0 )
+                invertFrom( pos );
+            n++;
+        }
+    }
+
+    int KeyString::compare( const KeyString& r ) const {
+        int l = min( size() , r.size() );
+        int x = memcmp( data() , r.data() , l );
+        if ( x )
+            return x;
+        return size() - r.size();
+    }
+
+    string KeyString::toString() const {
+        return toHex( data() , size() );
+    }
+
+    void KeyString::appendElement( const BSONElement& e , bool withFieldName ) {
+        // canonicalType() runs from -1 (MinKey) to 127 (MaxKey); keep 0 free as the
+        // end of object marker
+        _buf.push_back( (char) (unsigned char) ( e.canonicalType() + 2 ) );
+        if ( withFieldName )
+            appendCString( e.fieldName() );
+        appendValue( e );
+    }
+
+    void KeyString::appendValue( const BSONElement& e ) {
+        switch ( e.type() ) {
+        case EOO:
+        case Undefined:
+        case jstNULL:
+        case MaxKey:
+        case MinKey:
+            break;
+        case Bool:
+            _buf.push_back( e.boolean() ? 1 : 0 );
+            break;
+        case Timestamp:
+        case Date:
+            appendBigEndian( e.date() , 8 );
+            break;
+        case NumberLong: {
+            long long L = e._numberLong();
+            double d = (double) L;
+            appendDouble( d );
+            // d is an integer; break ties between longs that round to the same double
+            long long residual;
+            if ( d >= 9223372036854775808.0 )
+                residual = ( L - numeric_limits<long long>::max() ) - 1;
+            else
+                residual = L - (long long) d;
+            appendBigEndian( ( (unsigned long long) residual ) ^ ( 1ULL << 63 ) , 8 );
+            break;
+        }
+        case NumberInt:
+        case NumberDouble:
+            appendDouble( e.number() );
+            appendBigEndian( 1ULL << 63 , 8 );
+            break;
+        case jstOID:
+            _buf.append( e.value() , 12 );
+            break;
+        case Code:
+        case Symbol:
+        case String:
+            appendCString( e.valuestr() );
+            break;
+        case Object:
+        case Array: {
+            BSONObjIterator i( e.embeddedObject() );
+            while ( i.more() )
+                appendElement( i.next() , true );
+            _buf.push_back( 0 );
+            break;
+        }
+        case DBRef: {
+            int sz = e.valuesize();
+            appendBigEndian( (unsigned) sz , 4 );
+            _buf.append( e.value() , sz );
+            break;
+        }
+        case BinData: {
+            // length first, then subtype and data, as compareElementValues does
+            int sz = *reinterpret_cast< const int* >( e.value() );
+            appendBigEndian( (unsigned) sz , 4 );
+            _buf.append( e.value() + 4 , sz + 1 );
+            break;
+        }
+        case RegEx:
+            appendCString( e.regex() );
+            appendCString( e.regexFlags() );
+            break;
+        case CodeWScope:
+            appendCString( e.codeWScopeCode() );
+            appendCString( e.codeWScopeScopeData() );
+            break;
+        default:
+            msgasserted( 13654 , str::stream() << "KeyString: bad type " << (int) e.type() );
+        }
+    }
+
+    void KeyString::appendCString( const char *s ) {
+        // strcmp semantics: stop at the first nul and terminate with one
+        _buf.append( s , strlen( s ) + 1 );
+    }
+
+    void KeyString::appendBigEndian( unsigned long long v , int bytes ) {
+        for ( int i = bytes - 1; i >= 0; i-- )
+            _buf.push_back( (char) ( ( v >> ( i * 8 ) ) & 0xff ) );
+    }
+
+    void KeyString::appendDouble( double d ) {
+        // compareElementValues treats nan and +/-inf as equal to each other and less
+        // than every finite number
+        if ( !( d <= numeric_limits< double >::max() && d >= -numeric_limits< double >::max() ) ) {
+            appendBigEndian( 0 , 8 );
+            return;
+        }
+        if ( d == 0 )
+            d = 0; // -0.0 == 0.0
+        unsigned long long bits;
+        memcpy( &bits , &d , 8 );
+        if ( bits >> 63 )
+            bits = ~bits;
+        else
+            bits |= 1ULL << 63;
+        appendBigEndian( bits , 8 );
+    }
+
+    void KeyString::invertFrom( size_t pos ) {
+        for ( size_t i = pos; i < _buf.size(); i++ )
+            _buf[i] = ~_buf[i];
+    }
+
+}
@@ -0,0 +1,73 @@
+// keystring.h
+
+/**
+*    Copyright (C) 2008 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../pch.h"
+#include "jsobj.h"
+
+namespace mongo {
+
+    /**
+     * A byte string encoding of an index key such that comparing two encodings with
+     * memcmp gives the same answer as BSONObj::woCompare( other , ordering ).
+     *
+     * Each top level element is written as a type byte (canonicalType()+2, so 0 can
+     * terminate objects) followed by a value encoding chosen so the bytes sort the way
+     * compareElementValues() does.  Descending fields have every byte of their encoding
+     * inverted.  Field names of the top level key are ignored, as they are in the btree.
+     *
+     * Known difference: a NumberLong and a double that compare equal as doubles are
+     * ordered by the long's exact value here, where woCompare calls them equal.  This
+     * only happens for magnitudes above 2^53.
+     *
+     * The encoding is not reversible; keep the BSONObj if you need the key back.
+     *
+     * Btree buckets don't use it, they still store keys as BSONObj.  ChunkRoutingTable
+     * keeps chunk bounds this way so mongos can binary search them with memcmp.
+     */
+    class KeyString {
+    public:
+        KeyString() { }
+        KeyString( const BSONObj& key , const Ordering& o ) { reset( key , o ); }
+
+        void reset( const BSONObj& key , const Ordering& o );
+
+        const char * data() const { return _buf.data(); }
+        int size() const { return (int) _buf.size(); }
+
+        /** memcmp order, shorter first on a common prefix */
+        int compare( const KeyString& r ) const;
+
+        bool operator<( const KeyString& r ) const { return compare( r ) < 0; }
+        bool operator==( const KeyString& r ) const { return _buf == r._buf; }
+
+        string toString() const;
+
+    private:
+        void appendElement( const BSONElement& e , bool withFieldName );
+        void appendValue( const BSONElement& e );
+        void appendCString( const char *s );
+        void appendBigEndian( unsigned long long v , int bytes );
+        void appendDouble( double d );
+        void invertFrom( size_t pos );
+
+        string _buf;
+    };
+
+}
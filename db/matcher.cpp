@@ -53,9 +53,16 @@ namespace mongo {
 
     extern BSONObj staticNull;
 
+    /**
+     * a $where clause.  the pooled scope isn't taken and the function isn't compiled until a
+     * document gets past everything else in the query, so candidate plans and clauses whose
+     * other predicates reject every document never touch javascript.  once set up they stay with
+     * the matcher, which the ClientCursor keeps across getMores, and the pooled scope keeps the
+     * compiled function for later queries on the collection with the same code.
+     */
     class Where {
     public:
-        Where() {
+        Where( const string& ns , const string& db ) : pool( ns ) , dbName( db ) {
             jsScope = 0;
             func = 0;
         }
@@ -71,13 +78,23 @@ namespace mongo {
             func = 0;
         }
 
+        string pool;
+        string dbName;
+        string code;
         auto_ptr<Scope> scope;
         ScriptingFunction func;
         BSONObj *jsScope;
 
-        void setFunc(const char *code) {
-            massert( 10341 ,  "scope has to be created first!" , scope.get() );
-            func = scope->createFunction( code );
+        /** @return scope to invoke func in, set up on first use */
+        Scope * getScope() {
+            if ( ! scope.get() ) {
+                scope = globalScriptEngine->getPooledScope( pool );
+                scope->localConnect( dbName.c_str() );
+                func = scope->createFunction( code.c_str() );
+                scope->execSetup( "_mongo.readOnly = true;" , "make read only" );
+                scope->setBoolean( "fullObject" , true ); // this is a hack b/c fullObject used to be relevant
+            }
+            return scope.get();
         }
 
     };
@@ -300,8 +317,8 @@ namespace mongo {
 
     /* _jsobj          - the query pattern
     */
-    Matcher::Matcher(const BSONObj &_jsobj, bool subMatcher) :
-        where(0), jsobj(_jsobj), haveSize(), all(), hasArray(0), haveNeg(), _atomic(false), nRegex(0) {
+    Matcher::Matcher(const BSONObj &_jsobj, bool subMatcher, bool compileFields) :
+        where(0), jsobj(_jsobj), _canReorder(false), _nMatches(0), haveSize(), all(), hasArray(0), haveNeg(), _atomic(false), nRegex(0) {
 
         BSONObjIterator i(jsobj);
         while ( i.more() ) {
@@ -318,21 +335,16 @@ namespace mongo {
                 uassert( 10066 , "$where occurs twice?", where == 0 );
                 uassert( 10067 , "$where query, but no script engine", globalScriptEngine );
                 massert( 13089 , "no current client needed for $where" , haveClient() );
-                where = new Where();
-                where->scope = globalScriptEngine->getPooledScope( cc().ns() );
-                where->scope->localConnect( cc().database()->name.c_str() );
+                where = new Where( cc().ns() , cc().database()->name );
 
                 if ( e.type() == CodeWScope ) {
-                    where->setFunc( e.codeWScopeCode() );
+                    where->code = e.codeWScopeCode();
                     where->jsScope = new BSONObj( e.codeWScopeScopeData() , 0 );
                 }
                 else {
-                    const char *code = e.valuestr();
-                    where->setFunc(code);
+                    where->code = e.valuestr();
                 }
 
-                where->scope->execSetup( "_mongo.readOnly = true;" , "make read only" );
-
                 continue;
             }
 
@@ -408,10 +420,107 @@ namespace mongo {
             // normal, simple case e.g. { a : "foo" }
             addBasic(e, BSONObj::Equality, false);
         }
+
+        if ( compileFields )
+            compile();
+    }
+
+    /* The interpreter in matchesDotted() does a getField() scan of the object for every basic,
+       and evaluates basics in query order.  For the common shapes - several predicates on
+       plain or dotted fields - we instead:
+
+         - collect the distinct top level field names ("heads") the basics need, and fetch all
+           of them in a single pass over the object before evaluating anything.  basics on
+           a.b and a.c share the lookup of a.
+         - count how often each basic rejects, and every ReorderInterval calls re-sort the
+           evaluation order so the most selective basics run first.
+
+       $all and $nin keep using matchesDotted() as they collect every dotted value.  We don't
+       reorder when the caller wants MatchDetails, since elemMatchKey is taken from the last
+       basic that sets it, or if a basic may uassert on the document ($all with $elemMatch).
+    */
+    void Matcher::compile() {
+        unsigned nCompiled = 0;
+        _headOf.resize( basics.size(), -1 );
+        for ( unsigned i = 0; i < basics.size(); i++ ) {
+            const ElementMatcher &bm = basics[ i ];
+            if ( bm.compareOp == BSONObj::opALL || bm.compareOp == BSONObj::NIN )
+                continue;
+            const char *fieldName = bm.toMatch.fieldName();
+            const char *p = strchr( fieldName, '.' );
+            string head = p ? string( fieldName, p - fieldName ) : string( fieldName );
+            unsigned h = find( _heads.begin(), _heads.end(), head ) - _heads.begin();
+            if ( h == _heads.size() )
+                _heads.push_back( head );
+            _headOf[ i ] = h;
+            nCompiled++;
+        }
+        if ( nCompiled < 2 ) {
+            // a single getField() is as good as a prefetch
+            _heads.clear();
+            _headOf.clear();
+        }
+        _tops.resize( _heads.size() );
+
+        _canReorder = basics.size() > 1;
+        for ( unsigned i = 0; i < basics.size(); i++ ) {
+            if ( basics[ i ].allMatchers.size() )
+                _canReorder = false;
+            _order.push_back( i );
+        }
+        _evals.resize( basics.size() );
+        _rejects.resize( basics.size() );
+    }
+
+    void Matcher::prefetch( const BSONObj &obj ) {
+        unsigned n = _heads.size();
+        for ( unsigned k = 0; k < n; k++ )
+            _tops[ k ] = BSONElement();
+        unsigned left = n;
+        BSONObjIterator i( obj );
+        while ( left && i.more() ) {
+            BSONElement e = i.next();
+            const char *f = e.fieldName();
+            for ( unsigned k = 0; k < n; k++ ) {
+                const char *h = _heads[ k ].c_str();
+                // first occurrence wins, as with getField()
+                if ( h[ 0 ] == f[ 0 ] && _tops[ k ].eoo() && strcmp( h, f ) == 0 ) {
+                    _tops[ k ] = e;
+                    left--;
+                    break;
+                }
+            }
+        }
+    }
+
+    namespace {
+        const unsigned ReorderInterval = 128;
+
+        struct MoreSelective {
+            MoreSelective( const vector< unsigned > &evals, const vector< unsigned > &rejects ) :
+                _evals( evals ), _rejects( rejects ) {}
+            bool operator()( unsigned a, unsigned b ) const {
+                // rejects[a]/evals[a] > rejects[b]/evals[b]
+                return (unsigned long long) _rejects[ a ] * _evals[ b ] >
+                       (unsigned long long) _rejects[ b ] * _evals[ a ];
+            }
+            const vector< unsigned > &_evals;
+            const vector< unsigned > &_rejects;
+        };
+    }
+
+    void Matcher::reorder() {
+        stable_sort( _order.begin(), _order.end(), MoreSelective( _evals, _rejects ) );
+        // decay so we follow changes in the data
+        for ( unsigned i = 0; i < _evals.size(); i++ ) {
+            _evals[ i ] /= 2;
+            _rejects[ i ] /= 2;
+        }
+        _nMatches = 0;
     }
 
     Matcher::Matcher( const Matcher &other, const BSONObj &key ) :
-        where(0), constrainIndexKey_( key ), haveSize(), all(), hasArray(0), haveNeg(), _atomic(false), nRegex(0) {
+        where(0), constrainIndexKey_( key ), _canReorder(false), _nMatches(0), haveSize(), all(), hasArray(0), haveNeg(), _atomic(false), nRegex(0) {
         // do not include fields which would make keyMatch() false
         for( vector< ElementMatcher >::const_iterator i = other.basics.begin(); i != other.basics.end(); ++i ) {
             if ( key.hasField( i->toMatch.fieldName() ) ) {
@@ -510,20 +619,37 @@ namespace mongo {
         return (op & z);
     }
 
-    int Matcher::matchesNe(const char *fieldName, const BSONElement &toMatch, const BSONObj &obj, const ElementMatcher& bm , MatchDetails * details ) {
-        int ret = matchesDotted( fieldName, toMatch, obj, BSONObj::Equality, bm , false , details );
+    /** @param ret result of the equality match for a $ne */
+    inline int neResult( int ret, const ElementMatcher& bm ) {
         if ( bm.toMatch.type() != jstNULL )
             return ( ret <= 0 ) ? 1 : 0;
         else
             return -ret;
     }
 
+    int Matcher::matchesNe(const char *fieldName, const BSONElement &toMatch, const BSONObj &obj, const ElementMatcher& bm , MatchDetails * details ) {
+        int ret = matchesDotted( fieldName, toMatch, obj, BSONObj::Equality, bm , false , details );
+        return neResult( ret, bm );
+    }
+
     int retMissing( const ElementMatcher &bm ) {
         if ( bm.compareOp != BSONObj::opEXISTS )
             return 0;
         return bm.toMatch.boolean() ? -1 : 1;
     }
 
+    /* same as matchesDotted() on the whole object, given top = obj.getField() of the first
+       component of fieldName.  not for $all, $ne or $nin, nor for index keys.
+    */
+    int Matcher::matchesTop(const BSONElement &top, const char *fieldName, const BSONElement &toMatch, int compareOp, const ElementMatcher &em, MatchDetails * details ) {
+        const char *p = strchr( fieldName, '.' );
+        if ( !p )
+            return matchesValue( top, toMatch, compareOp, em, false, details );
+        if ( top.type() == Object || top.type() == Array )
+            return matchesDotted( p + 1, toMatch, top.embeddedObject(), compareOp, em, top.type() == Array, details );
+        return retMissing( em );
+    }
+
     /* Check if a particular field matches.
 
        fieldName - field to match "a.b" if we are reaching into an embedded object.
@@ -693,6 +819,11 @@ namespace mongo {
             }
         }
 
+        return matchesValue( e, toMatch, compareOp, em, indexed, details );
+    }
+
+    /* the tail of matchesDotted(): e is the field named by the predicate, eoo if missing */
+    int Matcher::matchesValue(const BSONElement &e, const BSONElement& toMatch, int compareOp, const ElementMatcher& em, bool indexed, MatchDetails * details ) {
         if ( compareOp == BSONObj::opEXISTS ) {
             return ( e.eoo() ^ ( toMatch.boolean() ^ em.isNot ) ) ? 1 : -1;
         }
@@ -747,36 +878,63 @@ namespace mongo {
 
     extern int dump;
 
+    bool Matcher::matchesBasic( unsigned i, const BSONObj &jsobj, MatchDetails * details ) {
+        ElementMatcher& bm = basics[i];
+        BSONElement& m = bm.toMatch;
+        int h = _headOf.empty() ? -1 : _headOf[i];
+        // -1=mismatch. 0=missing element. 1=match
+        int cmp;
+        if ( h < 0 )
+            cmp = matchesDotted(m.fieldName(), m, jsobj, bm.compareOp, bm , false , details );
+        else if ( bm.compareOp == BSONObj::NE )
+            cmp = neResult( matchesTop( _tops[h], m.fieldName(), m, BSONObj::Equality, bm, details ), bm );
+        else
+            cmp = matchesTop( _tops[h], m.fieldName(), m, bm.compareOp, bm, details );
+        if ( bm.compareOp != BSONObj::opEXISTS && bm.isNot )
+            cmp = -cmp;
+        if ( cmp < 0 )
+            return false;
+        if ( cmp == 0 ) {
+            /* missing is ok iff we were looking for null */
+            if ( m.type() == jstNULL || m.type() == Undefined || ( bm.compareOp == BSONObj::opIN && bm.myset->count( staticNull.firstElement() ) > 0 ) ) {
+                if ( ( bm.compareOp == BSONObj::NE ) ^ bm.isNot ) {
+                    return false;
+                }
+            }
+            else {
+                if ( !bm.isNot ) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
     /* See if an object matches the query.
     */
     bool Matcher::matches(const BSONObj& jsobj , MatchDetails * details ) {
-        /* assuming there is usually only one thing to match.  if more this
-        could be slow sometimes. */
+        if ( !_heads.empty() )
+            prefetch( jsobj );
 
         // check normal non-regex cases:
-        for ( unsigned i = 0; i < basics.size(); i++ ) {
-            ElementMatcher& bm = basics[i];
-            BSONElement& m = bm.toMatch;
-            // -1=mismatch. 0=missing element. 1=match
-            int cmp = matchesDotted(m.fieldName(), m, jsobj, bm.compareOp, bm , false , details );
-            if ( bm.compareOp != BSONObj::opEXISTS && bm.isNot )
-                cmp = -cmp;
-            if ( cmp < 0 )
-                return false;
-            if ( cmp == 0 ) {
-                /* missing is ok iff we were looking for null */
-                if ( m.type() == jstNULL || m.type() == Undefined || ( bm.compareOp == BSONObj::opIN && bm.myset->count( staticNull.firstElement() ) > 0 ) ) {
-                    if ( ( bm.compareOp == BSONObj::NE ) ^ bm.isNot ) {
-                        return false;
-                    }
-                }
-                else {
-                    if ( !bm.isNot ) {
-                        return false;
-                    }
+        if ( _canReorder && !details ) {
+            if ( ++_nMatches == ReorderInterval )
+                reorder();
+            for ( unsigned i = 0; i < basics.size(); i++ ) {
+                unsigned b = _order[i];
+                _evals[b]++;
+                if ( !matchesBasic( b, jsobj, 0 ) ) {
+                    _rejects[b]++;
+                    return false;
                 }
             }
         }
+        else {
+            for ( unsigned i = 0; i < basics.size(); i++ ) {
+                if ( !matchesBasic( i, jsobj, details ) )
+                    return false;
+            }
+        }
 
         for ( int r = 0; r < nRegex; r++ ) {
             RegexMatcher& rm = regexs[r];
@@ -797,16 +955,28 @@ namespace mongo {
                 return false;
         }
 
+        for( vector< shared_ptr< FieldRangeVector > >::const_iterator i = _orConstraints.begin();
+                i != _orConstraints.end(); ++i ) {
+            if ( (*i)->matches( jsobj ) ) {
+                return false;
+            }
+        }
+
+        // clauses with a $where are tried after the others, one of those may decide it
         if ( _orMatchers.size() > 0 ) {
             bool match = false;
-            for( list< shared_ptr< Matcher > >::const_iterator i = _orMatchers.begin();
-                    i != _orMatchers.end(); ++i ) {
-                // SERVER-205 don't submit details - we don't want to track field
-                // matched within $or, and at this point we've already loaded the
-                // whole document
-                if ( (*i)->matches( jsobj ) ) {
-                    match = true;
-                    break;
+            for( int js = 0; js < 2 && !match; ++js ) {
+                for( list< shared_ptr< Matcher > >::const_iterator i = _orMatchers.begin();
+                        i != _orMatchers.end(); ++i ) {
+                    if ( ( (*i)->where != 0 ) != ( js == 1 ) )
+                        continue;
+                    // SERVER-205 don't submit details - we don't want to track field
+                    // matched within $or, and at this point we've already loaded the
+                    // whole document
+                    if ( (*i)->matches( jsobj ) ) {
+                        match = true;
+                        break;
+                    }
                 }
             }
             if ( !match ) {
@@ -815,43 +985,40 @@ namespace mongo {
         }
 
         if ( _norMatchers.size() > 0 ) {
-            for( list< shared_ptr< Matcher > >::const_iterator i = _norMatchers.begin();
-                    i != _norMatchers.end(); ++i ) {
-                // SERVER-205 don't submit details - we don't want to track field
-                // matched within $nor, and at this point we've already loaded the
-                // whole document
-                if ( (*i)->matches( jsobj ) ) {
-                    return false;
+            for( int js = 0; js < 2; ++js ) {
+                for( list< shared_ptr< Matcher > >::const_iterator i = _norMatchers.begin();
+                        i != _norMatchers.end(); ++i ) {
+                    if ( ( (*i)->where != 0 ) != ( js == 1 ) )
+                        continue;
+                    // SERVER-205 don't submit details - we don't want to track field
+                    // matched within $nor, and at this point we've already loaded the
+                    // whole document
+                    if ( (*i)->matches( jsobj ) ) {
+                        return false;
+                    }
                 }
             }
         }
 
-        for( vector< shared_ptr< FieldRangeVector > >::const_iterator i = _orConstraints.begin();
-                i != _orConstraints.end(); ++i ) {
-            if ( (*i)->matches( jsobj ) ) {
-                return false;
-            }
-        }
-
         if ( where ) {
+            Scope *scope = where->getScope();
             if ( where->func == 0 ) {
                 uassert( 10070 , "$where compile error", false);
                 return false; // didn't compile
             }
 
             if ( where->jsScope ) {
-                where->scope->init( where->jsScope );
+                scope->init( where->jsScope );
             }
-            where->scope->setThis( const_cast< BSONObj * >( &jsobj ) );
-            where->scope->setObject( "obj", const_cast< BSONObj & >( jsobj ) );
-            where->scope->setBoolean( "fullObject" , true ); // this is a hack b/c fullObject used to be relevant
+            scope->setThis( const_cast< BSONObj * >( &jsobj ) );
+            scope->setObject( "obj", const_cast< BSONObj & >( jsobj ) );
 
-            int err = where->scope->invoke( where->func , BSONObj() , 1000 * 60 , false );
-            where->scope->setThis( 0 );
+            int err = scope->invoke( where->func , BSONObj() , 1000 * 60 , false );
+            scope->setThis( 0 );
             if ( err == -3 ) { // INVOKE_ERROR
                 stringstream ss;
                 ss << "error on invocation of $where function:\n"
-                   << where->scope->getError();
+                   << scope->getError();
                 uassert( 10071 , ss.str(), false);
                 return false;
             }
@@ -859,7 +1026,7 @@ namespace mongo {
                 uassert( 10072 , "unknown error in invocation of $where function", false);
                 return false;
             }
-            return where->scope->getBoolean( "return" ) != 0;
+            return scope->getBoolean( "return" ) != 0;
 
         }
 
@@ -129,12 +129,25 @@ namespace mongo {
             const BSONElement &toMatch, const BSONObj &obj,
             const ElementMatcher&bm, MatchDetails * details );
 
+        int matchesTop(
+            const BSONElement &top, const char *fieldName,
+            const BSONElement &toMatch, int compareOp,
+            const ElementMatcher &bm, MatchDetails * details );
+
+        int matchesValue(
+            const BSONElement &e,
+            const BSONElement &toMatch, int compareOp,
+            const ElementMatcher &bm, bool indexed, MatchDetails * details );
+
     public:
         static int opDirection(int op) {
             return op <= BSONObj::LTE ? -1 : 1;
         }
 
-        Matcher(const BSONObj &pattern, bool subMatcher = false);
+        /** @param compileFields if false, look up every field with getFieldDotted() and evaluate
+                   predicates in query order, as a reference for tests and benchmarks.
+        */
+        Matcher(const BSONObj &pattern, bool subMatcher = false, bool compileFields = true);
 
         ~Matcher();
 
@@ -180,6 +193,12 @@ namespace mongo {
 
         int valuesMatch(const BSONElement& l, const BSONElement& r, int op, const ElementMatcher& bm);
 
+        /* see compile() in matcher.cpp */
+        void compile();
+        void prefetch( const BSONObj &obj );
+        bool matchesBasic( unsigned i, const BSONObj &obj, MatchDetails * details );
+        void reorder();
+
         bool parseOrNor( const BSONElement &e, bool subMatcher );
         void parseOr( const BSONElement &e, bool subMatcher, list< shared_ptr< Matcher > > &matchers );
 
@@ -187,6 +206,16 @@ namespace mongo {
         BSONObj jsobj;                  // the query pattern.  e.g., { name: "joe" }
         BSONObj constrainIndexKey_;
         vector<ElementMatcher> basics;
+
+        vector< string > _heads;       // distinct top level field names read by basics
+        vector< int > _headOf;         // per basic: index into _heads, or -1 to use matchesDotted()
+        vector< BSONElement > _tops;   // per head: that field of the object being matched
+        bool _canReorder;
+        vector< unsigned > _order;     // evaluation order of basics, most selective first
+        vector< unsigned > _evals;     // per basic, since the last reorder()
+        vector< unsigned > _rejects;
+        unsigned _nMatches;
+
         bool haveSize;
         bool all;
         bool hasArray;
@@ -220,6 +249,9 @@ namespace mongo {
         bool matchesCurrent( Cursor * cursor , MatchDetails * details = 0 );
         bool needRecord() { return _needRecord; }
 
+        /** true if the index key alone decides every match, so matches() never loads the record */
+        bool keyOnly() const { return !_needRecord && !_needRecordReject; }
+
         Matcher& docMatcher() { return *_docMatcher; }
 
         // once this is called, shouldn't use this matcher for matching any more
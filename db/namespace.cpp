@@ -27,6 +27,7 @@
 #include <list>
 #include "query.h"
 #include "queryutil.h"
+#include "plancache.h"
 #include "json.h"
 
 namespace mongo {
@@ -307,7 +308,9 @@ namespace mongo {
         int b = bucket(len);
         DiskLoc cur = deletedList[b];
         prev = &deletedList[b];
-        int extra = 5; // look for a better fit, a little.
+        // look for a better fit, a little.  with power of 2 sizes the first fit is as good
+        // as any and is normally the head of the list.
+        int extra = isFlagSet( Flag_UsePowerOf2Sizes ) ? 1 : 5;
         int chain = 0;
         while ( 1 ) {
             {
@@ -372,6 +375,36 @@ namespace mongo {
         return bestmatch;
     }
 
+    int NamespaceDetails::quantizePowerOf2AllocationSpace( int allocSize ) {
+        for ( int i = 0; i < MaxBucket; i++ ) {
+            if ( bucketSizes[i] >= allocSize )
+                return bucketSizes[i];
+        }
+        // very large records: whole megabytes
+        const int MB = 1024 * 1024;
+        return ( allocSize + MB - 1 ) & ~( MB - 1 );
+    }
+
+    bool NamespaceDetails::deletedStats( long long *count, long long *size, int maxPerBucket ) const {
+        *count = 0;
+        *size = 0;
+        if ( capped )
+            return true;
+        bool complete = true;
+        for ( int i = 0; i < Buckets; i++ ) {
+            int n = 0;
+            for ( DiskLoc dl = deletedList[i]; !dl.isNull(); dl = dl.drec()->nextDeleted ) {
+                if ( n++ == maxPerBucket ) {
+                    complete = false;
+                    break;
+                }
+                ++*count;
+                *size += dl.drec()->lengthWithHeaders;
+            }
+        }
+        return complete;
+    }
+
     void NamespaceDetails::dumpDeleted(set<DiskLoc> *extents) {
         for ( int i = 0; i < Buckets; i++ ) {
             DiskLoc dl = deletedList[i];
@@ -573,6 +606,35 @@ namespace mongo {
     map< string, shared_ptr< NamespaceDetailsTransient > > NamespaceDetailsTransient::_map;
     typedef map< string, shared_ptr< NamespaceDetailsTransient > >::iterator ouriter;
 
+    void NamespaceDetailsTransient::clearQueryCache() {
+        QueryPlanCache::get().clear( _ns );
+        _qcWriteCount = 0;
+        _qcHavePlans = false;
+    }
+
+    BSONObj NamespaceDetailsTransient::indexForPattern( const QueryPattern &pattern ) {
+        CachedPlan p;
+        if ( !QueryPlanCache::get().find( _ns, pattern, p ) )
+            return BSONObj();
+        return p.indexKey;
+    }
+
+    long long NamespaceDetailsTransient::nScannedForPattern( const QueryPattern &pattern ) {
+        CachedPlan p;
+        if ( !QueryPlanCache::get().find( _ns, pattern, p ) )
+            return 0;
+        return p.nScanned;
+    }
+
+    void NamespaceDetailsTransient::registerIndexForPattern( const QueryPattern &pattern, const BSONObj &indexKey, long long nScanned, long long millis ) {
+        if ( indexKey.isEmpty() ) {
+            QueryPlanCache::get().noteReplan( _ns, pattern, true );
+            return;
+        }
+        QueryPlanCache::get().record( _ns, pattern, indexKey, nScanned, millis );
+        _qcHavePlans = true;
+    }
+
     void NamespaceDetailsTransient::reset() {
         DEV assertInWriteLock();
         clearQueryCache();
@@ -595,6 +657,7 @@ namespace mongo {
                 found.push_back( i->first );
         for( vector< string >::iterator i = found.begin(); i != found.end(); ++i ) {
             _map[ *i ].reset();
+            QueryPlanCache::get().clear( *i );
         }
     }
 
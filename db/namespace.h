@@ -242,9 +242,33 @@ namespace mongo {
                  this isn't thread safe.  TODO
         */
         enum NamespaceFlags {
-            Flag_HaveIdIndex = 1 << 0 // set when we have _id index (ONLY if ensureIdIndex was called -- 0 if that has never been called)
+            Flag_HaveIdIndex = 1 << 0, // set when we have _id index (ONLY if ensureIdIndex was called -- 0 if that has never been called)
+            Flag_UsePowerOf2Sizes = 1 << 1 // allocate record space in power of 2 size classes, see quantizePowerOf2AllocationSpace()
         };
 
+        bool isFlagSet( int flag ) const { return ( flags & flag ) != 0; }
+        void setFlag( int flag ) {
+            if ( !isFlagSet( flag ) )
+                getDur().writingInt( flags ) = flags | flag;
+        }
+        void clearFlag( int flag ) {
+            if ( isFlagSet( flag ) )
+                getDur().writingInt( flags ) = flags & ~flag;
+        }
+
+        /** for Flag_UsePowerOf2Sizes: round an allocation (record length with headers) up to the
+            bucket size above it.  every deleted record in bucket( quantized size ) is then big
+            enough, so __stdAlloc takes the head of the list instead of searching it, and space
+            freed by a record is reused by any record of the same size class.
+        */
+        static int quantizePowerOf2AllocationSpace( int allocSize );
+
+        /** walks the deleted lists, at most maxPerBucket records of each so a long list isn't
+            paged in.  for collStats.
+            @return false if some bucket had more, then count and size are lower bounds
+        */
+        bool deletedStats( long long *count, long long *size, int maxPerBucket ) const;
+
         IndexDetails& idx(int idxNo, bool missingExpected = false );
 
         /** get the IndexDetails for the index currently being built in the background. (there is at most one) */
@@ -390,6 +414,36 @@ namespace mongo {
     }; // NamespaceDetails
 #pragma pack()
 
+    /* CappedInsertNotifier
+
+       lets a getMore on an awaitData cursor sleep until something is added to its capped
+       collection, rather than polling.  each namespace someone has waited on gets a version,
+       bumped by every insert into it.
+    */
+    class CappedInsertNotifier {
+    public:
+        /** something was added to capped collection ns.  called with the write lock held. */
+        static void notify( const char *ns );
+
+        /** call with the db lock held, then release it and pass the result to wait() */
+        static unsigned long long version( const char *ns );
+
+        /** waits up to millis for an insert into ns after version v.  do not hold the db lock.
+            @return true if there was one
+        */
+        static bool wait( const char *ns , unsigned long long v , int millis );
+
+    private:
+        struct Waiters {
+            Waiters() : version( 0 ) { }
+            unsigned long long version;
+            boost::condition changed;
+        };
+        static mongo::mutex _m;
+        static map< string , shared_ptr<Waiters> > _waiters;
+        static volatile bool _any; // skip the lock in notify() until someone has waited
+    };
+
     /* NamespaceDetailsTransient
 
        these are things we know / compute about a namespace that are transient -- things
@@ -411,7 +465,7 @@ namespace mongo {
         void reset();
         static std::map< string, shared_ptr< NamespaceDetailsTransient > > _map;
     public:
-        NamespaceDetailsTransient(const char *ns) : _ns(ns), _keysComputed(false), _qcWriteCount() { }
+        NamespaceDetailsTransient(const char *ns) : _ns(ns), _keysComputed(false), _qcWriteCount(), _qcHavePlans() { }
         /* _get() is not threadsafe -- see get_inlock() comments */
         static NamespaceDetailsTransient& _get(const char *ns);
         /* use get_w() when doing write operations */
@@ -460,36 +514,30 @@ namespace mongo {
             return spec;
         }
 
-        /* query cache (for query optimizer) ------------------------------------- */
+        /* query cache (for query optimizer) -------------------------------------
+           the plans themselves are kept in QueryPlanCache, which has its own locking.
+           this is what drops them when writes may have made them stale. */
     private:
         int _qcWriteCount;
-        map< QueryPattern, pair< BSONObj, long long > > _qcCache;
+        bool _qcHavePlans; // set once a plan is recorded for _ns, so writes to uncached collections skip the clear
     public:
         static mongo::mutex _qcMutex;
         /* you must be in the qcMutex when calling this (and using the returned val): */
         static NamespaceDetailsTransient& get_inlock(const char *ns) {
             return _get(ns);
         }
-        void clearQueryCache() { // public for unit tests
-            _qcCache.clear();
-            _qcWriteCount = 0;
-        }
+        void clearQueryCache(); // public for unit tests
         /* you must notify the cache if you are doing writes, as query plan optimality will change */
         void notifyOfWriteOp() {
-            if ( _qcCache.empty() )
+            if ( !_qcHavePlans )
                 return;
             if ( ++_qcWriteCount >= 100 )
                 clearQueryCache();
         }
-        BSONObj indexForPattern( const QueryPattern &pattern ) {
-            return _qcCache[ pattern ].first;
-        }
-        long long nScannedForPattern( const QueryPattern &pattern ) {
-            return _qcCache[ pattern ].second;
-        }
-        void registerIndexForPattern( const QueryPattern &pattern, const BSONObj &indexKey, long long nScanned ) {
-            _qcCache[ pattern ] = make_pair( indexKey, nScanned );
-        }
+        /* shortcuts to QueryPlanCache for this namespace */
+        BSONObj indexForPattern( const QueryPattern &pattern );
+        long long nScannedForPattern( const QueryPattern &pattern );
+        void registerIndexForPattern( const QueryPattern &pattern, const BSONObj &indexKey, long long nScanned, long long millis = 0 );
 
     }; /* NamespaceDetailsTransient */
 
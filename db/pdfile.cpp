@@ -187,6 +187,9 @@ namespace mongo {
             return false;
         }
 
+        uassert( 13661 , "can't use usePowerOf2Sizes with a capped collection" ,
+                 !( options["usePowerOf2Sizes"].trueValue() && options.getBoolField("capped") ) );
+
         log(1) << "create collection " << ns << ' ' << options << endl;
 
         /* todo: do this only when we have allocated space successfully? or we could insert with a { ok: 0 } field
@@ -285,10 +288,13 @@ namespace mongo {
         if ( mx > 0 )
             getDur().writingInt( d->max ) = mx;
 
+        if ( options["usePowerOf2Sizes"].trueValue() )
+            d->setFlag( NamespaceDetails::Flag_UsePowerOf2Sizes );
+
         return true;
     }
 
-    /** { ..., capped: true, size: ..., max: ... }
+    /** { ..., capped: true, size: ..., max: ..., usePowerOf2Sizes: ... }
         @param deferIdIndex - if not not, defers id index creation.  sets the bool value to true if we wanted to create the id index.
         @return true if successful
     */
@@ -840,11 +846,13 @@ namespace mongo {
     }
 
     /* unindex all keys in all indexes for this record. */
-    static void unindexRecord(NamespaceDetails *d, Record *todelete, const DiskLoc& dl, bool noWarn = false) {
+    static void unindexRecord(NamespaceDetails *d, Record *todelete, const DiskLoc& dl, bool noWarn = false, int skipIndex = -1) {
         BSONObj obj(todelete);
         int n = d->nIndexes;
-        for ( int i = 0; i < n; i++ )
-            _unindexRecord(d->idx(i), obj, dl, !noWarn);
+        for ( int i = 0; i < n; i++ ) {
+            if ( i != skipIndex )
+                _unindexRecord(d->idx(i), obj, dl, !noWarn);
+        }
         if( d->indexBuildInProgress ) { // background index
             // always pass nowarn here, as this one may be missing for valid reasons as we are concurrently building it
             _unindexRecord(d->idx(n), obj, dl, false);
@@ -907,7 +915,7 @@ namespace mongo {
         }
     }
 
-    void DataFileMgr::deleteRecord(const char *ns, Record *todelete, const DiskLoc& dl, bool cappedOK, bool noWarn) {
+    void DataFileMgr::deleteRecord(const char *ns, Record *todelete, const DiskLoc& dl, bool cappedOK, bool noWarn, int skipIndex) {
         dassert( todelete == dl.rec() );
 
         NamespaceDetails* d = nsdetails(ns);
@@ -920,7 +928,7 @@ namespace mongo {
         /* check if any cursors point to us.  if so, advance them. */
         ClientCursor::aboutToDelete(dl);
 
-        unindexRecord(d, todelete, dl, noWarn);
+        unindexRecord(d, todelete, dl, noWarn, skipIndex);
 
         _deleteRecord(d, ns, todelete, dl);
         NamespaceDetailsTransient::get_w( ns ).notifyOfWriteOp();
@@ -1100,6 +1108,85 @@ namespace mongo {
         }
     }
 
+    /** keys for a batch of records, extracted on several threads for fastBuildIndex.
+        the records must stay put until extract() returns - we hold the write lock.
+    */
+    class KeyBatch : boost::noncopyable {
+    public:
+        KeyBatch( const IndexSpec& spec , int threads ) :
+            _spec( spec ) , _threads( threads ) , _errCode( 0 ) , _m( "KeyBatch" ) {
+            if ( _threads > 1 )
+                _pool.reset( new ThreadPool( _threads ) );
+        }
+
+        bool full() const { return _records.size() >= ( _threads > 1 ? 1000U * _threads : 1U ); }
+        unsigned size() const { return _records.size(); }
+        void add( const BSONObj& o , const DiskLoc& loc ) { _records.push_back( make_pair( o , loc ) ); }
+        void clear() { _records.clear(); }
+
+        const DiskLoc& loc( unsigned i ) const { return _records[i].second; }
+        BSONObjSetDefaultOrder& keys( unsigned i ) { return _keys[i]; }
+
+        void extract() {
+            _keys.clear();
+            _keys.resize( _records.size() );
+            if ( !_pool ) {
+                extractRange( 0 , _records.size() );
+                return;
+            }
+            unsigned per = ( _records.size() + _threads - 1 ) / _threads;
+            for ( unsigned b = 0; b < _records.size(); b += per )
+                _pool->schedule( &KeyBatch::extractThread , this , b , min( b + per , (unsigned) _records.size() ) );
+            _pool->join();
+            scoped_lock lk( _m );
+            if ( _errCode )
+                uasserted( _errCode , _err );
+        }
+
+    private:
+        void extractRange( unsigned begin , unsigned end ) {
+            for ( unsigned i = begin; i < end; i++ )
+                _spec.getKeys( _records[i].first , _keys[i] );
+        }
+
+        void extractThread( unsigned begin , unsigned end ) {
+            try {
+                extractRange( begin , end );
+            }
+            catch ( DBException& e ) {
+                setError( e.getCode() , e.what() );
+            }
+            catch ( std::exception& e ) {
+                setError( 13660 , e.what() );
+            }
+        }
+
+        void setError( int code , const string& msg ) {
+            scoped_lock lk( _m );
+            if ( !_errCode ) {
+                _errCode = code;
+                _err = msg;
+            }
+        }
+
+        const IndexSpec& _spec;
+        int _threads;
+        scoped_ptr<ThreadPool> _pool;
+        vector< pair<BSONObj,DiskLoc> > _records;
+        vector< BSONObjSetDefaultOrder > _keys;
+        int _errCode;
+        string _err;
+        mongo::mutex _m;
+    };
+
+    /** threads for key extraction and for sorting in fastBuildIndex; 1 means do it all inline */
+    static int indexBuildThreads( const IndexSpec& spec ) {
+        // index plugins haven't been audited for use off the client's thread
+        if ( spec.getType() )
+            return 1;
+        return max( 1 , min( (int) boost::thread::hardware_concurrency() , 8 ) );
+    }
+
     // throws DBException
     unsigned long long fastBuildIndex(const char *ns, NamespaceDetails *d, IndexDetails& idx, int idxNo) {
         CurOp * op = cc().curop();
@@ -1121,22 +1208,16 @@ namespace mongo {
         shared_ptr<Cursor> c = theDataFileMgr.findAll(ns);
         BSONObjExternalSorter sorter(order);
         sorter.hintNumObjects( d->stats.nrecords );
+        const IndexSpec& spec = idx.getSpec();
+        int threads = indexBuildThreads( spec );
+        if ( threads > 1 )
+            sorter.useThreads( threads );
+        log(1) << "\t fastBuildIndex using " << threads << " threads" << endl;
+        KeyBatch batch( spec , threads );
         unsigned long long nkeys = 0;
         ProgressMeterHolder pm( op->setMessage( "index: (1/3) external sort" , d->stats.nrecords , 10 ) );
         while ( c->ok() ) {
-            BSONObj o = c->current();
-            DiskLoc loc = c->currLoc();
-
-            BSONObjSetDefaultOrder keys;
-            idx.getKeysFromObject(o, keys);
-            int k = 0;
-            for ( BSONObjSetDefaultOrder::iterator i=keys.begin(); i != keys.end(); i++ ) {
-                if( ++k == 2 ) {
-                    d->setIndexIsMultikey(idxNo);
-                }
-                sorter.add(*i, loc);
-                nkeys++;
-            }
+            batch.add( c->current() , c->currLoc() );
 
             c->advance();
             n++;
@@ -1145,6 +1226,22 @@ namespace mongo {
                 printMemInfo( "\t iterating objects" );
             }
 
+            if ( !batch.full() && c->ok() )
+                continue;
+
+            batch.extract();
+            for ( unsigned r = 0; r < batch.size(); r++ ) {
+                BSONObjSetDefaultOrder& keys = batch.keys( r );
+                int k = 0;
+                for ( BSONObjSetDefaultOrder::iterator i=keys.begin(); i != keys.end(); i++ ) {
+                    if( ++k == 2 ) {
+                        d->setIndexIsMultikey(idxNo);
+                    }
+                    sorter.add(*i, batch.loc( r ));
+                    nkeys++;
+                }
+            }
+            batch.clear();
         };
         pm.finished();
 
@@ -1547,12 +1644,18 @@ namespace mongo {
 
         DiskLoc extentLoc;
         int lenWHdr = len + Record::HeaderSize;
-        lenWHdr = (int) (lenWHdr * d->paddingFactor);
-        if ( lenWHdr == 0 ) {
-            // old datafiles, backward compatible here.
-            assert( d->paddingFactor == 0 );
-            *getDur().writing(&d->paddingFactor) = 1.0;
-            lenWHdr = len + Record::HeaderSize;
+        if ( d->isFlagSet( NamespaceDetails::Flag_UsePowerOf2Sizes ) && !d->capped ) {
+            // the size class leaves room to grow, so no paddingFactor
+            lenWHdr = NamespaceDetails::quantizePowerOf2AllocationSpace( lenWHdr );
+        }
+        else {
+            lenWHdr = (int) (lenWHdr * d->paddingFactor);
+            if ( lenWHdr == 0 ) {
+                // old datafiles, backward compatible here.
+                assert( d->paddingFactor == 0 );
+                *getDur().writing(&d->paddingFactor) = 1.0;
+                lenWHdr = len + Record::HeaderSize;
+            }
         }
 
         // If the collection is capped, check if the new object will violate a unique index
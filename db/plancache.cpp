@@ -0,0 +1,188 @@
+// plancache.cpp
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "plancache.h"
+
+namespace mongo {
+
+    void CachedPlan::append( BSONObjBuilder& b ) const {
+        if ( indexKey.isEmpty() )
+            b.appendNull( "index" );
+        else
+            b.append( "index" , indexKey );
+        b.appendNumber( "nscanned" , nScanned );
+        b.appendNumber( "runs" , runs );
+        b.append( "avgNScanned" , runs ? (double) totalNScanned / runs : 0.0 );
+        b.append( "avgMillis" , runs ? (double) totalMillis / runs : 0.0 );
+        b.append( "replans" , replans );
+        b.appendNumber( "uses" , uses );
+    }
+
+    QueryPlanCache& QueryPlanCache::get() {
+        static QueryPlanCache *c = new QueryPlanCache();
+        return *c;
+    }
+
+    unsigned QueryPlanCache::hashString( const string& s ) {
+        unsigned x = 0;
+        for ( const char *p = s.c_str(); *p; ++p )
+            x = x * 131 + *p;
+        return x;
+    }
+
+    QueryPlanCache::Entry* QueryPlanCache::Stripe::find( const string& ns , const QueryPattern& pattern ) {
+        map< string , map< QueryPattern , Entry > >::iterator i = plans.find( ns );
+        if ( i == plans.end() )
+            return 0;
+        map< QueryPattern , Entry >::iterator j = i->second.find( pattern );
+        if ( j == i->second.end() )
+            return 0;
+        // it's in use, so to the front
+        lru.splice( lru.begin() , lru , j->second.lru );
+        return &j->second;
+    }
+
+    void QueryPlanCache::Stripe::evict( const Key& k ) {
+        map< string , map< QueryPattern , Entry > >::iterator i = plans.find( k.first );
+        assert( i != plans.end() );
+        map< QueryPattern , Entry >::iterator j = i->second.find( k.second );
+        assert( j != i->second.end() );
+        lru.erase( j->second.lru );
+        i->second.erase( j );
+        if ( i->second.empty() )
+            plans.erase( i );
+        size--;
+    }
+
+    bool QueryPlanCache::find( const string& ns , const QueryPattern& pattern , CachedPlan& plan ) {
+        Stripe& s = stripe( ns , pattern );
+        scoped_lock lk( s.m );
+        Entry *e = s.find( ns , pattern );
+        if ( ! e || e->plan.indexKey.isEmpty() ) {
+            s.misses++;
+            return false;
+        }
+        s.hits++;
+        e->plan.uses++;
+        plan = e->plan;
+        return true;
+    }
+
+    void QueryPlanCache::record( const string& ns , const QueryPattern& pattern , const BSONObj& indexKey , long long nScanned , long long millis ) {
+        Stripe& s = stripe( ns , pattern );
+        scoped_lock lk( s.m );
+        Entry *e = s.find( ns , pattern );
+        if ( ! e ) {
+            s.lru.push_front( Key( ns , pattern ) );
+            e = &s.plans[ ns ].insert( make_pair( pattern , Entry() ) ).first->second;
+            e->lru = s.lru.begin();
+            s.size++;
+        }
+
+        // how often it gets replaced is the interesting part, so replans carry over
+        int replans = e->plan.replans;
+        e->plan = CachedPlan();
+        e->plan.indexKey = indexKey.getOwned();
+        e->plan.nScanned = nScanned;
+        e->plan.runs = 1;
+        e->plan.totalNScanned = nScanned;
+        e->plan.totalMillis = millis;
+        e->plan.replans = replans;
+
+        while ( s.size > Capacity / Stripes ) {
+            Key k = s.lru.back();
+            s.evict( k );
+            s.evictions++;
+        }
+    }
+
+    void QueryPlanCache::noteRun( const string& ns , const QueryPattern& pattern , long long nScanned , long long millis ) {
+        Stripe& s = stripe( ns , pattern );
+        scoped_lock lk( s.m );
+        Entry *e = s.find( ns , pattern );
+        if ( ! e || e->plan.indexKey.isEmpty() )
+            return;
+        e->plan.runs++;
+        e->plan.totalNScanned += nScanned;
+        e->plan.totalMillis += millis;
+    }
+
+    void QueryPlanCache::noteReplan( const string& ns , const QueryPattern& pattern , bool drop ) {
+        Stripe& s = stripe( ns , pattern );
+        scoped_lock lk( s.m );
+        Entry *e = s.find( ns , pattern );
+        if ( ! e )
+            return;
+        e->plan.replans++;
+        if ( drop )
+            e->plan.indexKey = BSONObj();
+    }
+
+    void QueryPlanCache::clear( const string& ns ) {
+        for ( int i = 0; i < Stripes; i++ ) {
+            Stripe& s = _stripes[i];
+            scoped_lock lk( s.m );
+            map< string , map< QueryPattern , Entry > >::iterator j = s.plans.find( ns );
+            if ( j == s.plans.end() )
+                continue;
+            for ( map< QueryPattern , Entry >::iterator k = j->second.begin(); k != j->second.end(); ++k ) {
+                s.lru.erase( k->second.lru );
+                s.size--;
+            }
+            s.plans.erase( j );
+        }
+    }
+
+    void QueryPlanCache::appendStats( const string& ns , BSONObjBuilder& b ) {
+        b.append( "ns" , ns );
+        BSONArrayBuilder arr( b.subarrayStart( "plans" ) );
+        for ( int i = 0; i < Stripes; i++ ) {
+            Stripe& s = _stripes[i];
+            scoped_lock lk( s.m );
+            map< string , map< QueryPattern , Entry > >::iterator j = s.plans.find( ns );
+            if ( j == s.plans.end() )
+                continue;
+            for ( map< QueryPattern , Entry >::iterator k = j->second.begin(); k != j->second.end(); ++k ) {
+                BSONObjBuilder o( arr.subobjStart() );
+                o.append( "pattern" , k->first.toBSON() );
+                k->second.plan.append( o );
+                o.done();
+            }
+        }
+        arr.done();
+    }
+
+    void QueryPlanCache::appendSummary( BSONObjBuilder& b ) {
+        long long plans = 0, hits = 0, misses = 0, evictions = 0;
+        for ( int i = 0; i < Stripes; i++ ) {
+            Stripe& s = _stripes[i];
+            scoped_lock lk( s.m );
+            plans += s.size;
+            hits += s.hits;
+            misses += s.misses;
+            evictions += s.evictions;
+        }
+        b.appendNumber( "plans" , plans );
+        b.append( "capacity" , (int) Capacity );
+        b.appendNumber( "hits" , hits );
+        b.appendNumber( "misses" , misses );
+        b.appendNumber( "evictions" , evictions );
+    }
+
+}
@@ -0,0 +1,117 @@
+// plancache.h
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../pch.h"
+#include "jsobj.h"
+#include "queryutil.h"
+
+namespace mongo {
+
+    /**
+     * the plan QueryPlanSet recorded for a query pattern, and how it has done since.
+     */
+    struct CachedPlan {
+        CachedPlan() : nScanned(), runs(), totalNScanned(), totalMillis(), replans(), uses() { }
+
+        BSONObj indexKey;        // { $natural : 1 } for a table scan, empty if the plan was dropped
+        long long nScanned;      // by the run that recorded it; later runs are measured against it
+
+        long long runs;          // completed runs of the plan, including the one that recorded it
+        long long totalNScanned;
+        long long totalMillis;
+        int replans;             // times it did so badly the candidate plans were raced again
+        long long uses;          // lookups that found it
+
+        void append( BSONObjBuilder& b ) const;
+    };
+
+    /**
+     * the query optimizer's memory of which index won for each query pattern of each collection.
+     *
+     * holds at most Capacity plans; once full, the least recently used one goes.  the plans are
+     * spread over Stripes independently locked parts by collection and pattern, so queries don't
+     * queue on one mutex to look up their plan, and none of it depends on the db lock.
+     *
+     * a collection's plans are dropped when its indexes change, when it is dropped, and after
+     * every so many writes to it (see NamespaceDetailsTransient::notifyOfWriteOp()).
+     */
+    class QueryPlanCache : boost::noncopyable {
+    public:
+        enum { Stripes = 16 , Capacity = 4096 };
+
+        static QueryPlanCache& get();
+
+        /** @return false if there is no plan for pattern */
+        bool find( const string& ns , const QueryPattern& pattern , CachedPlan& plan );
+
+        /** remember indexKey as the winner for pattern.  its stats start over, except replans */
+        void record( const string& ns , const QueryPattern& pattern , const BSONObj& indexKey , long long nScanned , long long millis );
+
+        /** a run of the recorded plan finished */
+        void noteRun( const string& ns , const QueryPattern& pattern , long long nScanned , long long millis );
+
+        /** the recorded plan scanned too much so the other plans are racing it again.
+            @param drop forget its index too, it will be replaced
+        */
+        void noteReplan( const string& ns , const QueryPattern& pattern , bool drop );
+
+        /** forget every plan for ns */
+        void clear( const string& ns );
+
+        /** { ns, plans : [ { pattern, index, nscanned, runs, avgNScanned, avgMillis, replans, uses } ] } */
+        void appendStats( const string& ns , BSONObjBuilder& b );
+
+        /** { plans, capacity, hits, misses, evictions } for all collections */
+        void appendSummary( BSONObjBuilder& b );
+
+    private:
+        QueryPlanCache() { }
+
+        typedef pair< string , QueryPattern > Key;
+        typedef list< Key > LRU; // most recently used first
+
+        struct Entry {
+            CachedPlan plan;
+            LRU::iterator lru;
+        };
+
+        struct Stripe : boost::noncopyable {
+            Stripe() : m( "QueryPlanCache" ), size(), hits(), misses(), evictions() { }
+            mongo::mutex m;
+            map< string , map< QueryPattern , Entry > > plans;
+            LRU lru;
+            unsigned size;
+            long long hits;
+            long long misses;
+            long long evictions;
+
+            Entry* find( const string& ns , const QueryPattern& pattern );
+            void evict( const Key& k );
+        };
+
+        Stripe& stripe( const string& ns , const QueryPattern& pattern ) {
+            return _stripes[ ( hashString( ns ) ^ pattern.hash() ) % Stripes ];
+        }
+        static unsigned hashString( const string& s );
+
+        Stripe _stripes[ Stripes ];
+    };
+
+}
@@ -279,18 +279,44 @@ namespace mongo {
         return qr;
     }
 
-    QueryResult* processGetMore(const char *ns, int ntoreturn, long long cursorid , CurOp& curop, int pass, bool& exhaust ) {
+    ReplyBuffers::~ReplyBuffers() {
+        for ( unsigned i = 0; i < _full.size(); i++ )
+            free( _full[i].first );
+    }
+
+    BufBuilder& ReplyBuffers::reserve( int size ) {
+        int room = _cur->getSize() - _cur->len();
+        // while a buffer is small, growing it is cheap
+        if ( size <= room || _cur->len() < _cur->getSize() / 2 )
+            return *_cur;
+
+        _full.push_back( make_pair( _cur->buf() , _cur->len() ) );
+        _fullBytes += _cur->len();
+        int next = min( _cur->getSize() * 2 , (int) MaxBufferSize );
+        _cur->decouple();
+        _cur.reset( new BufBuilder( max( next , size ) ) );
+        return *_cur;
+    }
+
+    void ReplyBuffers::appendTo( Message& m ) {
+        for ( unsigned i = 0; i < _full.size(); i++ )
+            m.appendData( _full[i].first , _full[i].second );
+        _full.clear();
+        _fullBytes = 0;
+
+        if ( _cur->len() ) {
+            m.appendData( _cur->buf() , _cur->len() );
+            _cur->decouple();
+            _cur.reset( new BufBuilder( 512 ) );
+        }
+    }
+
+    void processGetMore(const char *ns, int ntoreturn, long long cursorid , CurOp& curop, int pass, bool& exhaust, Message& response) {
         exhaust = false;
         ClientCursor::Pointer p(cursorid);
         ClientCursor *cc = p.c();
 
-        int bufSize = 512;
-        if ( cc ) {
-            bufSize += sizeof( QueryResult );
-            bufSize += MaxBytesToReturnToClientAtOnce;
-        }
-
-        BufBuilder b( bufSize );
+        ReplyBuffers b;
 
         b.skip(sizeof(QueryResult));
 
@@ -334,7 +360,7 @@ namespace mongo {
                             continue;
 
                         if( n == 0 && (queryOptions & QueryOption_AwaitData) && pass < 1000 ) {
-                            throw GetMoreWaitException();
+                            throw GetMoreWaitException( CappedInsertNotifier::version( ns ) );
                         }
 
                         break;
@@ -364,12 +390,13 @@ namespace mongo {
                         n++;
 
                         if ( keyFieldsOnly ) {
-                            fillQueryResultFromObj(b, 0, keyFieldsOnly->hydrate( c->currKey() ) );
+                            BSONObj key = keyFieldsOnly->hydrate( c->currKey() );
+                            fillQueryResultFromObj(b.reserve( key.objsize() ), 0, key );
                         }
                         else {
                             BSONObj js = c->current();
                             // show disk loc should be part of the main query, not in an $or clause, so this should be ok
-                            fillQueryResultFromObj(b, cc->fields.get(), js, ( cc->pq.get() && cc->pq->showDiskLoc() ? &last : 0));
+                            fillQueryResultFromObj(b.reserve( js.objsize() ), cc->fields.get(), js, ( cc->pq.get() && cc->pq->showDiskLoc() ? &last : 0));
                         }
 
                         if ( ( ntoreturn && n >= ntoreturn ) || b.len() > MaxBytesToReturnToClientAtOnce ) {
@@ -398,16 +425,14 @@ namespace mongo {
             }
         }
 
-        QueryResult *qr = (QueryResult *) b.buf();
-        qr->len = b.len();
+        b.appendTo( response );
+        QueryResult *qr = (QueryResult *) response.header();
+        // qr->len is updated automatically by appendData()
         qr->setOperation(opReply);
         qr->_resultFlags() = resultFlags;
         qr->cursorId = cursorid;
         qr->startingFrom = start;
         qr->nReturned = n;
-        b.decouple();
-
-        return qr;
     }
 
     class CountOp : public QueryOp {
@@ -642,8 +667,9 @@ namespace mongo {
     public:
 
         UserQueryOp( const ParsedQuery& pq, Message &response, ExplainBuilder &eb, CurOp &curop ) :
-            _buf( 32768 ) , // TODO be smarter here
+            _buf( 32768 ) ,
             _pq( pq ) ,
+            _indexOnly( false ) ,
             _ntoskip( pq.getSkip() ) ,
             _nscanned(0), _oldNscanned(0), _nscannedObjects(0), _oldNscannedObjects(0),
             _n(0),
@@ -687,6 +713,12 @@ namespace mongo {
                 _so.reset( new ScanAndOrder( _pq.getSkip() , _pq.getNumToReturn() , _pq.getOrder() ) );
             }
 
+            // covered: the index key answers the predicate, the projection, and if needed the sort
+            // and the chunk check, so we never dereference the record
+            _indexOnly = _keyFieldsOnly && matcher()->keyOnly() &&
+                         ( ! _inMemSort || keyPatternHasFields( _c->indexKeyPattern() , _pq.getOrder() ) ) &&
+                         ( ! _chunkManager || keyPatternHasFields( _c->indexKeyPattern() , _chunkManager->getKey() ) );
+
             if ( _pq.isExplain() ) {
                 _eb.noteCursor( _c.get() );
             }
@@ -772,9 +804,10 @@ namespace mongo {
                     _nscannedObjects++;
             }
             else {
-                _nscannedObjects++;
+                if ( ! _indexOnly )
+                    _nscannedObjects++;
                 DiskLoc cl = _c->currLoc();
-                if ( _chunkManager && ! _chunkManager->belongsToMe( cl.obj() ) ) {
+                if ( _chunkManager && ! _chunkManager->belongsToMe( _indexOnly ? namedKey() : cl.obj() ) ) {
                     _nChunkSkips++;
                     // log() << "TEMP skipping un-owned chunk: " << _c->current() << endl;
                 }
@@ -786,7 +819,8 @@ namespace mongo {
 
                     if ( _inMemSort ) {
                         // note: no cursors for non-indexed, ordered results.  results must be fairly small.
-                        _so->add( _pq.returnKey() ? _c->currKey() : _c->current(), _pq.showDiskLoc() ? &cl : 0 );
+                        _so->add( _pq.returnKey() ? _c->currKey() : ( _indexOnly ? namedKey() : _c->current() ),
+                                  _pq.showDiskLoc() ? &cl : 0 );
                     }
                     else if ( _ntoskip > 0 ) {
                         _ntoskip--;
@@ -803,12 +837,14 @@ namespace mongo {
                         else {
 
                             if ( _pq.returnKey() ) {
-                                BSONObjBuilder bb( _buf );
+                                BSONObjBuilder bb( _buf.reserve( 0 ) );
                                 bb.appendKeys( _c->indexKeyPattern() , _c->currKey() );
                                 bb.done();
                             }
                             else if ( _keyFieldsOnly ) {
-                                fillQueryResultFromObj( _buf , 0 , _keyFieldsOnly->hydrate( _c->currKey() ) );
+                                BSONObj key = _keyFieldsOnly->hydrate( _c->currKey() );
+                                fillQueryResultFromObj( _buf.reserve( key.objsize() ) , 0 , key ,
+                                                        ( _pq.showDiskLoc() ? &cl : 0 ) );
                             }
                             else {
                                 BSONObj js = _c->current();
@@ -820,7 +856,7 @@ namespace mongo {
                                         _slaveReadTill = e._opTime();
                                 }
 
-                                fillQueryResultFromObj( _buf , _pq.getFields() , js , (_pq.showDiskLoc() ? &cl : 0));
+                                fillQueryResultFromObj( _buf.reserve( js.objsize() ) , _pq.getFields() , js , (_pq.showDiskLoc() ? &cl : 0));
                             }
                             _n++;
                             if ( ! _c->supportGetMore() ) {
@@ -856,7 +892,7 @@ namespace mongo {
             }
             else if ( _inMemSort ) {
                 if( _so.get() )
-                    _so->fill( _buf, _pq.getFields() , _n );
+                    _so->fill( _buf.reserve( 0 ), _pq.getFields() , _n );
             }
 
             if ( _c.get() ) {
@@ -874,13 +910,10 @@ namespace mongo {
                 massert( 13638, "client cursor dropped during explain query yield", _c.get() );
                 _eb.noteScan( _c.get(), _nscanned, _nscannedObjects, _n, scanAndOrderRequired(),
                               _curop.elapsedMillis(), useHints && !_pq.getHint().eoo(), _nYields ,
-                              _nChunkSkips, _keyFieldsOnly.get() > 0 );
+                              _nChunkSkips, _indexOnly );
             }
             else {
-                if ( _buf.len() ) {
-                    _response.appendData( _buf.buf(), _buf.len() );
-                    _buf.decouple();
-                }
+                _buf.appendTo( _response );
             }
 
             if ( stop ) {
@@ -894,11 +927,10 @@ namespace mongo {
 
         void finishExplain( const BSONObj &suffix ) {
             BSONObj obj = _eb.finishWithSuffix( totalNscanned(), nscannedObjects(), n(), _curop.elapsedMillis(), suffix);
-            fillQueryResultFromObj(_buf, 0, obj);
+            fillQueryResultFromObj(_buf.reserve( obj.objsize() ), 0, obj);
             _n = 1;
             _oldN = 0;
-            _response.appendData( _buf.buf(), _buf.len() );
-            _buf.decouple();
+            _buf.appendTo( _response );
         }
 
         virtual bool mayRecordPlan() const {
@@ -931,9 +963,28 @@ namespace mongo {
 
         }
     private:
-        BufBuilder _buf;
+        /** @return true if each field of fields is a top level field of keyPattern */
+        static bool keyPatternHasFields( const BSONObj &keyPattern , const BSONObj &fields ) {
+            BSONObjIterator i( fields );
+            while ( i.more() ) {
+                const char *f = i.next().fieldName();
+                if ( strchr( f , '.' ) || keyPattern[ f ].eoo() )
+                    return false;
+            }
+            return true;
+        }
+
+        /** the current key with the key pattern's field names, e.g. { a : 3 , b : "x" } */
+        BSONObj namedKey() const {
+            BSONObjBuilder b;
+            b.appendKeys( _c->indexKeyPattern() , _c->currKey() );
+            return b.obj();
+        }
+
+        ReplyBuffers _buf;
         const ParsedQuery& _pq;
         scoped_ptr<Projection::KeyOnly> _keyFieldsOnly;
+        bool _indexOnly; // answer entirely from the index key, see _init()
 
         long long _ntoskip;
         long long _nscanned;
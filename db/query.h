@@ -74,10 +74,46 @@ namespace mongo {
 
     extern const int MaxBytesToReturnToClientAtOnce;
 
-    // for an existing query (ie a ClientCursor), send back additional information.
-    struct GetMoreWaitException { };
+    /* an awaitData cursor is at the end: release the lock and wait for an insert.
+       version is CappedInsertNotifier::version() of the collection, read under the lock.
+    */
+    struct GetMoreWaitException {
+        GetMoreWaitException( unsigned long long v ) : version( v ) { }
+        unsigned long long version;
+    };
+
+    /* the documents of a reply, kept in a chain of buffers rather than one that is realloc()ed,
+       and so copied again, every time it fills up.  the reply Message takes the buffers as they
+       are and sends them with a single sendmsg().
+    */
+    class ReplyBuffers : boost::noncopyable {
+    public:
+        ReplyBuffers( int initialSize = 32768 ) : _cur( new BufBuilder( initialSize ) ), _fullBytes( 0 ) { }
+        ~ReplyBuffers();
+
+        /** @return the buffer to append a document of about size bytes to.  if it doesn't fit
+                    the current buffer, that one is set aside and a new one started.
+        */
+        BufBuilder& reserve( int size );
 
-    QueryResult* processGetMore(const char *ns, int ntoreturn, long long cursorid , CurOp& op, int pass, bool& exhaust);
+        char* skip( int n ) { return reserve( n ).skip( n ); }
+
+        /** @return bytes so far */
+        int len() const { return _fullBytes + _cur->len(); }
+
+        /** hands the buffers to m, after any it already has, and starts over empty */
+        void appendTo( Message& m );
+
+    private:
+        enum { MaxBufferSize = 1024 * 1024 };
+        scoped_ptr<BufBuilder> _cur;
+        vector< pair< char* , int > > _full;
+        int _fullBytes;
+    };
+
+    // for an existing query (ie a ClientCursor), send back additional information.
+    // the reply goes in response, which should be empty
+    void processGetMore(const char *ns, int ntoreturn, long long cursorid , CurOp& op, int pass, bool& exhaust, Message& response);
 
     struct UpdateResult {
         bool existing; // if existing objects were modified
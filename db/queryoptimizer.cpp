@@ -24,6 +24,7 @@
 #include "queryoptimizer.h"
 #include "cmdline.h"
 #include "clientcursor.h"
+#include "plancache.h"
 #include <queue>
 
 //#define DEBUGQO(x) cout << x << endl;
@@ -234,10 +235,10 @@ doneCheckOrder:
         return _index->keyPattern();
     }
 
-    void QueryPlan::registerSelf( long long nScanned ) const {
+    void QueryPlan::registerSelf( long long nScanned, long long millis ) const {
         if ( _fbs.matchPossible() ) {
             scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
-            NamespaceDetailsTransient::get_inlock( ns() ).registerIndexForPattern( _fbs.pattern( _order ), indexKey(), nScanned );
+            NamespaceDetailsTransient::get_inlock( ns() ).registerIndexForPattern( _fbs.pattern( _order ), indexKey(), nScanned, millis );
         }
     }
 
@@ -399,34 +400,31 @@ doneCheckOrder:
             uassert( 13038 , (string)"can't find special index: " + _special + " for: " + _originalQuery.toString() , 0 );
         }
 
-        if ( _honorRecordedPlan ) {
-            scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
-            NamespaceDetailsTransient& nsd = NamespaceDetailsTransient::get_inlock( ns );
-            BSONObj bestIndex = nsd.indexForPattern( _fbs->pattern( _order ) );
-            if ( !bestIndex.isEmpty() ) {
-                QueryPlanPtr p;
-                _oldNScanned = nsd.nScannedForPattern( _fbs->pattern( _order ) );
-                if ( !strcmp( bestIndex.firstElement().fieldName(), "$natural" ) ) {
-                    // Table scan plan
-                    p.reset( new QueryPlan( d, -1, *_fbs, *_originalFrs, _originalQuery, _order ) );
-                }
+        CachedPlan recorded;
+        if ( _honorRecordedPlan && QueryPlanCache::get().find( ns, _fbs->pattern( _order ), recorded ) ) {
+            BSONObj bestIndex = recorded.indexKey;
+            QueryPlanPtr p;
+            _oldNScanned = recorded.nScanned;
+            if ( !strcmp( bestIndex.firstElement().fieldName(), "$natural" ) ) {
+                // Table scan plan
+                p.reset( new QueryPlan( d, -1, *_fbs, *_originalFrs, _originalQuery, _order ) );
+            }
 
-                NamespaceDetails::IndexIterator i = d->ii();
-                while( i.more() ) {
-                    int j = i.pos();
-                    IndexDetails& ii = i.next();
-                    if( ii.keyPattern().woCompare(bestIndex) == 0 ) {
-                        p.reset( new QueryPlan( d, j, *_fbs, *_originalFrs, _originalQuery, _order ) );
-                    }
+            NamespaceDetails::IndexIterator i = d->ii();
+            while( i.more() ) {
+                int j = i.pos();
+                IndexDetails& ii = i.next();
+                if( ii.keyPattern().woCompare(bestIndex) == 0 ) {
+                    p.reset( new QueryPlan( d, j, *_fbs, *_originalFrs, _originalQuery, _order ) );
                 }
+            }
 
-                massert( 10368 ,  "Unable to locate previously recorded index", p.get() );
-                if ( !( _bestGuessOnly && p->scanAndOrderRequired() ) ) {
-                    _usingPrerecordedPlan = true;
-                    _mayRecordPlan = false;
-                    _plans.push_back( p );
-                    return;
-                }
+            massert( 10368 ,  "Unable to locate previously recorded index", p.get() );
+            if ( !( _bestGuessOnly && p->scanAndOrderRequired() ) ) {
+                _usingPrerecordedPlan = true;
+                _mayRecordPlan = false;
+                _plans.push_back( p );
+                return;
             }
         }
 
@@ -483,10 +481,8 @@ doneCheckOrder:
             // _plans.size() > 1 if addOtherPlans was called in Runner::run().
             if ( _bestGuessOnly || res->complete() || _plans.size() > 1 )
                 return res;
-            {
-                scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
-                NamespaceDetailsTransient::get_inlock( _fbs->ns() ).registerIndexForPattern( _fbs->pattern( _order ), BSONObj(), 0 );
-            }
+            // the recorded plan isn't good for this query after all
+            QueryPlanCache::get().noteReplan( _fbs->ns(), _fbs->pattern( _order ), true );
             init();
         }
         Runner r( *this, op );
@@ -603,7 +599,10 @@ doneCheckOrder:
             nextOp( op );
             if ( op.complete() ) {
                 if ( _plans._mayRecordPlan && op.mayRecordPlan() ) {
-                    op.qp().registerSelf( op.nscanned() );
+                    op.qp().registerSelf( op.nscanned(), _timer.millis() );
+                }
+                else if ( _plans._usingPrerecordedPlan ) {
+                    QueryPlanCache::get().noteRun( _plans._fbs->ns(), _plans._fbs->pattern( _plans._order ), op.nscanned(), _timer.millis() );
                 }
                 return holder._op;
             }
@@ -613,6 +612,7 @@ doneCheckOrder:
             queue.push( holder );
             if ( !_plans._bestGuessOnly && _plans._usingPrerecordedPlan && op.nscanned() > _plans._oldNScanned * 10 && _plans._special.empty() ) {
                 holder._offset = -op.nscanned();
+                QueryPlanCache::get().noteReplan( _plans._fbs->ns(), _plans._fbs->pattern( _plans._order ), false );
                 _plans.addOtherPlans( true );
                 PlanSet::iterator i = _plans._plans.begin();
                 ++i;
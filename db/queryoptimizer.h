@@ -23,6 +23,7 @@
 #include "queryutil.h"
 #include "matcher.h"
 #include "../util/message.h"
+#include "../util/timer.h"
 
 namespace mongo {
 
@@ -64,7 +65,8 @@ namespace mongo {
         BSONObj originalQuery() const { return _originalQuery; }
         BSONObj simplifiedQuery( const BSONObj& fields = BSONObj() ) const { return _fbs.simplifiedQuery( fields ); }
         const FieldRange &range( const char *fieldName ) const { return _fbs.range( fieldName ); }
-        void registerSelf( long long nScanned ) const;
+        /** record this as the plan to use for queries like this one */
+        void registerSelf( long long nScanned, long long millis = 0 ) const;
         shared_ptr< FieldRangeVector > originalFrv() const { return _originalFrv; }
         // just for testing
         shared_ptr< FieldRangeVector > frv() const { return _frv; }
@@ -225,6 +227,7 @@ namespace mongo {
             void mayYield( const vector< shared_ptr< QueryOp > > &ops );
             QueryOp &_op;
             QueryPlanSet &_plans;
+            Timer _timer;
             static void initOp( QueryOp &op );
             static void nextOp( QueryOp &op );
             static bool prepareToYield( QueryOp &op );
@@ -779,6 +779,24 @@ namespace mongo {
         return qp;
     }
 
+    BSONObj QueryPattern::toBSON() const {
+        BSONObjBuilder b;
+        {
+            BSONObjBuilder f( b.subobjStart( "fields" ) );
+            for( map< string, Type >::const_iterator i = _fieldTypes.begin(); i != _fieldTypes.end(); ++i ) {
+                switch( i->second ) {
+                case Equality: f.append( i->first, "eq" ); break;
+                case LowerBound: f.append( i->first, "gt" ); break;
+                case UpperBound: f.append( i->first, "lt" ); break;
+                case UpperAndLowerBound: f.append( i->first, "range" ); break;
+                }
+            }
+            f.done();
+        }
+        b.append( "sort", _sort );
+        return b.obj();
+    }
+
     // TODO get rid of this
     BoundList FieldRangeSet::indexBounds( const BSONObj &keyPattern, int direction ) const {
         typedef vector< pair< shared_ptr< BSONObjBuilder >, shared_ptr< BSONObjBuilder > > > BoundBuilders;
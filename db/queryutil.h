@@ -164,6 +164,18 @@ namespace mongo {
                 return true;
             return _sort.woCompare( other._sort ) < 0;
         }
+        /** patterns that are == hash the same */
+        unsigned hash() const {
+            unsigned x = 0;
+            for( map< string, Type >::const_iterator i = _fieldTypes.begin(); i != _fieldTypes.end(); ++i ) {
+                for( const char *p = i->first.c_str(); *p; ++p )
+                    x = x * 131 + *p;
+                x = x * 131 + i->second;
+            }
+            return x ^ _sort.hash();
+        }
+        /** { fields : { a : "eq", b : "lt", ... }, sort : { ... } } */
+        BSONObj toBSON() const;
     private:
         QueryPattern() {}
         void setSort( const BSONObj sort ) {
@@ -37,6 +37,7 @@
 #include "oplog.h"
 #include "../util/concurrency/thread_pool.h"
 #include "oplogreader.h"
+#include "cloner.h"
 
 namespace mongo {
 
@@ -62,17 +63,17 @@ namespace mongo {
 
         int slavedelay;
 
+        /* number of collections a replica set member clones at once during initial sync */
+        int initialSyncThreads;
+
         ReplSettings()
-            : slave(NotSlave) , master(false) , opIdMem(100000000) , fastsync() , autoresync(false), slavedelay() {
+            : slave(NotSlave) , master(false) , opIdMem(100000000) , fastsync() , autoresync(false), slavedelay(), initialSyncThreads(4) {
         }
 
     };
 
     extern ReplSettings replSettings;
 
-    bool cloneFrom(const char *masterHost, string& errmsg, const string& fromdb, bool logForReplication,
-                   bool slaveOk, bool useReplAuth, bool snapshot);
-
     /* A replication exception */
     class SyncException : public DBException {
     public:
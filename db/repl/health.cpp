@@ -367,6 +367,11 @@ namespace mongo {
             string s = _self->lhb();
             if( !s.empty() )
                 bb.append("errmsg", s);
+            if( _initialSyncProgress.active() ) {
+                BSONObjBuilder is( bb.subobjStart("initialSync") );
+                _initialSyncProgress.append(is);
+                is.done();
+            }
             bb.append("self", true);
             v.push_back(bb.obj());
         }
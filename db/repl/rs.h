@@ -27,6 +27,7 @@
 #include "rs_optime.h"
 #include "rs_member.h"
 #include "rs_config.h"
+#include "../cloner.h"
 
 namespace mongo {
 
@@ -337,6 +338,7 @@ namespace mongo {
 
     private:
         /* pulling data from primary related - see rs_sync.cpp */
+        CloneProgress _initialSyncProgress; // for replSetGetStatus while cloning
         bool initialSyncOplogApplication(const Member *primary, OpTime applyGTE, OpTime minValid);
         void _syncDoInitialSync();
         void syncDoInitialSync();
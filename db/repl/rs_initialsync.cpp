@@ -57,14 +57,13 @@ namespace mongo {
         }
     }
 
-    bool cloneFrom(const char *masterHost, string& errmsg, const string& fromdb, bool logForReplication,
-                   bool slaveOk, bool useReplAuth, bool snapshot);
-
-    /* todo : progress metering to sethbmsg. */
-    static bool clone(const char *master, string db) {
+    static bool clone(const char *master, string db, CloneProgress& progress) {
         string err;
-        return cloneFrom(master, err, db, false,
-                         /* slave_ok */ true, true, false);
+        bool ok = cloneFrom(master, err, db, false,
+                            /* slave_ok */ true, true, false, replSettings.initialSyncThreads, &progress);
+        if( !ok )
+            log() << "replSet initial sync error cloning " << db << " : " << err << rsLog;
+        return ok;
     }
 
     void _logOpObjRS(const BSONObj& op);
@@ -218,24 +217,31 @@ namespace mongo {
 
             sethbmsg("initial sync clone all databases", 0);
 
+            _initialSyncProgress.start();
             list<string> dbs = r.conn()->getDatabaseNames();
             for( list<string>::iterator i = dbs.begin(); i != dbs.end(); i++ ) {
                 string db = *i;
                 if( db != "local" ) {
                     sethbmsg( str::stream() << "initial sync cloning db: " << db , 0);
-                    bool ok;
-                    {
+                    bool ok = false;
+                    try {
                         writelock lk(db);
                         Client::Context ctx(db);
-                        ok = clone(sourceHostname.c_str(), db);
+                        ok = clone(sourceHostname.c_str(), db, _initialSyncProgress);
+                    }
+                    catch(...) {
+                        _initialSyncProgress.finish();
+                        throw;
                     }
                     if( !ok ) {
+                        _initialSyncProgress.finish();
                         sethbmsg( str::stream() << "initial sync error clone of " << db << " failed sleeping 5 minutes" ,0);
                         sleepsecs(300);
                         return;
                     }
                 }
             }
+            _initialSyncProgress.finish();
         }
 
         sethbmsg("initial sync query minValid",0);
@@ -20,11 +20,17 @@
 #include "rs.h"
 #include "../repl.h"
 #include "connections.h"
+#include "../oplog.h"
+#include "../../util/concurrency/thread_pool.h"
 namespace mongo {
 
     using namespace bson;
     extern unsigned replSetForceInitialSyncFailure;
 
+    /* ops applied per batch, and how long we hold the write lock applying them */
+    const unsigned ApplyBatchOps = 1000;
+    const int ApplyBatchMillis = 100;
+
     /* apply the log op that is in param o */
     void ReplSetImpl::syncApply(const BSONObj &o) {
         char db[MaxDatabaseNameLen];
@@ -245,6 +251,141 @@ namespace mongo {
         return true;
     }
 
+    /**
+     * reads the sync source's oplog on its own thread, so fetching the next batch over the
+     * network overlaps applying the current one.  a batch is owned copies of the ops of one
+     * network batch, at most ApplyBatchOps of them.  the reader is only touched by the thread
+     * until the fetcher is destroyed.
+     */
+    class OplogFetcher : boost::noncopyable {
+    public:
+        OplogFetcher(OplogReader& r) :
+            _r(r), _m("OplogFetcher"), _stop(false), _done(false), _errorCode(0),
+            _thread(boost::bind(&OplogFetcher::run, this)) {
+        }
+
+        /* waits for the thread, which might be in an awaitData wait for a few seconds */
+        ~OplogFetcher() {
+            {
+                scoped_lock lk(_m);
+                _stop = true;
+                _cond.notify_all();
+            }
+            _thread.join();
+            for( list< vector<BSONObj>* >::iterator i = _batches.begin(); i != _batches.end(); ++i )
+                delete *i;
+        }
+
+        /** @return false if nothing came in maxMillis.  rethrows a read error once the batches
+                    before it are taken.
+        */
+        bool next(vector<BSONObj>& batch, int maxMillis) {
+            scoped_lock lk(_m);
+            if( _batches.empty() && !_done ) {
+                boost::xtime xt;
+                boost::xtime_get(&xt, boost::TIME_UTC);
+                xt.sec += maxMillis / 1000;
+                xt.nsec += (maxMillis % 1000) * 1000000;
+                if( xt.nsec >= 1000000000 ) {
+                    xt.nsec -= 1000000000;
+                    xt.sec++;
+                }
+                _cond.timed_wait(lk.boost(), xt);
+            }
+            if( _batches.empty() ) {
+                if( _errorCode || !_error.empty() )
+                    throw DBException(_error.c_str(), _errorCode);
+                return false;
+            }
+            auto_ptr< vector<BSONObj> > b( _batches.front() );
+            _batches.pop_front();
+            _cond.notify_all();
+            batch.swap(*b);
+            return true;
+        }
+
+        /** the cursor is gone (or failed) and every batch has been taken */
+        bool done() {
+            scoped_lock lk(_m);
+            return _done && _batches.empty();
+        }
+
+    private:
+        void run() {
+            try {
+                while( 1 ) {
+                    {
+                        scoped_lock lk(_m);
+                        while( _batches.size() >= 2 && !_stop )
+                            _cond.wait(lk.boost());
+                        if( _stop )
+                            return;
+                    }
+
+                    if( !_r.more() ) {
+                        _r.tailCheck();
+                        if( !_r.haveCursor() ) {
+                            scoped_lock lk(_m);
+                            _done = true;
+                            _cond.notify_all();
+                            return;
+                        }
+                        continue;
+                    }
+
+                    auto_ptr< vector<BSONObj> > b( new vector<BSONObj>() );
+                    do {
+                        b->push_back( _r.nextSafe().getOwned() ); /* note we might get "not master" at some point */
+                    } while( b->size() < ApplyBatchOps && _r.moreInCurrentBatch() );
+
+                    scoped_lock lk(_m);
+                    _batches.push_back(b.release());
+                    _cond.notify_all();
+                }
+            }
+            catch( DBException& e ) {
+                scoped_lock lk(_m);
+                _error = e.what();
+                _errorCode = e.getCode();
+                _done = true;
+                _cond.notify_all();
+            }
+            catch( std::exception& e ) {
+                scoped_lock lk(_m);
+                _error = e.what();
+                _done = true;
+                _cond.notify_all();
+            }
+        }
+
+        OplogReader& _r;
+        mongo::mutex _m;
+        boost::condition _cond;
+        list< vector<BSONObj>* > _batches;
+        bool _stop;
+        bool _done;
+        string _error;
+        int _errorCode;
+        boost::thread _thread; // last, so it starts after the rest is set up
+    };
+
+    /* touch the documents a batch will update on --pretouch threads, outside the write lock, so
+       applying the batch under the lock doesn't wait on the disk.  only the sync thread calls this.
+    */
+    static void pretouchBatch(vector<BSONObj>& ops) {
+        static scoped_ptr<ThreadPool> pool;
+        int nthr = max(1, min(8, cmdLine.pretouch));
+        if( pool.get() == 0 )
+            pool.reset( new ThreadPool(nthr) );
+
+        unsigned m = max(4u, (unsigned) ops.size() / (nthr * 4));
+        for( unsigned a = 0; a < ops.size(); a += m ) {
+            unsigned b = min(a + m, (unsigned) ops.size()) - 1; // ops[a..b]
+            pool->schedule(pretouchN, boost::ref(ops), a, b);
+        }
+        pool->join();
+    }
+
     /* tail an oplog.  ok to return, will be re-called. */
     void ReplSetImpl::syncTail() {
         // todo : locking vis a vis the mgr...
@@ -341,102 +482,107 @@ namespace mongo {
             tryToGoLiveAsASecondary(minvalid);
         }
 
+        OplogFetcher fetcher(r);
+        vector<BSONObj> ops;
         while( 1 ) {
-            while( 1 ) {
-                if( !r.moreInCurrentBatch() ) {
-                    /* we need to occasionally check some things. between
-                       batches is probably a good time. */
-
-                    /* perhaps we should check this earlier? but not before the rollback checks. */
-                    if( state().recovering() ) {
-                        /* can we go to RS_SECONDARY state?  we can if not too old and if minvalid achieved */
-                        OpTime minvalid;
-                        bool golive = ReplSetImpl::tryToGoLiveAsASecondary(minvalid);
-                        if( golive ) {
-                            ;
-                        }
-                        else {
-                            sethbmsg(str::stream() << "still syncing, not yet to minValid optime" << minvalid.toString());
-                        }
+            /* we need to occasionally check some things. between
+               batches is probably a good time. */
 
-                        /* todo: too stale capability */
-                    }
+            /* perhaps we should check this earlier? but not before the rollback checks. */
+            if( state().recovering() ) {
+                /* can we go to RS_SECONDARY state?  we can if not too old and if minvalid achieved */
+                OpTime minvalid;
+                bool golive = ReplSetImpl::tryToGoLiveAsASecondary(minvalid);
+                if( golive ) {
+                    ;
+                }
+                else {
+                    sethbmsg(str::stream() << "still syncing, not yet to minValid optime" << minvalid.toString());
+                }
 
-                    {
-                        const Member *primary = box.getPrimary();
-                        
-                        if( !target->hbinfo().hbstate.readable() ||
-                            // if we are not syncing from the primary, return (if
-                            // it's up) so that we can try accessing it again
-                            (target != primary && primary != 0)) {
-                            return;
-                        }
-                    }
+                /* todo: too stale capability */
+            }
+
+            {
+                const Member *primary = box.getPrimary();
+
+                if( !target->hbinfo().hbstate.readable() ||
+                    // if we are not syncing from the primary, return (if
+                    // it's up) so that we can try accessing it again
+                    (target != primary && primary != 0)) {
+                    return;
                 }
-                if( !r.more() )
-                    break;
-                {
-                    BSONObj o = r.nextSafe(); /* note we might get "not master" at some point */
-
-                    int sd = myConfig().slaveDelay;
-                    // ignore slaveDelay if the box is still initializing. once
-                    // it becomes secondary we can worry about it.
-                    if( sd && box.getState().secondary() ) {
-                        const OpTime ts = o["ts"]._opTime();
-                        long long a = ts.getSecs();
-                        long long b = time(0);
-                        long long lag = b - a;
-                        long long sleeptime = sd - lag;
-                        if( sleeptime > 0 ) {
-                            uassert(12000, "rs slaveDelay differential too big check clocks and systems", sleeptime < 0x40000000);
-                            log() << "replSet temp slavedelay sleep:" << sleeptime << rsLog;
-                            if( sleeptime < 60 ) {
-                                sleepsecs((int) sleeptime);
-                            }
-                            else {
-                                // sleep(hours) would prevent reconfigs from taking effect & such!
-                                long long waitUntil = b + sleeptime;
-                                while( 1 ) {
-                                    sleepsecs(6);
-                                    if( time(0) >= waitUntil )
-                                        break;
-                                    if( !target->hbinfo().hbstate.readable() ) {
-                                        break;
-                                    }
-                                    if( myConfig().slaveDelay != sd ) // reconf
-                                        break;
+            }
+
+            if( !fetcher.next(ops, 1000) ) {
+                if( fetcher.done() ) {
+                    log(1) << "replSet end syncTail pass with " << hn << rsLog;
+                    // TODO : reuse our connection to the primary.
+                    return;
+                }
+                continue;
+            }
+
+            if( cmdLine.pretouch )
+                pretouchBatch(ops);
+
+            int sd = myConfig().slaveDelay;
+            // ignore slaveDelay if the box is still initializing. once
+            // it becomes secondary we can worry about it.
+            bool delay = sd && box.getState().secondary();
+
+            unsigned i = 0;
+            while( i < ops.size() ) {
+                if( delay ) {
+                    const OpTime ts = ops[i]["ts"]._opTime();
+                    long long a = ts.getSecs();
+                    long long b = time(0);
+                    long long lag = b - a;
+                    long long sleeptime = sd - lag;
+                    if( sleeptime > 0 ) {
+                        uassert(12000, "rs slaveDelay differential too big check clocks and systems", sleeptime < 0x40000000);
+                        log() << "replSet temp slavedelay sleep:" << sleeptime << rsLog;
+                        if( sleeptime < 60 ) {
+                            sleepsecs((int) sleeptime);
+                        }
+                        else {
+                            // sleep(hours) would prevent reconfigs from taking effect & such!
+                            long long waitUntil = b + sleeptime;
+                            while( 1 ) {
+                                sleepsecs(6);
+                                if( time(0) >= waitUntil )
+                                    break;
+                                if( !target->hbinfo().hbstate.readable() ) {
+                                    break;
                                 }
+                                if( myConfig().slaveDelay != sd ) // reconf
+                                    break;
                             }
                         }
-
                     }
+                }
 
-                    {
-                        writelock lk("");
 
-                        /* if we have become primary, we dont' want to apply things from elsewhere
-                           anymore. assumePrimary is in the db lock so we are safe as long as
-                           we check after we locked above. */
-                        if( box.getState().primary() ) {
-                            log(0) << "replSet stopping syncTail we are now primary" << rsLog;
-                            return;
-                        }
+                writelock lk("");
 
-                        syncApply(o);
-                        _logOpObjRS(o);   /* with repl sets we write the ops to our oplog too: */
-                    }
+                /* if we have become primary, we dont' want to apply things from elsewhere
+                   anymore. assumePrimary is in the db lock so we are safe as long as
+                   we check after we locked above. */
+                if( box.getState().primary() ) {
+                    log(0) << "replSet stopping syncTail we are now primary" << rsLog;
+                    return;
                 }
+
+                /* one op at a time when delaying, otherwise as many as we can in
+                   ApplyBatchMillis before we let readers in */
+                Timer t;
+                do {
+                    syncApply(ops[i]);
+                    _logOpObjRS(ops[i]);   /* with repl sets we write the ops to our oplog too: */
+                    getDur().commitIfNeeded();
+                    i++;
+                } while( !delay && i < ops.size() && t.millis() < ApplyBatchMillis );
             }
-            r.tailCheck();
-            if( !r.haveCursor() ) {
-                log(1) << "replSet end syncTail pass with " << hn << rsLog;
-                // TODO : reuse our connection to the primary.
-                return;
-            }
-            if( !target->hbinfo().hbstate.readable() ) {
-                return;
-            }
-            // looping back is ok because this is a tailable cursor
         }
     }
 
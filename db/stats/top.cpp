@@ -20,6 +20,7 @@
 #include "top.h"
 #include "../../util/message.h"
 #include "../commands.h"
+#include "../namespace.h"
 
 namespace mongo {
 
@@ -33,6 +34,8 @@ namespace mongo {
         : total( older.total , newer.total ) ,
           readLock( older.readLock , newer.readLock ) ,
           writeLock( older.writeLock , newer.writeLock ) ,
+          readLockWait( older.readLockWait , newer.readLockWait ) ,
+          writeLockWait( older.writeLockWait , newer.writeLockWait ) ,
           queries( older.queries , newer.queries ) ,
           getmore( older.getmore , newer.getmore ) ,
           insert( older.insert , newer.insert ) ,
@@ -42,7 +45,7 @@ namespace mongo {
 
     }
 
-    void Top::record( const string& ns , int op , int lockType , long long micros , bool command ) {
+    void Top::record( const string& ns , int op , int lockType , long long micros , bool command , long long lockWaitMicros ) {
         if ( ns[0] == '?' )
             return;
 
@@ -55,17 +58,23 @@ namespace mongo {
         }
 
         CollectionData& coll = _usage[ns];
-        _record( coll , op , lockType , micros , command );
-        _record( _global , op , lockType , micros , command );
+        _record( coll , op , lockType , micros , command , lockWaitMicros );
+        _record( _global , op , lockType , micros , command , lockWaitMicros );
     }
 
-    void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command ) {
+    void Top::_record( CollectionData& c , int op , int lockType , long long micros , bool command , long long lockWaitMicros ) {
         c.total.inc( micros );
 
-        if ( lockType > 0 )
+        if ( lockType > 0 ) {
             c.writeLock.inc( micros );
-        else if ( lockType < 0 )
+            if ( lockWaitMicros )
+                c.writeLockWait.inc( lockWaitMicros );
+        }
+        else if ( lockType < 0 ) {
             c.readLock.inc( micros );
+            if ( lockWaitMicros )
+                c.readLockWait.inc( lockWaitMicros );
+        }
 
         switch ( op ) {
         case 0:
@@ -128,6 +137,8 @@ namespace mongo {
 
             _appendStatsEntry( b , "readLock" , coll.readLock );
             _appendStatsEntry( b , "writeLock" , coll.writeLock );
+            _appendStatsEntry( b , "readLockWait" , coll.readLockWait );
+            _appendStatsEntry( b , "writeLockWait" , coll.writeLockWait );
 
             _appendStatsEntry( b , "queries" , coll.queries );
             _appendStatsEntry( b , "getmore" , coll.getmore );
@@ -140,6 +151,52 @@ namespace mongo {
         }
     }
 
+    void Top::appendLockStats( BSONObjBuilder& b ) const {
+        scoped_lock lk( _lock );
+
+        _appendLockStatsEntry( b , "." , _global );
+
+        map<string,CollectionData> dbs;
+        for ( UsageMap::const_iterator i=_usage.begin(); i!=_usage.end(); i++ ) {
+            CollectionData& d = dbs[ nsToDatabase( i->first.c_str() ) ];
+            const CollectionData& c = i->second;
+            d.readLock.time += c.readLock.time;
+            d.readLock.count += c.readLock.count;
+            d.writeLock.time += c.writeLock.time;
+            d.writeLock.count += c.writeLock.count;
+            d.readLockWait.time += c.readLockWait.time;
+            d.readLockWait.count += c.readLockWait.count;
+            d.writeLockWait.time += c.writeLockWait.time;
+            d.writeLockWait.count += c.writeLockWait.count;
+        }
+
+        for ( map<string,CollectionData>::const_iterator i=dbs.begin(); i!=dbs.end(); i++ )
+            _appendLockStatsEntry( b , i->first.c_str() , i->second );
+    }
+
+    void Top::_appendLockStatsEntry( BSONObjBuilder& b , const char * name , const CollectionData& c ) {
+        BSONObjBuilder bb( b.subobjStart( name ) );
+        {
+            BSONObjBuilder t( bb.subobjStart( "timeLockedMicros" ) );
+            t.appendNumber( "r" , c.readLock.time );
+            t.appendNumber( "w" , c.writeLock.time );
+            t.done();
+        }
+        {
+            BSONObjBuilder t( bb.subobjStart( "timeAcquiringMicros" ) );
+            t.appendNumber( "r" , c.readLockWait.time );
+            t.appendNumber( "w" , c.writeLockWait.time );
+            t.done();
+        }
+        {
+            BSONObjBuilder t( bb.subobjStart( "acquisitionsWaited" ) );
+            t.appendNumber( "r" , c.readLockWait.count );
+            t.appendNumber( "w" , c.writeLockWait.count );
+            t.done();
+        }
+        bb.done();
+    }
+
     void Top::_appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const {
         BSONObjBuilder bb( b.subobjStart( statsName ) );
         bb.appendNumber( "time" , map.time );
@@ -55,6 +55,10 @@ namespace mongo {
             UsageData readLock;
             UsageData writeLock;
 
+            /** time spent waiting to acquire dbMutex for this collection, counted per acquisition */
+            UsageData readLockWait;
+            UsageData writeLockWait;
+
             UsageData queries;
             UsageData getmore;
             UsageData insert;
@@ -66,8 +70,14 @@ namespace mongo {
         typedef map<string,CollectionData> UsageMap;
 
     public:
-        void record( const string& ns , int op , int lockType , long long micros , bool command );
+        void record( const string& ns , int op , int lockType , long long micros , bool command , long long lockWaitMicros = 0 );
         void append( BSONObjBuilder& b );
+
+        /** lock usage and waits: global under ".", and rolled up per database.  there is only the
+            one dbMutex; the per database numbers are its time charged to the namespaces that
+            held or waited for it, not separate locks.
+        */
+        void appendLockStats( BSONObjBuilder& b ) const;
         void cloneMap(UsageMap& out) const;
         CollectionData getGlobalData() const { return _global; }
         void collectionDropped( const string& ns );
@@ -78,7 +88,8 @@ namespace mongo {
     private:
         void _appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const;
         void _appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const;
-        void _record( CollectionData& c , int op , int lockType , long long micros , bool command );
+        void _record( CollectionData& c , int op , int lockType , long long micros , bool command , long long lockWaitMicros );
+        static void _appendLockStatsEntry( BSONObjBuilder& b , const char * name , const CollectionData& c );
 
         mutable mongo::mutex _lock;
         CollectionData _global;
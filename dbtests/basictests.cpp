@@ -25,6 +25,8 @@
 #include "../util/text.h"
 #include "../util/queue.h"
 #include "../util/paths.h"
+#include "../util/compress.h"
+#include "../util/concurrency/thread_pool.h"
 
 namespace BasicTests {
 
@@ -584,6 +586,30 @@ namespace BasicTests {
         }
     };
 
+    class CompressTest {
+    public:
+        void run() {
+            string in;
+            for ( int i = 0; i < 3 * 1024 * 1024; i++ )
+                in += (char) ( ( i % 251 ) ^ ( i / 4096 ) );
+
+            string c;
+            compress( in.data() , in.size() , &c );
+            ASSERT( c.size() < in.size() );
+
+            string threaded;
+            ThreadPool pool( 3 );
+            compress( in.data() , in.size() , &threaded , pool );
+            ASSERT( threaded == c );
+
+            string out;
+            ASSERT( uncompress( c.data() , c.size() , &out ) );
+            ASSERT( out == in );
+
+            ASSERT( !uncompress( c.data() , c.size() / 2 , &out ) );
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "basic" ) {
@@ -620,6 +646,7 @@ namespace BasicTests {
 
             add< HostAndPortTests >();
             add< RelativePathTest >();
+            add< CompressTest >();
         }
     } myall;
 
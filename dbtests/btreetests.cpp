@@ -471,6 +471,22 @@ namespace BtreeTests {
         }
     };
 
+    class MergeBucketsDelLeafKeys : public MergeBuckets {
+        virtual int unindexKeys() {
+            // MergeBucketsLeft's keys, out of their leaf in one go
+            BSONObj k = key( 'b' );
+            int pos;
+            bool found;
+            DiskLoc b = bt()->locate( id(), dl(), k, Ordering::make(order()), pos, found, recordLoc(), 1 );
+            ASSERT( found );
+            ASSERT( b.btree()->isLeaf() );
+            ASSERT( pos + 4 <= b.btree()->nKeys() );
+            getDur().commitIfNeeded();
+            b.btree()->delLeafKeys( b, id(), pos, pos + 4 );
+            return 4;
+        }
+    };
+
     // deleting from head won't coalesce yet
 //    class MergeBucketsHead : public MergeBuckets {
 //        virtual BSONObj unindexKey() { return key( 'p' ); }
@@ -1641,6 +1657,7 @@ namespace BtreeTests {
             add< MergeBucketsRight >();
 //            add< MergeBucketsHead >();
             add< MergeBucketsDontReplaceHead >();
+            add< MergeBucketsDelLeafKeys >();
             add< MergeBucketsDelInternal >();
             add< MergeBucketsRightNull >();
             add< DontMergeSingleBucket >();
@@ -1306,6 +1306,35 @@ namespace JsobjTests {
             }
         };
 
+        class Threaded {
+        public:
+            void run() {
+                BSONObjExternalSorter sorter( BSON( "x" << -1 ) , 20000 );
+                sorter.useThreads( 3 );
+                const int total = 20000;
+                for ( int i=0; i<total; i++ ) {
+                    sorter.add( BSON( "x" << rand() % 1000 ) , 5  , i );
+                }
+
+                sorter.sort();
+                ASSERT( sorter.numFiles() > 10 );
+
+                auto_ptr<BSONObjExternalSorter::Iterator> i = sorter.iterator();
+                int num=0;
+                BSONObjExternalSorter::Data prev;
+                while ( i->more() ) {
+                    BSONObjExternalSorter::Data p = i->next();
+                    if ( num ) {
+                        int cmp = (int)( p.first["x"].number() - prev.first["x"].number() );
+                        ASSERT( cmp < 0 || ( cmp == 0 && prev.second < p.second ) );
+                    }
+                    prev = p;
+                    num++;
+                }
+                ASSERT_EQUALS( total , num );
+            }
+        };
+
         class D1 {
         public:
             void run() {
@@ -1854,6 +1883,7 @@ namespace JsobjTests {
             add< external_sort::ByDiskLock >();
             add< external_sort::Big1 >();
             add< external_sort::Big2 >();
+            add< external_sort::Threaded >();
             add< external_sort::D1 >();
             add< CompatBSON >();
             add< CompareDottedFieldNamesTest >();
@@ -915,6 +915,96 @@ namespace JSTests {
         }
     };
 
+    /** map and reduce over documents with many fields, of which the functions read a few */
+    class WideDocumentMapReduce {
+    public:
+        void run() {
+            vector<BSONObj> docs;
+            for ( int i = 0; i < 100; i++ ) {
+                BSONObjBuilder b;
+                b.append( "_id" , i );
+                b.append( "k" , i % 10 );
+                b.append( "n" , i );
+                for ( int j = 0; j < 200; j++ ) {
+                    string f = "f" + BSONObjBuilder::numStr( j );
+                    switch ( j % 4 ) {
+                    case 0: b.append( f , j ); break;
+                    case 1: b.append( f , "some string value that is not short" ); break;
+                    case 2: b.append( f , BSON( "a" << j << "b" << BSON_ARRAY( 1 << 2 << 3 ) ) ); break;
+                    case 3: b.appendDate( f , Date_t( j ) ); break;
+                    }
+                }
+                docs.push_back( b.obj() );
+            }
+
+            auto_ptr<Scope> s;
+            s.reset( globalScriptEngine->newScope() );
+
+            ScriptingFunction map = s->createFunction( "return this.k + this.n;" );
+            ScriptingFunction reduce = s->createFunction(
+                "var t = 0; for ( var i = 0; i < arguments[1].length; i++ ) t += arguments[1][i].n; return t;" );
+
+            BSONObj empty;
+            Timer t;
+            for ( int n = 0; n < 100; n++ ) {
+                for ( unsigned i = 0; i < docs.size(); i++ ) {
+                    s->setThis( &docs[i] );
+                    s->invoke( map , empty );
+                    ASSERT_EQUALS( docs[i]["k"].number() + docs[i]["n"].number() , s->getNumber( "return" ) );
+                }
+            }
+            int mapMillis = t.millis();
+
+            BSONObjBuilder args;
+            args.append( "0" , 0 );
+            args.append( "1" , docs );
+            BSONObj argsObj = args.obj();
+
+            t.reset();
+            for ( int n = 0; n < 100; n++ ) {
+                s->invoke( reduce , argsObj );
+                ASSERT_EQUALS( 4950 , s->getNumber( "return" ) );
+            }
+            int reduceMillis = t.millis();
+
+            // a document that was only read goes back unchanged
+            s->setObject( "wide" , docs[0] , false );
+            s->invokeSafe( "x = wide.f2.a + wide.f1.length;" , empty );
+            ASSERT_EQUALS( 0 , docs[0].woCompare( s->getObject( "wide" ) ) );
+            s->invokeSafe( "wide.f2.a = 5; delete wide.f3;" , empty );
+            BSONObj out = s->getObject( "wide" );
+            ASSERT_EQUALS( 5 , out["f2"]["a"].number() );
+            ASSERT( out["f3"].eoo() );
+            ASSERT_EQUALS( docs[0].nFields() - 1 , out.nFields() );
+
+            log(1) << "wide documents map: " << mapMillis << "ms reduce: " << reduceMillis << "ms" << endl;
+        }
+    };
+
+    class NumericFieldNames {
+    public:
+        void run() {
+            auto_ptr<Scope> s;
+            s.reset( globalScriptEngine->newScope() );
+
+            BSONObj o = BSON( "0" << 5 << "1" << "x" << "a" << BSON( "2" << 7 ) );
+            s->setObject( "z" , o , false );
+            s->invokeSafe( "return z[0] + z['a'][2];" , BSONObj() );
+            ASSERT_EQUALS( 12 , s->getNumber( "return" ) );
+            s->invokeSafe( "return z[1];" , BSONObj() );
+            ASSERT_EQUALS( "x" , s->getString( "return" ) );
+
+            s->invokeSafe( "z[1] = 'y'; z.a[2] = 8;" , BSONObj() );
+            BSONObj out = s->getObject( "z" );
+            ASSERT_EQUALS( "y" , out["1"].str() );
+            ASSERT_EQUALS( 8 , out["a"]["2"].number() );
+            ASSERT_EQUALS( 5 , out["0"].number() );
+
+            s->invokeSafe( "function( a ){ return args[0] + a; }" , BSON( "0" << 17 ) );
+            ASSERT_EQUALS( 34 , s->getNumber( "return" ) );
+        }
+    };
+
     class ScopeOut {
     public:
         void run() {
@@ -996,6 +1086,8 @@ namespace JSTests {
             add< VarTests >();
 
             add< Speed1 >();
+            add< WideDocumentMapReduce >();
+            add< NumericFieldNames >();
 
             add< InvalidUTF8Check >();
             add< Utf8Check >();
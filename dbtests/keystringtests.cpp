@@ -0,0 +1,152 @@
+// keystringtests.cpp : KeyString unit tests
+//
+
+/**
+ *    Copyright (C) 2008 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pch.h"
+#include "../db/keystring.h"
+#include "../db/json.h"
+
+#include "dbtests.h"
+
+namespace KeyStringTests {
+
+    int sign( int x ) {
+        return x < 0 ? -1 : ( x > 0 ? 1 : 0 );
+    }
+
+    /** memcmp order of every pair of keys must match woCompare under the ordering */
+    class Base {
+    public:
+        virtual ~Base() {}
+        void run() {
+            vector<BSONObj> keys;
+            values( keys );
+            Ordering o = Ordering::make( pattern() );
+            for ( unsigned i = 0; i < keys.size(); i++ ) {
+                KeyString l( keys[i] , o );
+                for ( unsigned j = 0; j < keys.size(); j++ ) {
+                    KeyString r( keys[j] , o );
+                    int expected = sign( keys[i].woCompare( keys[j] , o , false ) );
+                    int got = sign( l.compare( r ) );
+                    if ( expected != got ) {
+                        out() << "KeyString mismatch " << keys[i] << ' ' << keys[j]
+                              << " expected: " << expected << " got: " << got << endl;
+                    }
+                    ASSERT_EQUALS( expected , got );
+                }
+            }
+        }
+    protected:
+        virtual BSONObj pattern() = 0;
+        virtual void values( vector<BSONObj>& keys ) = 0;
+    };
+
+    class SingleField : public Base {
+    protected:
+        virtual BSONObj pattern() { return BSON( "a" << 1 ); }
+        virtual void values( vector<BSONObj>& v ) {
+            v.push_back( BSON( "" << MINKEY ) );
+            v.push_back( BSON( "" << MAXKEY ) );
+            v.push_back( BSONObjBuilder().appendNull( "" ).obj() );
+            v.push_back( BSON( "" << 0 ) );
+            v.push_back( BSON( "" << -0.0 ) );
+            v.push_back( BSON( "" << 1 ) );
+            v.push_back( BSON( "" << 1.5 ) );
+            v.push_back( BSON( "" << -3 ) );
+            v.push_back( BSON( "" << -3.25 ) );
+            v.push_back( BSON( "" << 1e300 ) );
+            v.push_back( BSON( "" << -1e300 ) );
+            v.push_back( BSON( "" << numeric_limits<double>::infinity() ) );
+            v.push_back( BSON( "" << numeric_limits<double>::quiet_NaN() ) );
+            v.push_back( BSON( "" << 5LL ) );
+            v.push_back( BSON( "" << -5LL ) );
+            v.push_back( BSON( "" << 1000000000000LL ) );
+            v.push_back( BSON( "" << "" ) );
+            v.push_back( BSON( "" << "a" ) );
+            v.push_back( BSON( "" << "ab" ) );
+            v.push_back( BSON( "" << "abc" ) );
+            v.push_back( BSON( "" << "b" ) );
+            v.push_back( BSON( "" << "\xc3\xa9" ) );
+            v.push_back( BSON( "" << true ) );
+            v.push_back( BSON( "" << false ) );
+            v.push_back( BSON( "" << OID( "4d0000000000000000000001" ) ) );
+            v.push_back( BSON( "" << OID( "4e0000000000000000000000" ) ) );
+            v.push_back( BSON( "" << Date_t( 0 ) ) );
+            v.push_back( BSON( "" << Date_t( 1300000000000ULL ) ) );
+            v.push_back( BSON( "" << BSONObj() ) );
+            v.push_back( fromjson( "{'':{a:1}}" ) );
+            v.push_back( fromjson( "{'':{a:1,b:1}}" ) );
+            v.push_back( fromjson( "{'':{a:2}}" ) );
+            v.push_back( fromjson( "{'':{b:1}}" ) );
+            v.push_back( fromjson( "{'':{a:'x'}}" ) );
+            v.push_back( fromjson( "{'':[1,2]}" ) );
+            v.push_back( fromjson( "{'':[1]}" ) );
+            v.push_back( fromjson( "{'':/abc/i}" ) );
+            v.push_back( fromjson( "{'':/abc/}" ) );
+            {
+                BSONObjBuilder b;
+                b.appendBinData( "" , 3 , BinDataGeneral , "abc" );
+                v.push_back( b.obj() );
+            }
+            {
+                BSONObjBuilder b;
+                b.appendBinData( "" , 2 , BinDataGeneral , "zz" );
+                v.push_back( b.obj() );
+            }
+            {
+                BSONObjBuilder b;
+                b.appendTimestamp( "" , 1000 , 5 );
+                v.push_back( b.obj() );
+            }
+        }
+    };
+
+    class Descending : public SingleField {
+    protected:
+        virtual BSONObj pattern() { return BSON( "a" << -1 ); }
+    };
+
+    class Compound : public Base {
+    protected:
+        virtual BSONObj pattern() { return BSON( "a" << 1 << "b" << -1 ); }
+        virtual void values( vector<BSONObj>& v ) {
+            v.push_back( BSON( "" << 1 << "" << 1 ) );
+            v.push_back( BSON( "" << 1 << "" << 2 ) );
+            v.push_back( BSON( "" << 1 << "" << "x" ) );
+            v.push_back( BSON( "" << 2 << "" << 1 ) );
+            v.push_back( BSON( "" << "a" << "" << 1 ) );
+            v.push_back( BSON( "" << "a" << "" << "b" ) );
+            v.push_back( BSON( "" << "ab" << "" << 1 ) );
+            v.push_back( BSON( "" << MINKEY << "" << MAXKEY ) );
+            v.push_back( BSON( "" << MAXKEY << "" << MINKEY ) );
+        }
+    };
+
+    class All : public Suite {
+    public:
+        All() : Suite( "keystring" ) {
+        }
+
+        void setupTests() {
+            add< SingleField >();
+            add< Descending >();
+            add< Compound >();
+        }
+    } myall;
+
+} // namespace KeyStringTests
@@ -119,6 +119,35 @@ namespace MatcherTests {
         }
     };
 
+    /** prefetched fields and reordered predicates must give the interpreter's answers */
+    class Compiled {
+    public:
+        void run() {
+            const char *queries[] = {
+                "{a:1,b:2}", "{a:{$gt:0},'c.d':3,'c.e':{$ne:4}}", "{a:null,b:2}",
+                "{a:{$ne:null},b:{$ne:2}}", "{a:{$exists:false},b:2}", "{'arr.x':{$gt:0},'arr.y':2}",
+                "{arr:{$elemMatch:{x:1}},b:1}", "{a:{$nin:[3]},b:2,'c.d':{$in:[null]}}",
+                "{'arr.0':1,b:2}", 0
+            };
+            const char *docs[] = {
+                "{a:1,b:2}", "{a:2,b:2,c:{d:3,e:4}}", "{b:2}", "{a:null,b:2}", "{a:[1,2],b:2}",
+                "{a:1,arr:[{x:1,y:2},{x:2,y:2}],b:2}", "{a:1,a:2,b:2}", "{c:[{d:3},{d:4}],a:1,b:2}",
+                "{arr:[1,2],a:1,b:2}", "{a:1,b:2,c:{d:null}}", 0
+            };
+            for( int q = 0; queries[ q ]; ++q ) {
+                BSONObj query = fromjson( queries[ q ] );
+                Matcher interpreted( query, false, false );
+                Matcher compiled( query );
+                // enough passes for the evaluation order to be adjusted
+                for( int pass = 0; pass < 50; ++pass ) {
+                    for( int d = 0; docs[ d ]; ++d ) {
+                        BSONObj doc = fromjson( docs[ d ] );
+                        ASSERT_EQUALS( interpreted.matches( doc ), compiled.matches( doc ) );
+                    }
+                }
+            }
+        }
+    };
 
     class TimingBase {
     public:
@@ -155,6 +184,7 @@ namespace MatcherTests {
             add< MixedNumericIN >();
             add< Size >();
             add< MixedNumericEmbedded >();
+            add< Compiled >();
             add< AllTiming >();
         }
     } dball;
@@ -34,6 +34,7 @@
 #include "dbtests.h"
 #include "../db/dur_stats.h"
 #include "../util/checksum.h"
+#include "../scripting/engine.h"
 
 namespace PerfTests {
     typedef DBDirectClient DBClientType;
@@ -318,6 +319,149 @@ namespace PerfTests {
         unsigned long long expectation() { return 1000; }
     };
 
+    /** range queries answered from the { x : 1 } index alone, vs. the same queries fetching the
+        records.  records carry 1KB of padding so touching them is not free.
+    */
+    class CoveredQuery : public B {
+    public:
+        virtual string name() { return "covered index range query"; }
+        void prep() {
+            string pad( 1024 , 'p' );
+            for( int i = 0; i < N; i++ )
+                client().insert( ns(), BSON( "x" << i << "pad" << pad ) );
+            client().ensureIndex( ns(), BSON( "x" << 1 ) );
+
+            // the index only plan must not dereference any record
+            BSONObj e = client().findOne( ns(), Query( range( 0 ) ).explain(), &fields );
+            ASSERT( e["indexOnly"].trueValue() );
+            ASSERT_EQUALS( 100 , e["n"].numberInt() );
+            ASSERT_EQUALS( 0 , e["nscannedObjects"].numberInt() );
+        }
+        void timed() {
+            doQuery( &fields );
+        }
+        const char * timed2() {
+            doQuery( 0 );
+            static string s = name()+" fetching records";
+            return s.c_str();
+        }
+        unsigned long long expectation() { return 1000; }
+    private:
+        static const int N = 20000;
+        static BSONObj fields;
+        static BSONObj range( int start ) {
+            return BSON( "x" << BSON( "$gte" << start << "$lt" << start + 100 ) );
+        }
+        void doQuery( const BSONObj *f ) {
+            auto_ptr<DBClientCursor> c = client().query( ns(), range( std::rand() % ( N - 100 ) ), 0, 0, f );
+            int n = 0;
+            while( c->more() ) {
+                c->next();
+                n++;
+            }
+            assert( n == 100 );
+        }
+    };
+    BSONObj CoveredQuery::fields = BSON( "x" << 1 << "_id" << 0 );
+
+    /** Matcher cpu cost on a wide document, with the single pass field lookup and predicate
+        reordering vs. the plain interpreter.  no database access.
+    */
+    class MatcherBase : public B {
+    public:
+        void prep() {
+            BSONObjBuilder b;
+            for( int i = 0; i < 20; i++ )
+                b.append( string( "f" ) + BSONObjBuilder::numStr( i ), i );
+            b.append( "sub", BSON( "x" << 1 << "y" << 2 << "z" << 3 ) );
+            doc = b.obj();
+            BSONObj q = query();
+            interpreted.reset( new Matcher( q, false, false ) );
+            compiled.reset( new Matcher( q ) );
+            ASSERT_EQUALS( interpreted->matches( doc ), compiled->matches( doc ) );
+        }
+        void timed() {
+            for( int i = 0; i < 100; i++ )
+                compiled->matches( doc );
+        }
+        const char * timed2() {
+            for( int i = 0; i < 100; i++ )
+                interpreted->matches( doc );
+            static string s;
+            s = name() + " interpreted";
+            return s.c_str();
+        }
+        unsigned long long expectation() { return 5000; }
+    protected:
+        virtual BSONObj query() = 0;
+    private:
+        BSONObj doc;
+        scoped_ptr< Matcher > interpreted;
+        scoped_ptr< Matcher > compiled;
+    };
+
+    class MatcherAllMatch : public MatcherBase {
+        virtual string name() { return "matcher 5 fields match"; }
+        virtual BSONObj query() {
+            return fromjson( "{f15:{$gte:0},'sub.x':1,'sub.z':{$lt:10},f19:{$ne:3},f17:17}" );
+        }
+    };
+
+    /** the last predicate is the only selective one */
+    class MatcherSelectiveLast : public MatcherBase {
+        virtual string name() { return "matcher selective last"; }
+        virtual BSONObj query() {
+            return fromjson( "{f15:{$gte:0},'sub.x':1,'sub.z':{$lt:10},f19:{$ne:3},f17:20}" );
+        }
+    };
+
+    /** inline map/reduce of 1000 documents into 10 keys with map and reduce declared in bson,
+        vs. the same job in javascript.
+    */
+    class NativeMapReduce : public B {
+    public:
+        virtual string name() { return "mapreduce native"; }
+        void prep() {
+            if ( ! globalScriptEngine )
+                ScriptEngine::setup();
+            for( int i = 0; i < N; i++ )
+                client().insert( ns(), BSON( "k" << i % 10 << "x" << i ) );
+
+            BSONObj n = doMapReduce( true );
+            BSONObj j = doMapReduce( false );
+            ASSERT_EQUALS( n["results"].Obj().woCompare( j["results"].Obj() , BSONObj() , false ) , 0 );
+        }
+        void timed() {
+            doMapReduce( true );
+        }
+        const char * timed2() {
+            doMapReduce( false );
+            static string s = name()+" javascript";
+            return s.c_str();
+        }
+        unsigned long long expectation() { return 10; }
+    private:
+        static const int N = 1000;
+        BSONObj doMapReduce( bool native ) {
+            BSONObjBuilder b;
+            b.append( "mapreduce" , name() );
+            if ( native ) {
+                b.append( "map" , fromjson( "{key:'$k',value:{n:1,total:'$x'}}" ) );
+                b.append( "reduce" , fromjson( "{n:{$sum:'n'},total:{$sum:'total'}}" ) );
+            }
+            else {
+                b.appendCode( "map" , "function(){ emit( this.k , { n : 1 , total : this.x } ); }" );
+                b.appendCode( "reduce" , "function( k , vs ){ var r = { n : 0 , total : 0 }; "
+                              "vs.forEach( function( v ){ r.n += v.n; r.total += v.total; } ); return r; }" );
+            }
+            b.append( "out" , BSON( "inline" << 1 ) );
+            BSONObj res;
+            ASSERT( client().runCommand( "perftest" , b.obj() , res ) );
+            ASSERT_EQUALS( 10 , res["results"].Obj().nFields() );
+            return res;
+        }
+    };
+
     template <typename T>
     class MoreIndexes : public T {
     public:
@@ -378,6 +522,10 @@ namespace PerfTests {
             add< Update1 >();
             add< MoreIndexes<Update1> >();
             add< InsertBig >();
+            add< CoveredQuery >();
+            add< MatcherAllMatch >();
+            add< MatcherSelectiveLast >();
+            add< NativeMapReduce >();
         }
     } myall;
 }
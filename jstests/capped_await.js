@@ -0,0 +1,28 @@
+// an awaitData getMore at the end of a capped collection sleeps until an insert wakes it
+
+t = db.capped_await;
+t.drop();
+db.createCollection( t.getName() , { capped : true , size : 100000 } );
+t.insert( { x : 0 } );
+
+// tailable | awaitData
+c = t.find().addOption( 2 ).addOption( 32 );
+assert.eq( 0 , c.next().x );
+
+// nothing comes: the getMore gives up after a while
+start = new Date();
+assert( ! c.hasNext() , "nothing inserted" );
+waited = new Date() - start;
+print( "empty getMore took " + waited + "ms" );
+assert( waited >= 1000 , "returned without waiting" );
+
+// an insert from another connection ends the wait right away
+s = startParallelShell( "sleep( 300 ); db.capped_await.insert( { x : 1 , at : new Date() } ); db.getLastError();" );
+for ( i=0; i<10 && ! c.hasNext(); i++ )
+    ; // the other shell may take a while to start
+woke = new Date();
+s();
+o = c.next();
+assert.eq( 1 , o.x );
+print( "woke " + ( woke - o.at ) + "ms after the insert" );
+assert( woke - o.at < 500 , "not woken by the insert" );
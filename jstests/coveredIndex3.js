@@ -0,0 +1,35 @@
+// covered queries must not touch records
+
+t = db["jstests_coveredIndex3"];
+t.drop();
+
+for( i = 0; i < 50; i++ ) {
+    t.save( {a: i, b: i % 5, c: "xxxxxxxxxx"} );
+}
+t.ensureIndex( {a: 1, b: 1} );
+
+e = t.find( {a: {$gte: 10, $lt: 20}}, {a: 1, _id: 0} ).explain();
+assert.eq( true, e.indexOnly, "range on index field" );
+assert.eq( 10, e.n );
+assert.eq( 0, e.nscannedObjects, "records loaded for a covered query" );
+assert.eq( 10, t.find( {a: {$gte: 10, $lt: 20}}, {a: 1, _id: 0} ).itcount() );
+assert.eq( {a: 15}, t.find( {a: 15}, {a: 1, _id: 0} ).next() );
+
+// predicate on a second key field
+e = t.find( {a: {$gte: 10, $lt: 20}, b: 2}, {a: 1, b: 1, _id: 0} ).explain();
+assert.eq( true, e.indexOnly, "compound predicate" );
+assert.eq( 2, e.n );
+assert.eq( 0, e.nscannedObjects );
+
+// sort on a key field that the index doesn't provide in order
+e = t.find( {a: {$gte: 10, $lt: 20}}, {a: 1, b: 1, _id: 0} ).sort( {b: 1} ).explain();
+assert.eq( true, e.indexOnly, "in memory sort on key fields" );
+assert.eq( 0, e.nscannedObjects );
+assert.eq( [0,0,1,1,2,2,3,3,4,4], t.find( {a: {$gte: 10, $lt: 20}}, {b: 1, _id: 0} ).sort( {b: 1} ).toArray().map( function( x ) { return x.b; } ) );
+
+// predicate or sort on a field outside the index needs the record
+e = t.find( {a: {$gte: 10, $lt: 20}, c: "xxxxxxxxxx"}, {a: 1, _id: 0} ).explain();
+assert.eq( false, e.indexOnly, "predicate outside the index" );
+assert.eq( 10, e.nscannedObjects );
+e = t.find( {a: {$gte: 10, $lt: 20}}, {a: 1, _id: 0} ).sort( {c: 1} ).explain();
+assert.eq( false, e.indexOnly, "sort outside the index" );
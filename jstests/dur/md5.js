@@ -73,8 +73,9 @@ var file = path + "/journal/j._0";
 // run("cp", file, "/tmp/before");
 
 // journal header is 8192
-// jsectheader is 20
-// so a little beyond that
+// jsectheader is 20, then the 4 byte compressed length
+// so a little beyond that is in the compressed section; a flip there either fails
+// to uncompress or uncompresses to data that fails the md5 check
 fuzzFile(file, 8214+8);
 
 // run("cp", file, "/tmp/after");
@@ -0,0 +1,35 @@
+// replies made of several buffers: documents of many sizes, in the first batch and in getMores
+
+t = db.find8;
+t.drop();
+
+s = "x";
+sizes = [];
+for ( i=0; i<60; i++ ) {
+    // mostly small, now and then up to ~1.5MB, so documents land on both sides of buffer boundaries
+    var n = ( i % 5 == 0 ) ? 300 * 1000 * ( i % 6 ) + 1 : ( i * 7919 ) % 20000 + 1;
+    while ( s.length < n )
+        s += s;
+    t.insert( { _id : i , n : n , s : s.substring( 0 , n ) } );
+    sizes.push( n );
+}
+db.getLastError();
+
+function check( c , msg ) {
+    var i = 0;
+    while ( c.hasNext() ) {
+        var o = c.next();
+        assert.eq( i , o._id , msg + " order" );
+        assert.eq( sizes[i] , o.n , msg + " n" );
+        if ( o.s )
+            assert.eq( sizes[i] , o.s.length , msg + " s" );
+        i++;
+    }
+    assert.eq( sizes.length , i , msg + " count" );
+}
+
+check( t.find().sort( { _id : 1 } ) , "all" );
+check( t.find().sort( { _id : 1 } ).batchSize( 7 ) , "batches" );
+check( t.find( {} , { n : 1 , s : 1 } ).sort( { _id : 1 } ) , "projection" );
+check( t.find( {} , { n : 1 } ).sort( { _id : 1 } ) , "small projection" );
+check( t.find().sort( { _id : 1 } ).showDiskLoc() , "diskloc" );
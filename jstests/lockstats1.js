@@ -0,0 +1,21 @@
+// per database lock usage and wait stats in serverStatus and top
+
+t = db.lockstats1;
+t.drop();
+
+for ( i=0; i<100; i++ )
+    t.insert( { x : i } );
+db.getLastError();
+
+s = db.serverStatus();
+assert( s.locks , "no locks section: " + tojson( s ) );
+assert( s.locks["."] , "no global lock stats: " + tojson( s.locks ) );
+assert( s.locks[db.getName()] , "no db lock stats: " + tojson( s.locks ) );
+assert.lt( 0 , s.locks[db.getName()].timeLockedMicros.w , "db write lock time" );
+
+top = db.getSisterDB( "admin" ).runCommand( "top" ).totals[t.getFullName()];
+assert( top.writeLockWait , "no writeLockWait in top: " + tojson( top ) );
+
+ops = db.currentOp( true ).inprog;
+assert( ops.length > 0 );
+assert( ops[0].lockStats , "no lockStats in currentOp: " + tojson( ops[0] ) );
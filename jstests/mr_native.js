@@ -0,0 +1,93 @@
+// map/reduce and group with map and reduce declared in bson instead of javascript
+
+t = db.mr_native;
+t.drop();
+
+for( i = 0; i < 1000; i++ ) {
+    t.save( { k : i % 7 , x : i , y : { z : i % 13 } } );
+}
+t.save( { k : 3 } );
+
+function byId( res ) {
+    var z = {};
+    res.results.forEach( function( a ){ z[a._id] = a.value; } );
+    return z;
+}
+
+// map/reduce
+nm = { key : "$k" , value : { n : 1 , total : "$x" , lo : "$y.z" , hi : "$y.z" } };
+nr = { n : { $sum : "n" } , total : { $sum : "total" } , lo : { $min : "lo" } , hi : { $max : "hi" } };
+
+jm = function(){ emit( this.k , { n : 1 , total : this.x , lo : this.y ? this.y.z : null , hi : this.y ? this.y.z : null } ); };
+jr = function( k , vs ){
+    var r = { n : 0 , total : 0 , lo : null , hi : null };
+    vs.forEach( function( v ){
+        r.n += v.n;
+        if ( typeof v.total == "number" ) r.total += v.total;
+        if ( v.lo != null && ( r.lo == null || v.lo < r.lo ) ) r.lo = v.lo;
+        if ( v.hi != null && ( r.hi == null || v.hi > r.hi ) ) r.hi = v.hi;
+    } );
+    return r;
+};
+
+native = db.runCommand( { mapreduce : "mr_native" , map : nm , reduce : nr , out : { inline : 1 } } );
+assert.commandWorked( native );
+js = db.runCommand( { mapreduce : "mr_native" , map : jm , reduce : jr , out : { inline : 1 } } );
+assert.commandWorked( js );
+
+assert.eq( 7 , native.results.length );
+assert.eq( tojson( byId( js ) ) , tojson( byId( native ) ) , "native vs js" );
+assert.eq( 1001 , native.counts.input );
+assert.eq( 1001 , native.counts.emit );
+
+// mixed native map and js reduce, written to a collection
+res = t.mapReduce( nm , jr , { out : "mr_native_out" } );
+assert.eq( tojson( byId( js ) ) , tojson( res.convertToSingleObject() ) , "native map, js reduce" );
+res.drop();
+
+// js map and native reduce of plain values, then finalize
+res = t.mapReduce( function(){ emit( this.k , 1 ); } , { $sum : 1 } ,
+                   { finalize : function( k , v ){ return v * 2; } , out : { inline : 1 } } );
+z = res.convertToSingleObject();
+assert.eq( 286 , z[0] , "finalize 0" );
+assert.eq( 288 , z[3] , "finalize 3" );
+
+// bad specs
+assert.commandFailed( db.runCommand( { mapreduce : "mr_native" , map : nm , reduce : { n : { $avg : "n" } } , out : { inline : 1 } } ) , "$avg" );
+assert.commandFailed( db.runCommand( { mapreduce : "mr_native" , map : nm , reduce : { n : { $sum : "total" } } , out : { inline : 1 } } ) , "other field" );
+assert.commandFailed( db.runCommand( { mapreduce : "mr_native" , map : nm , reduce : { n : { $foo : "n" } } , out : { inline : 1 } } ) , "bad op" );
+assert.commandFailed( db.runCommand( { mapreduce : "mr_native" , map : { key : "$k" } , reduce : nr , out : { inline : 1 } } ) , "bad map" );
+
+// group
+function sorted( a ) {
+    return tojson( a.sort( function( l , r ){ return l.k - r.k; } ) );
+}
+
+ng = t.group( { key : { k : 1 } , initial : { n : 0 , total : 0 , lo : null } ,
+                reduce : { n : { $sum : 1 } , total : { $sum : "x" } , lo : { $min : "x" } , avg : { $avg : "x" } } } );
+jg = t.group( { key : { k : 1 } , initial : { n : 0 , total : 0 , lo : null , sum : 0 , cnt : 0 } ,
+                reduce : function( doc , out ){
+                    out.n++;
+                    if ( typeof doc.x != "number" )
+                        return;
+                    out.total += doc.x;
+                    if ( out.lo == null || doc.x < out.lo ) out.lo = doc.x;
+                    out.sum += doc.x;
+                    out.cnt++;
+                } ,
+                finalize : function( out ){ out.avg = out.sum / out.cnt; delete out.sum; delete out.cnt; } } );
+assert.eq( 7 , ng.length );
+assert.eq( sorted( jg ) , sorted( ng ) , "group native vs js" );
+
+// native reduce with a js finalize
+fg = t.group( { key : { k : 1 } , cond : { x : { $lt : 100 } } , initial : {} ,
+                reduce : { n : { $sum : 1 } , total : { $sum : "x" } } ,
+                finalize : function( out ){ return { k : out.k , mean : out.total / out.n }; } } );
+fg.sort( function( l , r ){ return l.k - r.k; } );
+assert.eq( 7 , fg.length );
+assert.eq( 3 , fg[3].k );
+assert.eq( ( 3 + 94 ) / 2 , fg[3].mean , "finalize mean" );
+
+assert.throws( function(){ t.group( { key : { k : 1 } , initial : {} , reduce : { $sum : 1 } } ); } , null , "plain values" );
+
+t.drop();
@@ -0,0 +1,61 @@
+// map/reduce with the map stage spread over several threads
+
+t = db.mr_threads;
+t.drop();
+
+for( i = 0; i < 20000; i++ ) {
+    t.save( { k : i % 997 , x : i , tags : [ "a" + ( i % 3 ) , "b" + ( i % 5 ) ] } );
+}
+
+m = function(){
+    emit( this.k , { n : 1 , total : this.x } );
+    this.tags.forEach( function( z ){ emit( z , { n : 1 , total : 0 } ); } );
+};
+r = function( k , vs ){
+    var res = { n : 0 , total : 0 };
+    vs.forEach( function( v ){ res.n += v.n; res.total += v.total; } );
+    return res;
+};
+
+function check( threads , out ) {
+    var one = t.mapReduce( m , r , { out : out } );
+    var oneResults = tojson( one.convertToSingleObject() );
+    var many = t.mapReduce( m , r , { out : out , threads : threads } );
+    assert.eq( one.counts.input , many.counts.input , "input " + threads );
+    assert.eq( one.counts.emit , many.counts.emit , "emit " + threads );
+    assert.eq( one.counts.output , many.counts.output , "output " + threads );
+    assert.eq( oneResults , tojson( many.convertToSingleObject() ) , "results " + threads );
+    return many;
+}
+
+res = check( 4 , { inline : 1 } );
+assert.eq( 997 + 8 , res.counts.output );
+assert.eq( 60000 , res.counts.emit );
+
+check( 2 , "mr_threads_out" );
+check( 7 , { merge : "mr_threads_out" } );
+db.mr_threads_out.drop();
+
+// query, sort and limit are applied by the scanning thread as before
+res = t.mapReduce( m , r , { out : { inline : 1 } , threads : 3 , query : { x : { $lt : 1000 } } , sort : { x : 1 } , limit : 500 } );
+assert.eq( 500 , res.counts.input );
+z = res.convertToSingleObject();
+assert.eq( 1 , z[0].n );
+assert.eq( 167 , z.a0.n );
+
+// finalize runs after the threads are done
+res = t.mapReduce( m , r , { out : { inline : 1 } , threads : 4 , finalize : function( k , v ){ return v.n; } } );
+assert.eq( 4000 , res.convertToSingleObject().b0 );
+
+// native map and reduce need no js at all
+res = db.runCommand( { mapreduce : "mr_threads" , map : { key : "$k" , value : { n : 1 } } ,
+                       reduce : { n : { $sum : "n" } } , out : { inline : 1 } , threads : 4 } );
+assert.commandWorked( res );
+assert.eq( 997 , res.results.length );
+
+// the threads can't use the database
+assert.commandFailed( db.runCommand( { mapreduce : "mr_threads" , threads : 2 , out : { inline : 1 } ,
+                                       map : function(){ emit( this.k , db.mr_threads.count() ); } , reduce : r } ) );
+assert.commandFailed( db.runCommand( { mapreduce : "mr_threads" , map : m , reduce : r , out : { inline : 1 } , threads : 0 } ) );
+
+t.drop();
@@ -0,0 +1,51 @@
+// planCacheStats shows the plan recorded for each query pattern and how it has done since
+
+t = db.plan_cache_stats;
+t.drop();
+
+for ( i=0; i<1000; i++ )
+    t.save( { a : i % 10 , b : i } );
+t.ensureIndex( { a : 1 } );
+t.ensureIndex( { b : 1 } );
+
+function plans() {
+    var res = db.runCommand( { planCacheStats : t.getName() } );
+    assert( res.ok , tojson( res ) );
+    assert.eq( t.getFullName() , res.ns );
+    assert( res.cache.capacity > 0 );
+    return res.plans;
+}
+
+assert.eq( 0 , plans().length , "empty" );
+
+// the b index wins the race and is recorded
+assert.eq( 1 , t.find( { a : 5 , b : 5 } ).itcount() );
+p = plans();
+printjson( p );
+assert.eq( 1 , p.length , "recorded" );
+assert.eq( { b : 1 } , p[0].index );
+assert.eq( "eq" , p[0].pattern.fields.a );
+assert.eq( 1 , p[0].runs );
+
+// later queries of the same shape use it
+for ( i=0; i<5; i++ )
+    t.find( { a : 5 , b : 15 } ).itcount();
+p = plans();
+assert.eq( 1 , p.length );
+assert.eq( { b : 1 } , p[0].index );
+assert( p[0].runs > 1 , "runs" );
+assert( p[0].uses >= 5 , "uses" );
+assert( p[0].avgNScanned <= 1 , "avgNScanned" );
+
+// a different shape gets its own plan
+t.find( { b : { $gt : 990 } } ).itcount();
+assert.eq( 2 , plans().length , "second pattern" );
+
+// index changes throw them away
+t.ensureIndex( { a : 1 , b : 1 } );
+assert.eq( 0 , plans().length , "cleared by new index" );
+
+summary = db.runCommand( { planCacheStats : 1 } );
+assert( summary.ok );
+assert( ! summary.plans );
+assert( summary.cache.hits >= 5 , tojson( summary ) );
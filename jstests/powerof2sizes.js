@@ -0,0 +1,46 @@
+// usePowerOf2Sizes: records are allocated in power of 2 size classes so freed space is reusable
+
+t = db.powerof2sizes;
+t.drop();
+
+assert.commandWorked( db.createCollection( t.getName() , { usePowerOf2Sizes : true } ) );
+assert( t.stats().usePowerOf2Sizes , "flag not set on create" );
+
+for ( i = 0; i < 100; i++ )
+    t.insert( { _id : i , s : new Array( 1 + ( i * 7 ) % 300 ).join( "x" ) } );
+assert.eq( 100 , t.count() );
+
+before = t.stats();
+t.remove( { _id : { $lt : 50 } } );
+s = t.stats();
+assert.lt( before.deletedCount , s.deletedCount , tojson( s ) );
+assert.lt( before.deletedSize , s.deletedSize , tojson( s ) );
+
+// freed records are reused by documents of similar size
+for ( i = 100; i < 150; i++ )
+    t.insert( { _id : i , s : new Array( 1 + ( i * 7 ) % 300 ).join( "x" ) } );
+assert.eq( 100 , t.count() );
+assert.gte( s.storageSize , t.stats().storageSize , "should not have grown" );
+
+// toggle with collMod
+r = db.runCommand( { collMod : t.getName() , usePowerOf2Sizes : false } );
+assert.commandWorked( r );
+assert.eq( true , r.usePowerOf2Sizes_old );
+assert.eq( false , r.usePowerOf2Sizes_new );
+assert( !t.stats().usePowerOf2Sizes );
+
+r = db.runCommand( { collMod : t.getName() , usePowerOf2Sizes : true } );
+assert.commandWorked( r );
+assert( t.stats().usePowerOf2Sizes );
+
+assert.commandFailed( db.runCommand( { collMod : t.getName() , bogus : 1 } ) );
+assert.commandFailed( db.runCommand( { collMod : "powerof2sizes_missing" , usePowerOf2Sizes : true } ) );
+
+// not supported on capped collections
+c = db.powerof2sizes_capped;
+c.drop();
+assert.commandFailed( db.createCollection( c.getName() , { capped : true , size : 10000 , usePowerOf2Sizes : true } ) );
+assert.commandWorked( db.createCollection( c.getName() , { capped : true , size : 10000 } ) );
+assert.commandFailed( db.runCommand( { collMod : c.getName() , usePowerOf2Sizes : true } ) );
+c.drop();
+t.drop();
@@ -0,0 +1,53 @@
+// initial sync clones several collections at once, then builds their indexes
+
+load("jstests/replsets/rslib.js");
+var name = "initial_sync_parallel";
+
+var replTest = new ReplSetTest( {name: name, nodes: 1} );
+replTest.startSet();
+replTest.initiate();
+
+var master = replTest.getMaster();
+
+print("1. Insert into a few collections of two databases");
+var dbs = [ master.getDB(name), master.getDB(name + "_b") ];
+for ( var d = 0; d < dbs.length; d++ ) {
+    for ( var c = 0; c < 6; c++ ) {
+        var coll = dbs[d]["c" + c];
+        for ( var i = 0; i < 1000; i++ )
+            coll.insert( { _id : i, x : i % 17, s : "abcdefghijklmnopqrstuvwxyz" } );
+        if ( c % 2 == 0 )
+            coll.ensureIndex( { x : 1 } );
+    }
+    dbs[d].getLastError();
+}
+
+print("2. Add a member, it clones with the default of 4 threads");
+var slave = replTest.add();
+replTest.reInitiate();
+
+wait( function() {
+    var status = master.getDB("admin").runCommand( { replSetGetStatus : 1 } );
+    return status.members.length == 2 && status.members[1].state == 2;
+} );
+replTest.awaitReplication();
+
+print("3. Everything is there, indexes too");
+slave.setSlaveOk();
+for ( var d = 0; d < dbs.length; d++ ) {
+    var sdb = slave.getDB( dbs[d].getName() );
+    for ( var c = 0; c < 6; c++ ) {
+        var coll = "c" + c;
+        assert.eq( 1000, sdb[coll].count(), dbs[d].getName() + "." + coll + " count" );
+        assert.eq( dbs[d][coll].stats().nindexes, sdb[coll].stats().nindexes, dbs[d].getName() + "." + coll + " indexes" );
+    }
+}
+
+var status = slave.getDB("admin").runCommand( { replSetGetStatus : 1 } );
+printjson( status );
+status.members.forEach( function( m ) {
+    if ( m.self )
+        assert( !m.initialSync, "initialSync progress still reported after the clone" );
+} );
+
+replTest.stopSet();
@@ -0,0 +1,48 @@
+// a mongos whose chunk info goes stale catches up on splits and moves made through another mongos,
+// and routes by every kind of shard key value
+
+s1 = new ShardingTest( "chunk_routing" , 2 , 0 , 2 );
+s2 = s1._mongos[1];
+
+s1.adminCommand( { enablesharding : "test" } );
+s1.adminCommand( { shardcollection : "test.foo" , key : { k : 1 } } );
+
+viaS1 = s1.getDB( "test" ).foo;
+viaS2 = s2.getDB( "test" ).foo;
+
+// mixed types, so the boundaries cover the canonical type order
+keys = [ MinKey , null , -1000.5 , -1 , 0 , NumberLong( 7 ) , 2.5 , 1000 , "" , "a" , "abc" , "b" ,
+         { x : 1 } , [ 1 , 2 ] , ObjectId() , true , new Date( 1000 ) , MaxKey ];
+for ( i=0; i<keys.length; i++ )
+    viaS1.save( { k : keys[i] , i : i } );
+viaS1.getDB().getLastError();
+
+// s2 loads the single chunk
+assert.eq( keys.length , viaS2.find().itcount() , "s2 initial" );
+
+// split at every value through s1, and move every other chunk
+for ( i=1; i<keys.length - 1; i++ )
+    assert( s1.adminCommand( { split : "test.foo" , middle : { k : keys[i] } } ).ok , "split " + i );
+
+other = s1.getOther( s1.getServer( "test" ) ).name;
+for ( i=1; i<keys.length - 1; i+=2 )
+    assert( s1.adminCommand( { movechunk : "test.foo" , find : { k : keys[i] } , to : other } ).ok , "move " + i );
+
+s1.printChunks();
+
+// s2 is stale; each lookup must end up at the right shard
+for ( i=0; i<keys.length; i++ ) {
+    if ( i == 0 || i == keys.length - 1 )
+        continue; // MinKey and MaxKey can't be queried by equality
+    var doc = viaS2.findOne( { k : keys[i] } );
+    assert( doc , "s2 find " + tojson( keys[i] ) );
+    assert.eq( i , doc.i , "s2 find " + tojson( keys[i] ) );
+}
+
+for ( i=1; i<keys.length - 1; i++ ) {
+    viaS2.update( { k : keys[i] } , { $inc : { n : 1 } } );
+    assert.eq( 1 , viaS2.getDB().getLastErrorObj().n , "s2 update " + tojson( keys[i] ) );
+}
+assert.eq( keys.length - 2 , viaS1.find( { n : 1 } ).itcount() , "s2 updates" );
+
+s1.stop();
@@ -154,7 +154,9 @@ assert.eq( 3 , db.foo6.find().count() );
 s.adminCommand( { split : "test.foo6" , middle : { a : 2 } } );
 s.adminCommand( { movechunk : "test.foo6" , find : { a : 3 } , to : s.getOther( s.getServer( "test" ) ).name } );
 
-assert.throws( function(){ db.foo6.group( { key : { a : 1 } , initial : { count : 0 } , reduce : function(z,prev){ prev.count++; } } ); } );;
+// grouped on each shard; every key lives on one shard so the states come back unmerged
+x = db.foo6.group( { key : { a : 1 } , initial : { count : 0 } , reduce : function(z,prev){ prev.count++; } } );
+assert.eq( [ { a : 1 , count : 1 } , { a : 3 , count : 2 } ] , x.sort( function(l,r){ return l.a - r.a; } ) , "sharded group" );
 
 
 // ---- can't shard non-empty collection without index -----
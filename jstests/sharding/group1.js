@@ -0,0 +1,73 @@
+// group on a sharded collection: each shard groups its own documents and the states are merged
+
+s = new ShardingTest( "group1" , 2 , 1 , 1 );
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { _id : 1 } } );
+
+db = s.getDB( "test" );
+for ( i = 0; i < 100; i++ )
+    db.foo.insert( { _id : i , x : i % 4 , y : i } );
+db.getLastError();
+
+s.adminCommand( { split : "test.foo" , middle : { _id : 50 } } );
+s.adminCommand( { movechunk : "test.foo" , find : { _id : 75 } , to : s.getOther( s.getServer( "test" ) ).name } );
+assert.eq( 2 , s.config.chunks.count() , "chunks" );
+
+function byX( l , r ){
+    return l.x - r.x;
+}
+
+// x is spread over both shards.  a plain reduce counts documents, it can't add up two shards'
+// states, so without $combine the group fails rather than return wrong counts
+assert.throws( function(){
+    db.foo.group( { key : { x : 1 } , initial : { count : 0 } , reduce : function( obj , prev ){ prev.count++; } } );
+} , null , "no combine" );
+
+// with $combine the states add up
+res = db.foo.group( { key : { x : 1 } , initial : { count : 0 , total : 0 } ,
+                      reduce : function( obj , prev ){ prev.count++; prev.total += obj.y; } ,
+                      combine : function( state , prev ){ prev.count += state.count; prev.total += state.total; } } );
+assert.eq( 4 , res.length , "keys" );
+res.sort( byX );
+for ( i = 0; i < 4; i++ ) {
+    expected = 0;
+    for ( j = i; j < 100; j += 4 )
+        expected += j;
+    assert.eq( i , res[i].x , "x " + i );
+    assert.eq( 25 , res[i].count , "count " + i );
+    assert.eq( expected , res[i].total , "total " + i );
+}
+
+// a native reduce merges its own states
+res = db.foo.group( { key : { x : 1 } , initial : {} , reduce : { count : { $sum : 1 } } } );
+res.sort( byX );
+assert.eq( [ { x : 0 , count : 25 } , { x : 1 , count : 25 } , { x : 2 , count : 25 } , { x : 3 , count : 25 } ] , res , "native" );
+
+// $combine for a reduce that can't take its own output, plus finalize and cond
+res = db.foo.group( { key : { x : 1 } , initial : { n : 0 } , cond : { y : { $gte : 10 } } ,
+                      reduce : function( obj , prev ){ prev.n++; } ,
+                      combine : function( state , prev ){ prev.n += state.n; } ,
+                      finalize : function( out ){ out.half = out.n / 2; } } );
+assert.eq( 4 , res.length , "keys 2" );
+res.sort( byX );
+assert.eq( [ { x : 0 , n : 22 , half : 11 } , { x : 1 , n : 22 , half : 11 } ,
+             { x : 2 , n : 23 , half : 11.5 } , { x : 3 , n : 23 , half : 11.5 } ] , res , "combine" );
+
+// a cond on the shard key only goes to one shard
+res = db.foo.group( { key : { x : 1 } , initial : { n : 0 } , cond : { _id : { $lt : 10 } } ,
+                      reduce : function( obj , prev ){ prev.n++; } } );
+res.sort( byX );
+assert.eq( [ { x : 0 , n : 3 } , { x : 1 , n : 3 } , { x : 2 , n : 2 } , { x : 3 , n : 2 } ] , res , "one shard" );
+
+// keyf and the raw command
+res = db.runCommand( { group : { ns : "foo" , $keyf : function( doc ){ return { odd : doc.y % 2 }; } ,
+                                 initial : { n : 0 } , $reduce : function( obj , prev ){ prev.n++; } ,
+                                 $combine : function( state , prev ){ prev.n += state.n; } } } );
+assert( res.ok , tojson( res ) );
+assert.eq( 100 , res.count , "count" );
+assert.eq( 2 , res.keys , "keys 3" );
+res.retval.sort( function( l , r ){ return l.odd - r.odd; } );
+assert.eq( [ { odd : 0 , n : 50 } , { odd : 1 , n : 50 } ] , res.retval , "keyf" );
+
+s.stop();
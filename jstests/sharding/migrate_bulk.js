@@ -0,0 +1,42 @@
+// chunk migration sends the initial clone compressed, and records what it moved in the changelog
+
+s = new ShardingTest( "migrate_bulk" , 2 , 0 , 1 );
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { x : 1 } } );
+
+db = s.getDB( "test" );
+coll = db.foo;
+
+big = "";
+while ( big.length < 2000 )
+    big += "migrate bulk ";
+
+// more than one batch worth
+N = 12000;
+for ( x=0; x<N; x++ )
+    coll.insert( { x : x , big : big } );
+db.getLastError();
+
+s.adminCommand( { split : "test.foo" , middle : { x : N / 2 } } );
+
+to = s.getOther( s.getServer( "test" ) );
+assert( s.adminCommand( { movechunk : "test.foo" , find : { x : N - 1 } , to : to.name } ).ok , "move" );
+
+assert.eq( N , coll.find().itcount() , "total" );
+assert.eq( N / 2 , to.getDB( "test" ).foo.count() , "on new shard" );
+assert.eq( N / 2 , to.getDB( "test" ).foo.find( { x : { $gte : N / 2 } } ).hint( { x : 1 } ).itcount() , "index on new shard" );
+
+config = s.getDB( "config" );
+toLog = config.changelog.find( { what : "moveChunk.to" } ).sort( { time : -1 } ).next();
+printjson( toLog );
+assert.eq( N / 2 , toLog.details.clonedDocs , "to clonedDocs" );
+assert.lt( toLog.details.recvBytes , toLog.details.clonedBytes , "compressed" );
+assert( toLog.details.clonedBytesPerSec > 0 , "throughput" );
+
+fromLog = config.changelog.find( { what : "moveChunk.from" } ).sort( { time : -1 } ).next();
+printjson( fromLog );
+assert.eq( N / 2 , fromLog.details.clonedDocs , "from clonedDocs" );
+assert.eq( toLog.details.recvBytes , fromLog.details.sentBytes , "sent == received" );
+
+s.stop();
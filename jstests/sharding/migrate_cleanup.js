@@ -0,0 +1,44 @@
+// deleting a moved chunk from the donor is throttled by rangeDeleteMBPerSec and logged to the changelog
+
+s = new ShardingTest( "migrate_cleanup" , 2 , 0 , 1 );
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { x : 1 } } );
+
+db = s.getDB( "test" );
+
+big = "";
+while ( big.length < 1000 )
+    big += "cleanup ";
+
+N = 4000;
+for ( x=0; x<N; x++ )
+    db.foo.insert( { x : x , big : big } );
+db.getLastError();
+
+from = s.getServer( "test" );
+to = s.getOther( from );
+
+assert( ! from.getDB( "admin" ).runCommand( { setParameter : 1 , rangeDeleteMBPerSec : -1 } ).ok , "negative rate" );
+assert( from.getDB( "admin" ).runCommand( { setParameter : 1 , rangeDeleteMBPerSec : 1 , rangeDeleteYieldMillis : 5 } ).ok );
+assert.eq( 1 , from.getDB( "admin" ).runCommand( { getParameter : 1 , rangeDeleteMBPerSec : 1 } ).rangeDeleteMBPerSec );
+
+s.adminCommand( { split : "test.foo" , middle : { x : N / 2 } } );
+assert( s.adminCommand( { movechunk : "test.foo" , find : { x : N - 1 } , to : to.name } ).ok , "move" );
+
+config = s.getDB( "config" );
+assert.soon( function(){ return config.changelog.findOne( { what : "moveChunk.cleanup" } ) != null; } ,
+             "cleanup not logged" , 60000 );
+
+log = config.changelog.findOne( { what : "moveChunk.cleanup" } );
+printjson( log );
+assert.eq( N / 2 , log.details.deleted , "deleted" );
+assert( log.details.bytes > N / 2 * big.length , "bytes" );
+// ~2MB at 1MB/sec
+assert( log.details.millis >= 1000 , "throttled" );
+assert( log.details.bytesPerSec <= 1.5 * 1024 * 1024 , "rate" );
+
+assert.eq( N / 2 , from.getDB( "test" ).foo.count() , "left on donor" );
+assert.eq( N , db.foo.find().itcount() , "total" );
+
+s.stop();
@@ -0,0 +1,59 @@
+// count/distinct/dataSize/collStats are sent to all shards at once; maxTimeMS gives up on slow shards,
+// and what the other shards returned comes back flagged partial
+
+s = new ShardingTest( "parallel_commands" , 2 , 1 , 1 );
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { _id : 1 } } );
+
+db = s.getDB( "test" );
+for ( i = 0; i < 100; i++ )
+    db.foo.insert( { _id : i , x : i % 5 } );
+db.getLastError();
+
+s.adminCommand( { split : "test.foo" , middle : { _id : 50 } } );
+s.adminCommand( { movechunk : "test.foo" , find : { _id : 75 } , to : s.getOther( s.getServer( "test" ) ).name } );
+assert.eq( 2 , s.config.chunks.count() , "chunks" );
+
+res = db.runCommand( { count : "foo" } );
+assert.eq( 100 , res.n , "count" );
+assert.eq( 50 , res.shards.shard0000 , "count shard0000" );
+assert.eq( 50 , res.shards.shard0001 , "count shard0001" );
+assert.eq( 20 , db.foo.count( { x : 3 } ) , "count query" );
+
+assert.eq( [ 0 , 1 , 2 , 3 , 4 ] , db.foo.distinct( "x" ) , "distinct" );
+
+stats = db.foo.stats();
+assert.eq( 100 , stats.count , "stats count" );
+assert.eq( 2 , Object.keySet( stats.shards ).length , "stats shards" );
+
+res = db.runCommand( { dataSize : "test.foo" , keyPattern : { _id : 1 } , min : { _id : 0 } , max : { _id : 100 } } );
+assert( res.ok , "dataSize " + tojson( res ) );
+assert.eq( 100 , res.numObjects , "dataSize numObjects" );
+
+// a generous deadline doesn't change anything
+assert.eq( 100 , db.runCommand( { count : "foo" , maxTimeMS : 60000 } ).n , "count with deadline" );
+
+// each shard takes ~50 * 20ms here, well past the deadline
+res = db.runCommand( { count : "foo" , query : { $where : "sleep( 20 ); return true;" } , maxTimeMS : 200 } );
+assert( ! res.ok , "expected timeout " + tojson( res ) );
+assert.eq( 2 , res.timedOut.shards.length , "timed out shards " + tojson( res ) );
+
+// only the shard with _id >= 50 is slow: the other shard's count comes back, marked partial
+res = db.runCommand( { count : "foo" , query : { $where : "if ( this._id >= 50 ) sleep( 20 ); return true;" } , maxTimeMS : 200 } );
+assert( res.ok , "partial count " + tojson( res ) );
+assert( res.partial , "partial flag " + tojson( res ) );
+assert.eq( 50 , res.n , "partial count n " + tojson( res ) );
+assert.eq( 1 , res.timedOut.shards.length , "partial count timed out shards " + tojson( res ) );
+
+// same for a shard that fails
+res = db.runCommand( { distinct : "foo" , key : "x" , query : { $where : "if ( this._id >= 50 ) throw 'boom'; return true;" } } );
+assert( res.ok , "partial distinct " + tojson( res ) );
+assert( res.partial , "partial distinct flag " + tojson( res ) );
+assert.eq( 5 , res.values.length , "partial distinct values " + tojson( res ) );
+assert.eq( 1 , Object.keySet( res.shardErrors ).length , "partial distinct shard errors " + tojson( res ) );
+
+// shards are left in a usable state
+assert.eq( 100 , db.foo.count() , "count after timeout" );
+
+s.stop();
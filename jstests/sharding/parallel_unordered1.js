@@ -0,0 +1,34 @@
+// unsorted queries go to all shards at once and results are interleaved
+
+s = new ShardingTest( "parallel_unordered1" , 2 , 1 , 1 );
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { x : 1 } } );
+
+db = s.getDB( "test" );
+
+for ( i=0; i<200; i++ )
+    db.foo.insert( { x : i , s : "asdasdasdasdasdasdasdasdasdasdasd" } );
+db.getLastError();
+
+s.adminCommand( { split : "test.foo" , middle : { x : 100 } } );
+s.adminCommand( { movechunk : "test.foo" , find : { x : 150 } , to : s.getOther( s.getServer( "test" ) ).name } );
+
+assert.eq( 2 , s.config.chunks.count() , "wrong number of chunks" );
+
+assert.eq( 200 , db.foo.find().itcount() , "all" );
+assert.eq( 200 , db.foo.find().batchSize( 7 ).itcount() , "batchSize" );
+assert.eq( 50 , db.foo.find().limit( 50 ).itcount() , "limit" );
+assert.eq( 150 , db.foo.find().skip( 50 ).itcount() , "skip" );
+assert.eq( 20 , db.foo.find().skip( 90 ).limit( 20 ).batchSize( 3 ).itcount() , "skip limit batchSize" );
+
+seen = {};
+db.foo.find().batchSize( 5 ).forEach( function( z ){ assert( ! seen[z.x] , "dup " + z.x ); seen[z.x] = true; } );
+assert.eq( 200 , Object.keySet( seen ).length , "unique" );
+
+exp = db.foo.find( { x : { $gt : 50 } } ).explain();
+assert.eq( "ParallelUnordered" , exp.clusteredType , "explain type" );
+assert.eq( 2 , exp.numShards , "explain shards" );
+assert.eq( 149 , exp.n , "explain n" );
+
+s.stop();
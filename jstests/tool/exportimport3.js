@@ -0,0 +1,27 @@
+// exportimport3.js
+// a collection spanning many getMore batches, which mongoexport reads ahead
+
+t = new ToolTest( "exportimport3" );
+
+c = t.startDB( "foo" );
+
+s = "";
+while ( s.length < 500 )
+    s += "exportimport3 ";
+
+N = 20000;
+for ( i=0; i<N; i++ )
+    c.insert( { _id : i , s : s } );
+assert.eq( N , c.count() , "setup" );
+
+t.runTool( "export" , "--out" , t.extFile , "-d" , t.baseName , "-c" , "foo" );
+
+c.drop();
+assert.eq( 0 , c.count() , "after drop" );
+
+t.runTool( "import" , "--file" , t.extFile , "-d" , t.baseName , "-c" , "foo" );
+assert.soon( "c.count() == N" , "not all data after import" );
+assert.eq( N - 1 , c.find().sort( { _id : -1 } ).next()._id , "last" );
+assert.eq( s , c.findOne( { _id : N / 2 } ).s , "middle" );
+
+t.stop();
@@ -0,0 +1,29 @@
+// $where is evaluated after the other predicates of the query, and its scope lasts across getMores
+
+t = db.where4;
+t.drop();
+
+for ( i=0; i<100; i++ )
+    t.save( { i : i , a : { b : i % 2 } } );
+t.save( { i : 100 } );
+
+// this.a.b throws for the document without a; the plain predicates rule it out first
+assert.eq( 50 , t.find( { a : { $exists : true } , $where : "return this.a.b == 1;" } ).count() , "A" );
+assert.eq( 51 , t.find( { $or : [ { $where : "return this.a.b == 1;" } , { a : { $exists : false } } ] } ).count() , "B" );
+assert.eq( 50 , t.find( { $nor : [ { $where : "return this.a.b == 1;" } , { a : { $exists : false } } ] } ).count() , "C" );
+
+// an index bounds what reaches the function
+t.ensureIndex( { i : 1 } );
+assert.eq( 5 , t.find( { i : { $lt : 10 } , $where : "return this.a.b == 1;" } ).count() , "D" );
+
+// several batches with the same function
+c = t.find( { $where : "return this.i < 100 && this.a.b == 0;" } ).batchSize( 5 );
+n = 0;
+while ( c.hasNext() ) {
+    assert.eq( 0 , c.next().a.b , "E" );
+    n++;
+}
+assert.eq( 50 , n , "F" );
+
+// a compile error still surfaces once a document reaches the function
+assert.throws( function() { t.find( { $where : "return this.i ==" } ).itcount(); } , null , "G" );
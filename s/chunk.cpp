@@ -277,6 +277,7 @@ namespace mongo {
             setMax(m[0].getOwned());
             DEV assert( shared_from_this() );
             _manager->_chunkMap[_max] = shared_from_this();
+            _manager->_updateRouting_inlock( _min , _max );
         }
 
         // return the second half, if a single split, or the first new chunk, if a multisplit.
@@ -534,6 +535,18 @@ namespace mongo {
     }
 
     void ChunkManager::_reload_inlock() {
+        if ( ! _chunkMap.empty() ) {
+            try {
+                if ( _loadDiff_inlock() ) {
+                    _sequenceNumber = ++NextSequenceNumber;
+                    return;
+                }
+            }
+            catch ( std::exception& e ) {
+                log() << "ChunkManager: incremental reload of " << _ns << " failed, reloading everything: " << e.what() << endl;
+            }
+        }
+
         int tries = 3;
         while (tries--) {
             _chunkMap.clear();
@@ -549,6 +562,7 @@ namespace mongo {
                 // the most up to date value.
                 _sequenceNumber = ++NextSequenceNumber;
 
+                _rebuildRouting_inlock();
                 return;
             }
 
@@ -586,6 +600,110 @@ namespace mongo {
         conn.done();
     }
 
+    /**
+     * brings _chunkMap up to date by reading only the chunks with a newer version than any we have.
+     * a split or migrate gives every chunk it changes a version above the collection's previous
+     * max, so those chunks replace whatever they overlap.
+     * @return false if the result doesn't add up; the caller should load everything instead.
+     */
+    bool ChunkManager::_loadDiff_inlock() {
+        ShardChunkVersion max = 0;
+        for ( ChunkMap::const_iterator i=_chunkMap.begin(); i!=_chunkMap.end(); ++i ) {
+            if ( i->second->getLastmod() > max )
+                max = i->second->getLastmod();
+        }
+
+        vector<ChunkPtr> changed;
+        unsigned long long total;
+        {
+            ScopedDbConnection conn( configServer.modelServer() );
+
+            BSONObjBuilder q;
+            q.append( "ns" , _ns );
+            {
+                BSONObjBuilder lastmod( q.subobjStart( "lastmod" ) );
+                lastmod.appendTimestamp( "$gt" , max );
+                lastmod.done();
+            }
+
+            auto_ptr<DBClientCursor> cursor = conn->query( Chunk::chunkMetadataNS , Query( q.obj() ).sort( "lastmod" , 1 ) );
+            assert( cursor.get() );
+            while ( cursor->more() ) {
+                BSONObj d = cursor->next();
+                if ( d["isMaxMarker"].trueValue() )
+                    continue;
+
+                ChunkPtr c( new Chunk( this ) );
+                c->unserialize( d );
+                changed.push_back( c );
+            }
+
+            // a drop and reshard starts the versions over, which the query above can't see
+            total = conn->count( Chunk::chunkMetadataNS , BSON( "ns" << _ns << "isMaxMarker" << BSON( "$ne" << true ) ) );
+            conn.done();
+        }
+
+        if ( changed.empty() )
+            return total == _chunkMap.size();
+
+        for ( unsigned i=0; i<changed.size(); i++ ) {
+            ChunkPtr c = changed[i];
+
+            // drop everything that overlaps [min,max)
+            ChunkMap::iterator j = _chunkMap.upper_bound( c->getMin() );
+            while ( j != _chunkMap.end() && j->second->getMin().woCompare( c->getMax() ) < 0 )
+                _chunkMap.erase( j++ );
+
+            _chunkMap[c->getMax()] = c;
+        }
+
+        if ( _chunkMap.size() != total || ! _isValid() ) {
+            log() << "ChunkManager: incremental reload of " << _ns << " doesn't add up, reloading everything" << endl;
+            _chunkMap.clear();
+            return false;
+        }
+
+        _shards.clear();
+        for ( ChunkMap::const_iterator i=_chunkMap.begin(); i!=_chunkMap.end(); ++i )
+            _shards.insert( i->second->getShard() );
+
+        // only the boundaries we were told about moved, so the other ranges stand
+        for ( unsigned i=0; i<changed.size(); i++ ) {
+            _chunkRanges.reloadRange( _chunkMap , changed[i]->getMin() , changed[i]->getMax() );
+            _updateRouting_inlock( changed[i]->getMin() , changed[i]->getMax() );
+        }
+
+        log(1) << "ChunkManager: reloaded " << changed.size() << " changed chunks of " << _ns << endl;
+        return true;
+    }
+
+    void ChunkManager::_rebuildRouting_inlock() {
+        _setRouting_inlock( ChunkRoutingTablePtr( new ChunkRoutingTable( _chunkMap ) ) );
+    }
+
+    void ChunkManager::_updateRouting_inlock( const BSONObj& min , const BSONObj& max ) {
+        ChunkRoutingTablePtr prev = _getRouting();
+        if ( ! prev ) {
+            _rebuildRouting_inlock();
+            return;
+        }
+        _setRouting_inlock( ChunkRoutingTablePtr( new ChunkRoutingTable( *prev , _chunkMap , min , max ) ) );
+    }
+
+    void ChunkManager::_setRouting_inlock( ChunkRoutingTablePtr r ) {
+        _routingLock.lock();
+        _routing.swap( r );
+        _routingLock.unlock();
+        // the old table, if no one else holds it, goes away here outside the spin lock
+    }
+
+    ChunkRoutingTablePtr ChunkManager::_getRouting() const {
+        _routingLock.lock();
+        ChunkRoutingTablePtr r = _routing;
+        _routingLock.unlock();
+        return r;
+    }
+
     bool ChunkManager::_isValid() const {
 #define ENSURE(x) do { if(!(x)) { log() << "ChunkManager::_isValid failed: " #x << endl; return false; } } while(0)
 
@@ -662,6 +780,7 @@ namespace mongo {
         _chunkRanges.reloadAll(_chunkMap);
         _shards.insert(c->getShard());
         c->setLastmod(version);
+        _rebuildRouting_inlock();
 
         // the ensure index will have the (desired) indirect effect of creating the collection on the
         // assigned shard, as it sets up the index over the sharding keys.
@@ -673,6 +792,17 @@ namespace mongo {
     ChunkPtr ChunkManager::findChunk( const BSONObj & obj , bool retry ) {
         BSONObj key = _key.extractKey(obj);
 
+        {
+            // the common case: no lock, one encode and a binary search
+            ChunkRoutingTablePtr routing = _getRouting();
+            if ( routing ) {
+                // check the table's copies of the bounds, not the chunk's: a split resets those under _lock
+                const ChunkRoutingTable::Entry * e = routing->find( key );
+                if ( e && _key.compare( e->minObj , obj ) <= 0 && _key.compare( obj , e->maxObj ) < 0 )
+                    return e->chunk;
+            }
+        }
+
         {
             rwlock lk( _lock , false );
 
@@ -852,6 +982,7 @@ namespace mongo {
         _chunkMap.clear();
         _chunkRanges.clear();
         _shards.clear();
+        _rebuildRouting_inlock();
 
         // delete data from mongod
         for ( set<Shard>::iterator i=seen.begin(); i!=seen.end(); i++ ) {
@@ -943,6 +1074,85 @@ namespace mongo {
         return ss.str();
     }
 
+    // -------  ChunkRoutingTable --------
+
+    ChunkRoutingTable::ChunkRoutingTable( const ChunkMap& chunks ) {
+        _build( chunks );
+    }
+
+    ChunkRoutingTable::ChunkRoutingTable( const ChunkRoutingTable& prev , const ChunkMap& chunks , const BSONObj& min , const BSONObj& max ) {
+        KeyString kmin( min , ordering() );
+        KeyString kmax( max , ordering() );
+
+        // [lo,hi) are the entries of prev that overlap [min,max)
+        vector<EntryPtr>::const_iterator lo = upper_bound( prev._entries.begin() , prev._entries.end() , kmin , MaxGreater() );
+        vector<EntryPtr>::const_iterator hi = lo;
+        while ( hi != prev._entries.end() && (*hi)->min < kmax )
+            ++hi;
+
+        if ( lo == hi ) {
+            _build( chunks );
+            return;
+        }
+
+        // the chunks now covering the span those entries covered, which must tile it exactly
+        const BSONObj& from = (*lo)->minObj;
+        const BSONObj& to = (*(hi-1))->maxObj;
+        ChunkMap::const_iterator begin = chunks.upper_bound( from );
+        ChunkMap::const_iterator end = chunks.upper_bound( to );
+
+        BSONObj last = from;
+        for ( ChunkMap::const_iterator i=begin; i!=end; ++i ) {
+            if ( i->second->getMin().woCompare( last ) ) {
+                _build( chunks );
+                return;
+            }
+            last = i->first;
+        }
+        if ( last.woCompare( to ) || begin == end ) {
+            _build( chunks );
+            return;
+        }
+
+        _entries.reserve( prev._entries.size() - ( hi - lo ) + distance( begin , end ) );
+        _entries.insert( _entries.end() , prev._entries.begin() , lo );
+        for ( ChunkMap::const_iterator i=begin; i!=end; ++i )
+            _entries.push_back( _entry( i->first , i->second ) );
+        _entries.insert( _entries.end() , hi , prev._entries.end() );
+    }
+
+    void ChunkRoutingTable::_build( const ChunkMap& chunks ) {
+        _entries.clear();
+        _entries.reserve( chunks.size() );
+        for ( ChunkMap::const_iterator i=chunks.begin(); i!=chunks.end(); ++i )
+            _entries.push_back( _entry( i->first , i->second ) );
+    }
+
+    ChunkRoutingTable::EntryPtr ChunkRoutingTable::_entry( const BSONObj& max , const ChunkPtr& c ) {
+        shared_ptr<Entry> e( new Entry() );
+        e->minObj = c->getMin().getOwned();
+        e->maxObj = max.getOwned();
+        e->min.reset( e->minObj , ordering() );
+        e->max.reset( e->maxObj , ordering() );
+        e->chunk = c;
+        return e;
+    }
+
+    const Ordering& ChunkRoutingTable::ordering() {
+        static const Ordering o = Ordering::make( BSONObj() );
+        return o;
+    }
+
+    const ChunkRoutingTable::Entry * ChunkRoutingTable::find( const BSONObj& key ) const {
+        KeyString k( key , ordering() );
+
+        // first max > key, like ChunkMap::upper_bound
+        vector<EntryPtr>::const_iterator i = upper_bound( _entries.begin() , _entries.end() , k , MaxGreater() );
+        if ( i == _entries.end() || k < (*i)->min )
+            return 0;
+        return i->get();
+    }
+
     void ChunkRangeManager::assertValid() const {
         if (_ranges.empty())
             return;
@@ -23,6 +23,8 @@
 #include "../bson/util/atomic_int.h"
 #include "../client/dbclient.h"
 #include "../client/distlock.h"
+#include "../db/keystring.h"
+#include "../util/concurrency/spin_lock.h"
 
 #include "shardkey.h"
 #include "shard.h"
@@ -289,6 +291,56 @@ namespace mongo {
         ChunkRangeMap _ranges;
     };
 
+    /**
+     * an immutable copy of a ChunkManager's chunk boundaries for routing: the min and max of every
+     * chunk, as KeyStrings and as owned BSONObjs, in order, next to its chunk.  findChunk binary
+     * searches it with memcmp and checks the copied bounds without taking the ChunkManager's lock,
+     * so it never reads a Chunk's _min or _max, which a split resets under that lock.  when chunks
+     * change a new table is swapped in; readers holding the old one keep using it until they let go.
+     */
+    class ChunkRoutingTable : boost::noncopyable {
+    public:
+        struct Entry {
+            KeyString min;
+            KeyString max;
+            BSONObj minObj;
+            BSONObj maxObj;
+            ChunkPtr chunk;
+        };
+
+        ChunkRoutingTable( const ChunkMap& chunks );
+
+        /**
+         * prev with the entries overlapping [min,max) read again from chunks.  the entries outside
+         * that range are shared with prev rather than encoded again.  if chunks doesn't cover the
+         * same span as the entries it replaces, everything is built from chunks.
+         */
+        ChunkRoutingTable( const ChunkRoutingTable& prev , const ChunkMap& chunks , const BSONObj& min , const BSONObj& max );
+
+        /** @return the entry whose KeyString range holds key (an extracted shard key), or null */
+        const Entry * find( const BSONObj& key ) const;
+
+        int size() const { return (int) _entries.size(); }
+
+    private:
+        typedef shared_ptr<const Entry> EntryPtr;
+
+        // first entry with max > k
+        struct MaxGreater {
+            bool operator()( const KeyString& k , const EntryPtr& e ) const { return k < e->max; }
+        };
+
+        // the ChunkMap is ordered by plain woCompare, which is all ascending
+        static const Ordering& ordering();
+
+        static EntryPtr _entry( const BSONObj& max , const ChunkPtr& c );
+        void _build( const ChunkMap& chunks );
+
+        vector<EntryPtr> _entries;
+    };
+
+    typedef shared_ptr<const ChunkRoutingTable> ChunkRoutingTablePtr;
+
     /* config.sharding
          { ns: 'alleyinsider.fs.chunks' ,
            key: { ts : 1 } ,
@@ -347,6 +399,14 @@ namespace mongo {
         void _reload();
         void _reload_inlock();
         void _load();
+        bool _loadDiff_inlock();
+
+        /** call after any change to _chunkMap, with _lock held for writing */
+        void _rebuildRouting_inlock();
+        /** same, when only the chunks in [min,max) changed */
+        void _updateRouting_inlock( const BSONObj& min , const BSONObj& max );
+        void _setRouting_inlock( ChunkRoutingTablePtr r );
+        ChunkRoutingTablePtr _getRouting() const;
 
         void ensureIndex_inlock();
 
@@ -357,6 +417,9 @@ namespace mongo {
         ChunkMap _chunkMap;
         ChunkRangeManager _chunkRanges;
 
+        ChunkRoutingTablePtr _routing; // swapped under _routingLock, which is only held to copy the pointer
+        mutable SpinLock _routingLock;
+
         set<Shard> _shards;
 
         unsigned long long _sequenceNumber;
@@ -389,44 +389,43 @@ namespace mongo {
 
                     bool hadToBreak = false;
 
+                    ParallelCommand pc( dbName , ParallelCommand::timeoutFor( cmdObj ) );
                     for (set<Shard>::iterator it=shards.begin(), end=shards.end(); it != end; ++it) {
-                        ShardConnection conn(*it, fullns);
-                        if ( conn.setVersion() ) {
-                            total = 0;
-                            shardCounts.clear();
+                        if ( pc.spawn( *it , fullns , BSON( "count" << collection << "query" << filter ) ) ) {
                             cm = conf->getChunkManager( fullns );
-                            conn.done();
                             hadToBreak = true;
                             break;
                         }
+                    }
 
-                        BSONObj temp;
-                        bool ok = conn->runCommand( dbName , BSON( "count" << collection << "query" << filter ) , temp );
-                        conn.done();
-
-                        if ( ok ) {
-                            long long mine = temp["n"].numberLong();
+                    ParallelCommand::Result res;
+                    while ( ! hadToBreak && pc.next( res ) ) {
+                        if ( res.ok ) {
+                            long long mine = res.res["n"].numberLong();
                             total += mine;
-                            shardCounts[it->getName()] = mine;
+                            shardCounts[res.shard] = mine;
                             continue;
                         }
 
-                        if ( StaleConfigInContextCode == temp["code"].numberInt() ) {
+                        if ( StaleConfigInContextCode == res.res["code"].numberInt() ) {
                             // my version is old
-                            total = 0;
-                            shardCounts.clear();
                             cm = conf->getChunkManager( fullns , true );
                             hadToBreak = true;
                             break;
                         }
 
-                        // command failed :(
-                        errmsg = "failed on : " + it->getName();
-                        result.append( "cause" , temp );
-                        return false;
+                        pc.failed( res );
                     }
-                    if ( ! hadToBreak )
-                        break;
+
+                    if ( hadToBreak ) {
+                        total = 0;
+                        shardCounts.clear();
+                        continue;
+                    }
+
+                    if ( ! pc.finish( errmsg , result ) )
+                        return false;
+                    break;
                 }
 
                 total = applySkipLimit( total , cmdObj );
@@ -462,20 +461,23 @@ namespace mongo {
                 set<Shard> servers;
                 cm->getAllShards(servers);
 
-                BSONObjBuilder shardStats;
+                ParallelCommand pc( dbName , ParallelCommand::timeoutFor( cmdObj ) );
+                for ( set<Shard>::iterator i=servers.begin(); i!=servers.end(); i++ )
+                    pc.spawn( *i , "" , cmdObj );
+
+                map<string,BSONObj> shardStats;
                 long long count=0;
                 long long size=0;
                 long long storageSize=0;
                 int nindexes=0;
                 bool warnedAboutIndexes = false;
-                for ( set<Shard>::iterator i=servers.begin(); i!=servers.end(); i++ ) {
-                    ScopedDbConnection conn( *i );
-                    BSONObj res;
-                    if ( ! conn->runCommand( dbName , cmdObj , res ) ) {
-                        errmsg = "failed on shard: " + res.toString();
-                        return false;
+                ParallelCommand::Result r;
+                while ( pc.next( r ) ) {
+                    const BSONObj& res = r.res;
+                    if ( ! r.ok ) {
+                        pc.failed( r );
+                        continue;
                     }
-                    conn.done();
 
                     count += res["count"].numberLong();
                     size += res["size"].numberLong();
@@ -501,9 +503,12 @@ namespace mongo {
                         }
                     }
 
-                    shardStats.append(i->getName(), res);
+                    shardStats[r.shard] = res;
                 }
 
+                if ( ! pc.finish( errmsg , result ) )
+                    return false;
+
                 result.append("ns", fullns);
                 result.appendNumber("count", count);
                 result.appendNumber("size", size);
@@ -512,7 +517,10 @@ namespace mongo {
                 result.append("nindexes", nindexes);
 
                 result.append("nchunks", cm->numChunks());
-                result.append("shards", shardStats.obj());
+                BSONObjBuilder shards( result.subobjStart( "shards" ) );
+                for ( map<string,BSONObj>::iterator i=shardStats.begin(); i!=shardStats.end(); ++i )
+                    shards.append( i->first , i->second );
+                shards.done();
 
                 return true;
             }
@@ -583,15 +591,17 @@ namespace mongo {
 
                 set<Shard> shards;
                 cm->getShardsForRange(shards, min, max);
-                for ( set<Shard>::iterator i=shards.begin(), end=shards.end() ; i != end; ++i ) {
-                    ScopedDbConnection conn( *i );
-                    BSONObj res;
-                    bool ok = conn->runCommand( conf->getName() , cmdObj , res );
-                    conn.done();
 
-                    if ( ! ok ) {
-                        result.appendElements( res );
-                        return false;
+                ParallelCommand pc( conf->getName() , ParallelCommand::timeoutFor( cmdObj ) );
+                for ( set<Shard>::iterator i=shards.begin(), end=shards.end() ; i != end; ++i )
+                    pc.spawn( *i , "" , cmdObj );
+
+                ParallelCommand::Result r;
+                while ( pc.next( r ) ) {
+                    const BSONObj& res = r.res;
+                    if ( ! r.ok ) {
+                        pc.failed( r );
+                        continue;
                     }
 
                     size       += res["size"].number();
@@ -600,6 +610,9 @@ namespace mongo {
 
                 }
 
+                if ( ! pc.finish( errmsg , result ) )
+                    return false;
+
                 result.append( "size", size );
                 result.append( "numObjects" , numObjects );
                 result.append( "millis" , millis );
@@ -619,14 +632,77 @@ namespace mongo {
         } convertToCappedCmd;
 
 
-        class GroupCmd : public NotAllowedOnShardedCollectionCmd  {
+        class GroupCmd : public PublicGridCommand {
         public:
-            GroupCmd() : NotAllowedOnShardedCollectionCmd("group") {}
-
-            virtual string getFullNS( const string& dbName , const BSONObj& cmdObj ) {
-                return dbName + "." + cmdObj.firstElement().embeddedObjectUserCheck()["ns"].valuestrsafe();
+            GroupCmd() : PublicGridCommand("group") {}
+            virtual void help( stringstream &help ) const {
+                help << "http://www.mongodb.org/display/DOCS/Aggregation\n"
+                     "on a sharded collection each shard groups its own documents; states for keys found on more "
+                     "than one shard are merged with $combine before finalize, and are an error without it";
             }
+            bool run(const string& dbName , BSONObj& cmdObj, string& errmsg, BSONObjBuilder& result, bool) {
+                BSONObj p = cmdObj.firstElement().embeddedObjectUserCheck();
+                string fullns = dbName + "." + p["ns"].valuestrsafe();
+
+                DBConfigPtr conf = grid.getDBConfig( dbName , false );
+
+                if ( ! conf || ! conf->isShardingEnabled() || ! conf->isSharded( fullns ) ) {
+                    return passthrough( conf , cmdObj , result );
+                }
+
+                ChunkManagerPtr cm = conf->getChunkManager( fullns );
+                massert( 13662 ,  "how could chunk manager be null!" , cm );
 
+                BSONObj query;
+                if ( p["cond"].type() == Object )
+                    query = p["cond"].embeddedObject();
+                else if ( p["condition"].type() == Object )
+                    query = p["condition"].embeddedObject();
+                else
+                    query = getQuery( p );
+
+                set<Shard> shards;
+                cm->getShardsForQuery( shards , query );
+
+                // each shard reduces its own documents and sends back per key states, unfinalized
+                BSONObjBuilder partialCmd;
+                partialCmd.appendElements( cmdObj );
+                partialCmd.appendBool( "partial" , true );
+                BSONObj shardCmd = partialCmd.obj();
+
+                ParallelCommand pc( dbName , ParallelCommand::timeoutFor( cmdObj ) );
+                for ( set<Shard>::iterator i=shards.begin(), end=shards.end() ; i != end; ++i )
+                    pc.spawn( *i , fullns , shardCmd );
+
+                BSONObjBuilder shardResults;
+                ParallelCommand::Result r;
+                while ( pc.next( r ) ) {
+                    if ( ! r.ok ) {
+                        pc.failed( r );
+                        continue;
+                    }
+                    shardResults.append( r.shard , r.res );
+                }
+
+                if ( ! pc.finish( errmsg , result ) )
+                    return false;
+
+                // mongos has no js, so the states are merged and finalized on the primary
+                ShardConnection conn( conf->getPrimary() , "" );
+                BSONObj res;
+                bool ok = conn->runCommand( dbName , BSON( "group.shardedfinish" << p << "shards" << shardResults.obj() ) , res );
+                conn.done();
+
+                if ( ! ok ) {
+                    errmsg = "merge failed: " + res.toString();
+                    return false;
+                }
+
+                result.append( res["retval"] );
+                result.append( res["count"] );
+                result.append( res["keys"] );
+                return true;
+            }
         } groupCmd;
 
         class DistinctCmd : public PublicGridCommand {
@@ -655,15 +731,16 @@ namespace mongo {
                 set<BSONObj,BSONObjCmp> all;
                 int size = 32;
 
-                for ( set<Shard>::iterator i=shards.begin(), end=shards.end() ; i != end; ++i ) {
-                    ShardConnection conn( *i , fullns );
-                    BSONObj res;
-                    bool ok = conn->runCommand( conf->getName() , cmdObj , res );
-                    conn.done();
+                ParallelCommand pc( conf->getName() , ParallelCommand::timeoutFor( cmdObj ) );
+                for ( set<Shard>::iterator i=shards.begin(), end=shards.end() ; i != end; ++i )
+                    pc.spawn( *i , fullns , cmdObj );
 
-                    if ( ! ok ) {
-                        result.appendElements( res );
-                        return false;
+                ParallelCommand::Result r;
+                while ( pc.next( r ) ) {
+                    const BSONObj& res = r.res;
+                    if ( ! r.ok ) {
+                        pc.failed( r );
+                        continue;
                     }
 
                     BSONObjIterator it( res["values"].embeddedObject() );
@@ -676,6 +753,9 @@ namespace mongo {
 
                 }
 
+                if ( ! pc.finish( errmsg , result ) )
+                    return false;
+
                 BSONObjBuilder b( size );
                 int n=0;
                 for ( set<BSONObj,BSONObjCmp>::iterator i = all.begin() ; i != all.end(); i++ ) {
@@ -842,6 +922,7 @@ namespace mongo {
                             fn == "query" ||
                             fn == "sort" ||
                             fn == "scope" ||
+                            fn == "threads" ||
                             fn == "verbose" ) {
                         b.append( e );
                     }
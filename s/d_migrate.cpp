@@ -43,6 +43,7 @@
 #include "../util/queue.h"
 #include "../util/unittest.h"
 #include "../util/processinfo.h"
+#include "../util/compress.h"
 
 #include "shard.h"
 #include "d_logic.h"
@@ -103,6 +104,11 @@ namespace mongo {
         }
 
 
+        /** a number for the changelog entry that isn't a step time, e.g. how much was cloned */
+        void appendNumber( const string& field , long long n ) {
+            _b.appendNumber( field , n );
+        }
+
         void note( const string& s ) {
             string field = "note";
             if ( _nextNote > 0 ) {
@@ -153,10 +159,28 @@ namespace mongo {
 
         void doRemove() {
             ShardForceVersionOkModeBlock sf;
-            writelock lk(ns);
-            RemoveSaver rs("moveChunk",ns,"post-cleanup");
-            long long num = Helpers::removeRange( ns , min , max , true , false , cmdLine.moveParanoia ? &rs : 0 );
-            log() << "moveChunk deleted: " << num << endl;
+            Helpers::RemoveRangeThrottle throttle;
+            throttle.yieldMillis = cmdLine.rangeDeleteYieldMillis;
+            throttle.maxBytesPerSec = cmdLine.rangeDeleteMBPerSec * 1024LL * 1024;
+
+            long long num;
+            {
+                writelock lk(ns);
+                RemoveSaver rs("moveChunk",ns,"post-cleanup");
+                num = Helpers::removeRange( ns , min , max , true , false , cmdLine.moveParanoia ? &rs : 0 , &throttle );
+            }
+
+            long long bytesPerSec = throttle.millis ? throttle.bytes * 1000 / throttle.millis : throttle.bytes;
+            log() << "moveChunk deleted: " << num << " bytes: " << throttle.bytes << " in " << throttle.millis << "ms (" << bytesPerSec << " bytes/sec)" << endl;
+
+            try {
+                configServer.logChange( "moveChunk.cleanup" , ns , BSON( "min" << min << "max" << max << "deleted" << num <<
+                                                                         "bytes" << throttle.bytes << "millis" << throttle.millis <<
+                                                                         "bytesPerSec" << bytesPerSec ) );
+            }
+            catch ( const std::exception& e ) {
+                log( LL_WARNING ) << "couldn't record moveChunk cleanup: " << e.what() << endl;
+            }
         }
 
     };
@@ -247,6 +271,7 @@ namespace mongo {
             _active = false;
             _inCriticalSection = false;
             _memoryUsed = 0;
+            _clonedDocs = _clonedBytes = _sentBytes = 0;
         }
 
         void start( string ns , const BSONObj& min , const BSONObj& max ) {
@@ -267,6 +292,7 @@ namespace mongo {
             assert( _reload.size() == 0 );
             assert( _memoryUsed == 0 );
 
+            _clonedDocs = _clonedBytes = _sentBytes = 0;
             _active = true;
         }
 
@@ -484,12 +510,19 @@ namespace mongo {
             return true;
         }
 
-        bool clone( string& errmsg , BSONObjBuilder& result ) {
+        /**
+         * @param bulk send the documents back to back in one BinData, compressed if that makes it
+         *             smaller, rather than as an array.  recipients that know how ask for this.
+         */
+        bool clone( string& errmsg , BSONObjBuilder& result , bool bulk ) {
             if ( ! _getActive() ) {
                 errmsg = "not active";
                 return false;
             }
 
+            if ( bulk )
+                return _cloneBulk( result );
+
             readlock l( _ns );
             Client::Context ctx( _ns );
 
@@ -517,6 +550,14 @@ namespace mongo {
             return true;
         }
 
+        /** totals of what clone() has sent, for the changelog */
+        void appendCloneStats( MoveTimingHelper& timing ) {
+            scoped_lock l(_m);
+            timing.appendNumber( "clonedDocs" , _clonedDocs );
+            timing.appendNumber( "clonedBytes" , _clonedBytes );
+            timing.appendNumber( "sentBytes" , _sentBytes );
+        }
+
         void aboutToDelete( const Database* db , const DiskLoc& dl ) {
             dbMutex.assertWriteLocked();
 
@@ -555,9 +596,56 @@ namespace mongo {
         list<BSONObj> _deleted; // objects deleted during clone that should be deleted later
         long long _memoryUsed; // bytes in _reload + _deleted
 
+        // what clone() has sent so far, under _m
+        long long _clonedDocs;
+        long long _clonedBytes;
+        long long _sentBytes; // after compression
+
         bool _getActive() const { scoped_lock l(_m); return _active; }
         void _setActive( bool b ) { scoped_lock l(_m); _active = b; }
 
+        /**
+         * { data : <BinData>, compressed : <bool>, n : <number of documents>, size : <bytes before compression> }
+         * compression is done after the read lock is released.
+         */
+        bool _cloneBulk( BSONObjBuilder& result ) {
+            BufBuilder buf;
+            int n = 0;
+            {
+                readlock l( _ns );
+                Client::Context ctx( _ns );
+
+                set<DiskLoc>::iterator i = _cloneLocs.begin();
+                for ( ; i!=_cloneLocs.end(); ++i ) {
+                    BSONObj o = i->obj();
+                    if ( n && buf.len() + o.objsize() + 1024 > BSONObjMaxUserSize )
+                        break;
+                    buf.appendBuf( o.objdata() , o.objsize() );
+                    n++;
+                }
+                _cloneLocs.erase( _cloneLocs.begin() , i );
+            }
+
+            string compressed;
+            if ( buf.len() )
+                compress( buf.buf() , buf.len() , &compressed );
+
+            bool useCompressed = compressed.size() < (size_t) buf.len();
+            if ( useCompressed )
+                result.appendBinData( "data" , (int) compressed.size() , BinDataGeneral , compressed.data() );
+            else
+                result.appendBinData( "data" , buf.len() , BinDataGeneral , buf.buf() );
+            result.appendBool( "compressed" , useCompressed );
+            result.append( "n" , n );
+            result.append( "size" , buf.len() );
+
+            scoped_lock l(_m);
+            _clonedDocs += n;
+            _clonedBytes += buf.len();
+            _sentBytes += useCompressed ? compressed.size() : buf.len();
+            return true;
+        }
+
     } migrateFromStatus;
 
     struct MigrateStatusHolder {
@@ -592,7 +680,7 @@ namespace mongo {
         InitialCloneCommand() : ChunkCommandHelper( "_migrateClone" ) {}
 
         bool run(const string& , BSONObj& cmdObj, string& errmsg, BSONObjBuilder& result, bool) {
-            return migrateFromStatus.clone( errmsg, result );
+            return migrateFromStatus.clone( errmsg, result , cmdObj["bulk"].trueValue() );
         }
     } initialCloneCommand;
 
@@ -844,6 +932,7 @@ namespace mongo {
                 killCurrentOp.checkForInterrupt();
             }
             timing.done(4);
+            migrateFromStatus.appendCloneStats( timing );
 
             // 5.
             {
@@ -1109,6 +1198,48 @@ namespace mongo {
        commend to "commit"
     */
 
+    /**
+     * runs one _migrateClone on its own thread, so the donor is reading and sending the next batch
+     * while we insert the last one.  conn must not be used by anyone else until get() returns.
+     */
+    class MigrateCloneFetch : boost::noncopyable {
+    public:
+        MigrateCloneFetch( DBClientBase* conn )
+            : _conn( conn ) , _ok( false ) , _joined( false ) , _thread( boost::bind( &MigrateCloneFetch::run , this ) ) {
+        }
+
+        ~MigrateCloneFetch() {
+            if ( ! _joined )
+                _thread.join();
+        }
+
+        /** waits for the reply */
+        bool get( BSONObj& res ) {
+            _thread.join();
+            _joined = true;
+            res = _res;
+            return _ok;
+        }
+
+    private:
+        void run() {
+            try {
+                _ok = _conn->runCommand( "admin" , BSON( "_migrateClone" << 1 << "bulk" << true ) , _res );
+                _res = _res.getOwned();
+            }
+            catch ( std::exception& e ) {
+                _ok = false;
+                _res = BSON( "errmsg" << e.what() );
+            }
+        }
+
+        DBClientBase* _conn;
+        bool _ok;
+        BSONObj _res;
+        bool _joined;
+        boost::thread _thread; // last, so it starts after the rest is set up
+    };
+
     class MigrateStatus {
     public:
 
@@ -1123,6 +1254,7 @@ namespace mongo {
 
             numCloned = 0;
             clonedBytes = 0;
+            clonedRecvBytes = 0;
             numCatchup = 0;
             numSteady = 0;
 
@@ -1192,10 +1324,15 @@ namespace mongo {
             {
                 // 3. initial bulk clone
                 state = CLONE;
+                Timer cloneTime;
 
+                // the next batch is fetched while we insert the current one
+                auto_ptr<MigrateCloneFetch> fetch( new MigrateCloneFetch( conn.get() ) );
                 while ( true ) {
                     BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {
+                    bool ok = fetch->get( res );
+                    fetch.reset();
+                    if ( ! ok ) {
                         state = FAIL;
                         errmsg = "_migrateClone failed: ";
                         errmsg += res.toString();
@@ -1204,26 +1341,34 @@ namespace mongo {
                         return;
                     }
 
-                    BSONObj arr = res["objects"].Obj();
-                    int thisTime = 0;
+                    vector<BSONObj> objs;
+                    string raw;
+                    unpackClone( res , objs , raw );
+                    if ( objs.empty() )
+                        break;
 
-                    BSONObjIterator i( arr );
-                    while( i.more() ) {
-                        BSONObj o = i.next().Obj();
-                        {
-                            writelock lk( ns );
-                            Helpers::upsert( ns , o );
-                        }
-                        thisTime++;
-                        numCloned++;
-                        clonedBytes += o.objsize();
+                    fetch.reset( new MigrateCloneFetch( conn.get() ) );
+
+                    // take the lock for a few documents at a time so we don't hold it for a whole batch
+                    unsigned i = 0;
+                    while ( i < objs.size() ) {
+                        writelock lk( ns );
+                        Timer t;
+                        do {
+                            Helpers::upsert( ns , objs[i] );
+                            numCloned++;
+                            clonedBytes += objs[i].objsize();
+                            i++;
+                        } while ( i < objs.size() && t.millis() < 10 );
                     }
-
-                    if ( thisTime == 0 )
-                        break;
                 }
 
                 timing.done(3);
+                timing.appendNumber( "clonedDocs" , numCloned );
+                timing.appendNumber( "clonedBytes" , clonedBytes );
+                timing.appendNumber( "recvBytes" , clonedRecvBytes );
+                int secs = cloneTime.seconds();
+                timing.appendNumber( "clonedBytesPerSec" , secs ? clonedBytes / secs : clonedBytes );
             }
 
             // if running on a replicated system, we'll need to flush the docs we cloned to the secondaries
@@ -1313,6 +1458,7 @@ namespace mongo {
                 BSONObjBuilder bb( b.subobjStart( "counts" ) );
                 bb.append( "cloned" , numCloned );
                 bb.append( "clonedBytes" , clonedBytes );
+                bb.append( "clonedRecvBytes" , clonedRecvBytes );
                 bb.append( "catchup" , numCatchup );
                 bb.append( "steady" , numSteady );
                 bb.done();
@@ -1321,6 +1467,37 @@ namespace mongo {
 
         }
 
+        /**
+         * the documents of a _migrateClone reply.  they point into res, or into raw if they came
+         * compressed, so both must outlive objs.  donors that don't know about bulk send an array.
+         */
+        void unpackClone( const BSONObj& res , vector<BSONObj>& objs , string& raw ) {
+            if ( res["objects"].isABSONObj() ) {
+                BSONObjIterator i( res["objects"].Obj() );
+                while ( i.more() )
+                    objs.push_back( i.next().Obj() );
+                clonedRecvBytes += res.objsize();
+                return;
+            }
+
+            int len;
+            const char *data = res["data"].binData( len );
+            clonedRecvBytes += len;
+            if ( res["compressed"].trueValue() ) {
+                uassert( 13699 , "_migrateClone data doesn't uncompress" , uncompress( data , len , &raw ) );
+                data = raw.data();
+                len = (int) raw.size();
+            }
+
+            const char *end = data + len;
+            while ( data < end ) {
+                uassert( 13700 , "_migrateClone data is corrupt" , end - data >= 5 && *(const int *) data >= 5 && *(const int *) data <= end - data );
+                BSONObj o( data );
+                objs.push_back( o );
+                data += o.objsize();
+            }
+        }
+
         bool apply( const BSONObj& xfer , ReplTime* lastOpApplied ) {
             ReplTime dummy;
             if ( lastOpApplied == NULL ) {
@@ -1446,6 +1623,7 @@ namespace mongo {
 
         long long numCloned;
         long long clonedBytes;
+        long long clonedRecvBytes; // on the wire, before uncompressing
         long long numCatchup;
         long long numSteady;
 
@@ -202,6 +202,7 @@ int _main(int argc, char* argv[]) {
     ( "chunkSize" , po::value<int>(), "maximum amount of data per chunk" )
     ( "ipv6", "enable IPv6 support (disabled by default)" )
     ( "jsonp","allow JSONP access via http (has security implications)" )
+    ( "workerThreads" , po::value<int>() , "serve client connections from a pool of this many threads instead of one per connection (linux only)" )
     ;
 
     options.add(sharding_options);
@@ -328,6 +329,8 @@ int _main(int argc, char* argv[]) {
 
     MessageServer::Options opts;
     opts.port = cmdLine.port;
+    if ( params.count( "workerThreads" ) )
+        opts.workerThreads = params["workerThreads"].as<int>();
     opts.ipList = cmdLine.bind_ip;
     start(opts);
 
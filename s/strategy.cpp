@@ -76,4 +76,14 @@ namespace mongo {
         dbcon->insert( ns , obj );
         dbcon.done();
     }
+
+    void Strategy::insert( const Shard& shard , const char * ns , const vector<BSONObj>& v ) {
+        ShardConnection dbcon( shard , ns );
+        if ( dbcon.setVersion() ) {
+            dbcon.done();
+            throw StaleConfigException( ns , "for insert" );
+        }
+        dbcon->insert( ns , v );
+        dbcon.done();
+    }
 }
@@ -37,6 +37,7 @@ namespace mongo {
         void doQuery( Request& r , const Shard& shard );
 
         void insert( const Shard& shard , const char * ns , const BSONObj& obj );
+        void insert( const Shard& shard , const char * ns , const vector<BSONObj>& v );
 
     };
 
@@ -68,7 +68,7 @@ namespace mongo {
             BSONObj sort = query.getSort();
 
             if ( sort.isEmpty() ) {
-                cursor = new SerialServerClusteredCursor( servers , q );
+                cursor = new ParallelUnorderedClusteredCursor( servers , q );
             }
             else {
                 cursor = new ParallelSortClusteredCursor( servers , q , sort );
@@ -127,6 +127,8 @@ namespace mongo {
 
         void _insert( Request& r , DbMessage& d, ChunkManagerPtr manager ) {
 
+            vector<BSONObj> objs;
+
             while ( d.moreJSObjs() ) {
                 BSONObj o = d.nextJsObj();
                 if ( ! manager->hasShardKey( o ) ) {
@@ -149,32 +151,70 @@ namespace mongo {
                 }
 
                 // Many operations benefit from having the shard key early in the object
-                o = manager->getShardKey().moveToFront(o);
+                objs.push_back( manager->getShardKey().moveToFront(o) );
+            }
 
-                bool gotThrough = false;
-                for ( int i=0; i<10; i++ ) {
-                    try {
-                        ChunkPtr c = manager->findChunk( o );
-                        log(4) << "  server:" << c->getShard().toString() << " " << o << endl;
-                        insert( c->getShard() , r.getns() , o );
+            _insertGrouped( r , objs , manager );
+        }
 
-                        r.gotInsert();
-                        if ( r.getClientInfo()->autoSplitOk() )
-                            c->splitIfShould( o.objsize() );
-                        gotThrough = true;
-                        break;
-                    }
-                    catch ( StaleConfigException& ) {
-                        log(1) << "retrying insert because of StaleConfigException: " << o << endl;
-                        r.reset();
-                        manager = r.getChunkManager();
+        /**
+         * routes a batch of inserts by chunk and sends each shard all of its documents as a
+         * single OP_INSERT.  inserts are fire and forget, so every shard's message is written
+         * before we wait on anything and the shards apply their groups concurrently.
+         * a StaleConfigException only retries the groups that were not sent yet.
+         * split checks happen once per chunk with the total size written to it.
+         */
+        void _insertGrouped( Request& r , const vector<BSONObj>& objs , ChunkManagerPtr manager ) {
+            typedef map< Shard , vector<BSONObj> > ShardGroups;
+            typedef map< ChunkPtr , long > ChunkSizes;
+
+            vector<BSONObj> pending = objs;
+            ChunkSizes written;
+
+            for ( int i=0; ! pending.empty(); i++ ) {
+                ShardGroups groups;
+                map< Shard , ChunkSizes > sizes;
+                for ( unsigned j=0; j<pending.size(); j++ ) {
+                    ChunkPtr c = manager->findChunk( pending[j] );
+                    groups[ c->getShard() ].push_back( pending[j] );
+                    sizes[ c->getShard() ][ c ] += pending[j].objsize();
+                }
+
+                ShardGroups::iterator g = groups.begin();
+                try {
+                    for ( ; g != groups.end(); ++g ) {
+                        log(4) << "  server:" << g->first.toString() << " inserting " << g->second.size() << endl;
+                        insert( g->first , r.getns() , g->second );
+                        for ( unsigned j=0; j<g->second.size(); j++ )
+                            r.gotInsert();
+
+                        ChunkSizes& s = sizes[ g->first ];
+                        for ( ChunkSizes::iterator c = s.begin(); c != s.end(); ++c )
+                            written[ c->first ] += c->second;
                     }
-                    sleepmillis( i * 200 );
+                    pending.clear();
                 }
+                catch ( StaleConfigException& ) {
+                    if ( i >= 9 )
+                        throw;
 
-                assert( gotThrough );
+                    vector<BSONObj> unsent;
+                    for ( ; g != groups.end(); ++g )
+                        unsent.insert( unsent.end() , g->second.begin() , g->second.end() );
 
+                    log(1) << "retrying " << unsent.size() << " inserts because of StaleConfigException" << endl;
+                    r.reset();
+                    manager = r.getChunkManager();
+                    pending.swap( unsent );
+                    sleepmillis( i * 200 );
+                }
             }
+
+            if ( ! r.getClientInfo()->autoSplitOk() )
+                return;
+
+            for ( ChunkSizes::iterator c = written.begin(); c != written.end(); ++c )
+                c->first->splitIfShould( c->second );
         }
 
         void _update( Request& r , DbMessage& d, ChunkManagerPtr manager ) {
@@ -78,8 +78,6 @@ namespace mongo {
         _global->Set(v8::String::New("load"),
                      v8::FunctionTemplate::New( v8Callback< loadCallback >, v8::External::New(this))->GetFunction() );
 
-        _wrapper = Persistent< v8::Function >::New( getObjectWrapperTemplate()->GetFunction() );
-
         _global->Set(v8::String::New("gc"), newV8Function< GCV8 >()->GetFunction() );
 
 
@@ -89,7 +87,6 @@ namespace mongo {
     V8Scope::~V8Scope() {
         V8Lock l;
         Context::Scope context_scope( _context );
-        _wrapper.Dispose();
         _this.Dispose();
         for( unsigned i = 0; i < _funcs.size(); ++i )
             _funcs[ i ].Dispose();
@@ -316,15 +313,13 @@ namespace mongo {
 
     void V8Scope::setThis( const BSONObj * obj ) {
         V8_SIMPLE_HEADER
+        _this.Dispose();
         if ( ! obj ) {
             _this = Persistent< v8::Object >::New( v8::Object::New() );
             return;
         }
 
-        //_this = mongoToV8( *obj );
-        v8::Handle<v8::Value> argv[1];
-        argv[0] = v8::External::New( createWrapperHolder( obj , true , false ) );
-        _this = Persistent< v8::Object >::New( _wrapper->NewInstance( 1, argv ) );
+        _this = Persistent< v8::Object >::New( mongoToV8( *obj , false , true ) );
     }
 
     void V8Scope::rename( const char * from , const char * to ) {
@@ -87,8 +87,6 @@ namespace mongo {
         vector< Persistent<Value> > _funcs;
         v8::Persistent<v8::Object> _this;
 
-        v8::Persistent<v8::Function> _wrapper;
-
         enum ConnectState { NOT , LOCAL , EXTERNAL };
         ConnectState _connectState;
     };
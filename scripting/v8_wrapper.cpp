@@ -40,16 +40,6 @@ namespace mongo {
         return Boolean::New( false );
     }
 
-    Handle<Value> IndexedReadOnlySet( uint32_t index, Local<Value> value, const AccessorInfo& info ) {
-        cout << "cannot write to read-only array" << endl;
-        return value;
-    }
-
-    Handle<Boolean> IndexedReadOnlyDelete( uint32_t index, const AccessorInfo& info ) {
-        cout << "cannot delete from read-only array" << endl;
-        return Boolean::New( false );
-    }
-
     Local< v8::Value > newFunction( const char *code ) {
         stringstream codeSS;
         codeSS << "____MontoToV8_newFunction_temp = " << code;
@@ -66,7 +56,245 @@ namespace mongo {
         return idCons->NewInstance( 1 , argv );
     }
 
+    // --- lazy objects ---
+
+    static Local<v8::Object> mongoToV8( const BSONObj& m , bool array , bool readOnly , const BSONObj& owner );
+    static Handle<v8::Value> mongoToV8Element( const BSONElement &f , bool readOnly , const BSONObj& owner );
+
+    /**
+     * backs a v8 object made by mongoToV8() with the BSONObj it came from.  a field is converted
+     * the first time it is read and then kept in the object's overlay, so it's converted once and
+     * changes made to a sub object stick.  assignments and deletes only touch the overlay, the
+     * BSON is never modified, and an object that was only read goes back to BSON as it came.
+     *
+     * the top object keeps an owned copy, which v8 is told about so it collects often enough;
+     * sub objects point into the same buffer.
+     */
+    class BSONHolder {
+    public:
+        BSONHolder( const BSONObj& o , bool readOnly , const BSONObj& owner )
+            : _readOnly( readOnly ), _modified( false ), _external( 0 ) {
+            if ( owner.isOwned() ) {
+                _o = o;
+                _owner = owner;
+            }
+            else {
+                _o = _owner = o.getOwned();
+                _external = _o.objsize();
+                v8::V8::AdjustAmountOfExternalAllocatedMemory( _external );
+            }
+        }
+
+        ~BSONHolder() {
+            if ( _external )
+                v8::V8::AdjustAmountOfExternalAllocatedMemory( -_external );
+        }
+
+        BSONObj _o;
+        BSONObj _owner;           // holds the buffer _o is in
+        bool _readOnly;
+        bool _modified;           // a field was assigned or deleted
+        set<string> _removed;     // fields of _o that were deleted
+        int _external;            // bytes reported to v8
+    };
+
+    // field 0 stays empty, v8ToMongoElement() takes a number there for a special db type
+    enum LazyObjectFields { LazyTypeField , LazyHolderField , LazyOverlayField , LazyFieldCount };
+
+    static BSONHolder * getLazyHolder( v8::Handle<v8::Object> o ) {
+        if ( o->InternalFieldCount() != LazyFieldCount )
+            return 0;
+        Local<Value> h = o->GetInternalField( LazyHolderField );
+        if ( !h->IsExternal() )
+            return 0;
+        return (BSONHolder*)( External::Cast( *h )->Value() );
+    }
+
+    /** has no prototype, so Has() only finds what was put there, indexes included */
+    static Local<v8::Object> getLazyOverlay( v8::Handle<v8::Object> o ) {
+        return o->GetInternalField( LazyOverlayField )->ToObject();
+    }
+
+    /** @return true if o and whatever was read out of it can be used as the BSON they came from */
+    static bool lazyUnchanged( v8::Handle<v8::Object> o ) {
+        BSONHolder * holder = getLazyHolder( o );
+        if ( !holder || holder->_modified )
+            return false;
+        Local<v8::Object> overlay = getLazyOverlay( o );
+        Local<v8::Array> names = overlay->GetPropertyNames();
+        for ( unsigned i=0; i<names->Length(); i++ ) {
+            Local<Value> v = overlay->Get( names->Get( i ) );
+            // arrays, dates, ids etc. could have been changed in place
+            if ( v->IsObject() && !lazyUnchanged( v->ToObject() ) )
+                return false;
+        }
+        return true;
+    }
+
+    /** v8 hands field names like these to the indexed handlers */
+    static bool isArrayIndex( const char * name ) {
+        if ( name[0] == '0' )
+            return name[1] == 0;
+        unsigned long long n = 0;
+        const char * p = name;
+        for ( ; *p; p++ ) {
+            if ( *p < '0' || *p > '9' || p - name >= 10 )
+                return false;
+            n = n * 10 + ( *p - '0' );
+        }
+        return p != name && n < 0xffffffffULL;
+    }
+
+    static Local<v8::String> indexName( uint32_t index ) {
+        return v8::Uint32::New( index )->ToString();
+    }
+
+    static Handle<Value> lazyGet( Local<v8::String> name , const AccessorInfo& info ) {
+        BSONHolder * holder = getLazyHolder( info.Holder() );
+        Local<v8::Object> overlay = getLazyOverlay( info.Holder() );
+        if ( overlay->Has( name ) )
+            return overlay->Get( name );
+
+        const string& s = toSTLString( name );
+        if ( holder->_removed.count( s ) )
+            return Handle<Value>();
+        BSONElement e = holder->_o.getField( s );
+        if ( e.eoo() )
+            return Handle<Value>(); // not ours, try the prototype
+
+        Handle<Value> v = mongoToV8Element( e , holder->_readOnly , holder->_owner );
+        overlay->Set( name , v );
+        return v;
+    }
+
+    static Handle<Value> lazySet( Local<v8::String> name , Local<Value> value , const AccessorInfo& info ) {
+        BSONHolder * holder = getLazyHolder( info.Holder() );
+        if ( holder->_readOnly )
+            return NamedReadOnlySet( name , value , info );
+
+        getLazyOverlay( info.Holder() )->Set( name , value );
+        holder->_removed.erase( toSTLString( name ) );
+        holder->_modified = true;
+        return value;
+    }
+
+    static Handle<Integer> lazyQuery( Local<v8::String> name , const AccessorInfo& info ) {
+        BSONHolder * holder = getLazyHolder( info.Holder() );
+        if ( getLazyOverlay( info.Holder() )->Has( name ) )
+            return Integer::New( v8::None );
+        const string& s = toSTLString( name );
+        if ( !holder->_removed.count( s ) && holder->_o.hasField( s.c_str() ) )
+            return Integer::New( v8::None );
+        return Handle<Integer>();
+    }
+
+    static Handle<Boolean> lazyDelete( Local<v8::String> name , const AccessorInfo& info ) {
+        BSONHolder * holder = getLazyHolder( info.Holder() );
+        if ( holder->_readOnly )
+            return NamedReadOnlyDelete( name , info );
+
+        getLazyOverlay( info.Holder() )->Delete( name );
+        holder->_removed.insert( toSTLString( name ) );
+        holder->_modified = true;
+        return Boolean::New( true );
+    }
+
+    /** the names that are array indexes if indexes is set, the others if not */
+    static Handle<v8::Array> lazyEnumerateFields( const AccessorInfo& info , bool indexes ) {
+        BSONHolder * holder = getLazyHolder( info.Holder() );
+        Local<v8::Array> names = v8::Array::New();
+        unsigned n = 0;
+
+        // the stored fields keep their order, new ones follow
+        set<string> stored;
+        for ( BSONObjIterator i( holder->_o ); i.more(); ) {
+            const char * field = i.next().fieldName();
+            stored.insert( field );
+            if ( isArrayIndex( field ) != indexes || holder->_removed.count( field ) )
+                continue;
+            if ( indexes )
+                names->Set( n++ , v8::Uint32::New( strtoul( field , 0 , 10 ) ) );
+            else
+                names->Set( n++ , v8::String::New( field ) );
+        }
+
+        Local<v8::Array> overlay = getLazyOverlay( info.Holder() )->GetPropertyNames();
+        for ( unsigned i=0; i<overlay->Length(); i++ ) {
+            Local<Value> name = overlay->Get( i );
+            const string& s = toSTLString( name );
+            if ( isArrayIndex( s.c_str() ) != indexes || stored.count( s ) )
+                continue;
+            if ( indexes )
+                names->Set( n++ , name->ToUint32() );
+            else
+                names->Set( n++ , name->ToString() );
+        }
+        return names;
+    }
+
+    static Handle<v8::Array> lazyEnumerate( const AccessorInfo& info ) {
+        return lazyEnumerateFields( info , false );
+    }
+
+    static Handle<Value> lazyIndexedGet( uint32_t index, const AccessorInfo& info ) {
+        return lazyGet( indexName( index ) , info );
+    }
+
+    static Handle<Value> lazyIndexedSet( uint32_t index, Local<Value> value, const AccessorInfo& info ) {
+        return lazySet( indexName( index ) , value , info );
+    }
+
+    static Handle<Integer> lazyIndexedQuery( uint32_t index, const AccessorInfo& info ) {
+        return lazyQuery( indexName( index ) , info );
+    }
+
+    static Handle<Boolean> lazyIndexedDelete( uint32_t index, const AccessorInfo& info ) {
+        return lazyDelete( indexName( index ) , info );
+    }
+
+    static Handle<v8::Array> lazyIndexedEnumerate( const AccessorInfo& info ) {
+        return lazyEnumerateFields( info , true );
+    }
+
+    static void destroyBSONHolder( Persistent<Value> self, void* parameter ) {
+        delete static_cast<BSONHolder*>( parameter );
+        self.Dispose();
+        self.Clear();
+    }
+
+    /** @param owner an owned object m is part of, or empty to copy m */
+    static Local<v8::Object> newLazyObject( const BSONObj& m , bool readOnly , const BSONObj& owner ) {
+        static Persistent<v8::ObjectTemplate> lazyObjects;
+        if ( lazyObjects.IsEmpty() ) {
+            lazyObjects = Persistent<v8::ObjectTemplate>::New( v8::ObjectTemplate::New() );
+            lazyObjects->SetInternalFieldCount( LazyFieldCount );
+            lazyObjects->SetNamedPropertyHandler( lazyGet, lazySet, lazyQuery, lazyDelete, lazyEnumerate );
+            lazyObjects->SetIndexedPropertyHandler( lazyIndexedGet, lazyIndexedSet, lazyIndexedQuery,
+                                                    lazyIndexedDelete, lazyIndexedEnumerate );
+        }
+
+        BSONHolder * holder = new BSONHolder( m , readOnly , owner );
+        Local<v8::Object> o = lazyObjects->NewInstance();
+        o->SetInternalField( LazyHolderField , External::New( holder ) );
+        Local<v8::Object> overlay = v8::Object::New();
+        overlay->SetPrototype( v8::Null() );
+        o->SetInternalField( LazyOverlayField , overlay );
+
+        Persistent<v8::Object> self = Persistent<v8::Object>::New( o );
+        self.MakeWeak( holder , destroyBSONHolder );
+        return o;
+    }
+
     Local<v8::Object> mongoToV8( const BSONObj& m , bool array, bool readOnly ) {
+        return mongoToV8( m , array , readOnly , BSONObj() );
+    }
+
+    Handle<v8::Value> mongoToV8Element( const BSONElement &f , bool readOnly ) {
+        return mongoToV8Element( f , readOnly , BSONObj() );
+    }
+
+    /** @param owner an owned object m is part of, see newLazyObject() */
+    static Local<v8::Object> mongoToV8( const BSONObj& m , bool array , bool readOnly , const BSONObj& owner ) {
 
         Local<v8::Object> o;
 
@@ -80,46 +308,20 @@ namespace mongo {
             }
         }
 
-        Local< v8::ObjectTemplate > readOnlyObjects;
+        if ( o.IsEmpty() ) {
+            if ( !array ) {
+                // fields are converted when they are first read, see BSONHolder
+                return newLazyObject( m , readOnly , owner );
+            }
+            // NOTE Looks like it's impossible to add interceptors to v8 arrays, so these are
+            // converted up front and can't be read only.
+            o = v8::Array::New();
+        }
+
         // Hoping template construction is fast...
         Local< v8::ObjectTemplate > internalFieldObjects = v8::ObjectTemplate::New();
         internalFieldObjects->SetInternalFieldCount( 1 );
 
-        if ( !o.IsEmpty() ) {
-            readOnly = false;
-        }
-        else if ( array ) {
-            // NOTE Looks like it's impossible to add interceptors to v8 arrays.
-            readOnly = false;
-            o = v8::Array::New();
-        }
-        else if ( !readOnly ) {
-            o = v8::Object::New();
-        }
-        else {
-            // NOTE Our readOnly implemention relies on undocumented ObjectTemplate
-            // functionality that may be fragile, but it still seems like the best option
-            // for now -- fwiw, the v8 docs are pretty sparse.  I've determined experimentally
-            // that when property handlers are set for an object template, they will attach
-            // to objects previously created by that template.  To get this to work, though,
-            // it is necessary to initialize the template's property handlers before
-            // creating objects from the template (as I have in the following few lines
-            // of code).
-            // NOTE In my first attempt, I configured the permanent property handlers before
-            // constructiong the object and replaced the Set() calls below with ForceSet().
-            // However, it turns out that ForceSet() only bypasses handlers for named
-            // properties and not for indexed properties.
-            readOnlyObjects = v8::ObjectTemplate::New();
-            // NOTE This internal field will store type info for special db types.  For
-            // regular objects the field is unnecessary - for simplicity I'm creating just
-            // one readOnlyObjects template for objects where the field is & isn't necessary,
-            // assuming that the overhead of an internal field is slight.
-            readOnlyObjects->SetInternalFieldCount( 1 );
-            readOnlyObjects->SetNamedPropertyHandler( 0 );
-            readOnlyObjects->SetIndexedPropertyHandler( 0 );
-            o = readOnlyObjects->NewInstance();
-        }
-
         mongo::BSONObj sub;
 
         for ( BSONObjIterator i(m); i.more(); ) {
@@ -160,7 +362,7 @@ namespace mongo {
             case mongo::Array:
             case mongo::Object:
                 sub = f.embeddedObject();
-                o->Set( v8::String::New( f.fieldName() ) , mongoToV8( sub , f.type() == mongo::Array, readOnly ) );
+                o->Set( v8::String::New( f.fieldName() ) , mongoToV8( sub , f.type() == mongo::Array , false , owner ) );
                 break;
 
             case mongo::Date:
@@ -188,7 +390,7 @@ namespace mongo {
             }
 
             case mongo::BinData: {
-                Local<v8::Object> b = readOnly ? readOnlyObjects->NewInstance() : internalFieldObjects->NewInstance();
+                Local<v8::Object> b = internalFieldObjects->NewInstance();
 
                 int len;
                 const char *data = f.binData( len );
@@ -203,7 +405,7 @@ namespace mongo {
             }
 
             case mongo::Timestamp: {
-                Local<v8::Object> sub = readOnly ? readOnlyObjects->NewInstance() : internalFieldObjects->NewInstance();
+                Local<v8::Object> sub = internalFieldObjects->NewInstance();
 
                 sub->Set( v8::String::New( "t" ) , v8::Number::New( f.timestampTime() ) );
                 sub->Set( v8::String::New( "i" ) , v8::Number::New( f.timestampInc() ) );
@@ -214,7 +416,7 @@ namespace mongo {
             }
 
             case mongo::NumberLong: {
-                Local<v8::Object> sub = readOnly ? readOnlyObjects->NewInstance() : internalFieldObjects->NewInstance();
+                Local<v8::Object> sub = internalFieldObjects->NewInstance();
                 unsigned long long val = f.numberLong();
                 v8::Function* numberLong = getNamedCons( "NumberLong" );
                 if ( (long long)val == (long long)(double)(long long)(val) ) {
@@ -233,7 +435,7 @@ namespace mongo {
             }
 
             case mongo::MinKey: {
-                Local<v8::Object> sub = readOnly ? readOnlyObjects->NewInstance() : internalFieldObjects->NewInstance();
+                Local<v8::Object> sub = internalFieldObjects->NewInstance();
                 sub->Set( v8::String::New( "$MinKey" ), v8::Boolean::New( true ) );
                 sub->SetInternalField( 0, v8::Uint32::New( f.type() ) );
                 o->Set( v8::String::New( f.fieldName() ) , sub );
@@ -241,7 +443,7 @@ namespace mongo {
             }
 
             case mongo::MaxKey: {
-                Local<v8::Object> sub = readOnly ? readOnlyObjects->NewInstance() : internalFieldObjects->NewInstance();
+                Local<v8::Object> sub = internalFieldObjects->NewInstance();
                 sub->Set( v8::String::New( "$MaxKey" ), v8::Boolean::New( true ) );
                 sub->SetInternalField( 0, v8::Uint32::New( f.type() ) );
                 o->Set( v8::String::New( f.fieldName() ) , sub );
@@ -267,18 +469,17 @@ namespace mongo {
 
         }
 
-        if ( readOnly ) {
-            readOnlyObjects->SetNamedPropertyHandler( 0, NamedReadOnlySet, 0, NamedReadOnlyDelete );
-            readOnlyObjects->SetIndexedPropertyHandler( 0, IndexedReadOnlySet, 0, IndexedReadOnlyDelete );
-        }
-
         return o;
     }
 
-    Handle<v8::Value> mongoToV8Element( const BSONElement &f ) {
+    /** an object with the internal field v8ToMongoElement() reads special db types from */
+    static Local<v8::Object> newInternalFieldObject() {
         Local< v8::ObjectTemplate > internalFieldObjects = v8::ObjectTemplate::New();
         internalFieldObjects->SetInternalFieldCount( 1 );
+        return internalFieldObjects->NewInstance();
+    }
 
+    static Handle<v8::Value> mongoToV8Element( const BSONElement &f , bool readOnly , const BSONObj& owner ) {
         switch ( f.type() ) {
 
         case mongo::Code:
@@ -301,7 +502,7 @@ namespace mongo {
 
         case mongo::Array:
         case mongo::Object:
-            return mongoToV8( f.embeddedObject() , f.type() == mongo::Array );
+            return mongoToV8( f.embeddedObject() , f.type() == mongo::Array , readOnly , owner );
 
         case mongo::Date:
             return v8::Date::New( f.date() );
@@ -338,7 +539,7 @@ namespace mongo {
         };
 
         case mongo::Timestamp: {
-            Local<v8::Object> sub = internalFieldObjects->NewInstance();
+            Local<v8::Object> sub = newInternalFieldObject();
 
             sub->Set( v8::String::New( "t" ) , v8::Number::New( f.timestampTime() ) );
             sub->Set( v8::String::New( "i" ) , v8::Number::New( f.timestampInc() ) );
@@ -348,7 +549,7 @@ namespace mongo {
         }
 
         case mongo::NumberLong: {
-            Local<v8::Object> sub = internalFieldObjects->NewInstance();
+            Local<v8::Object> sub = newInternalFieldObject();
             unsigned long long val = f.numberLong();
             v8::Function* numberLong = getNamedCons( "NumberLong" );
             if ( (long long)val == (long long)(double)(long long)(val) ) {
@@ -366,14 +567,14 @@ namespace mongo {
         }
 
         case mongo::MinKey: {
-            Local<v8::Object> sub = internalFieldObjects->NewInstance();
+            Local<v8::Object> sub = newInternalFieldObject();
             sub->Set( v8::String::New( "$MinKey" ), v8::Boolean::New( true ) );
             sub->SetInternalField( 0, v8::Uint32::New( f.type() ) );
             return sub;
         }
 
         case mongo::MaxKey: {
-            Local<v8::Object> sub = internalFieldObjects->NewInstance();
+            Local<v8::Object> sub = newInternalFieldObject();
             sub->Set( v8::String::New( "$MaxKey" ), v8::Boolean::New( true ) );
             sub->SetInternalField( 0, v8::Uint32::New( f.type() ) );
             return sub;
@@ -526,11 +727,22 @@ namespace mongo {
     }
 
     BSONObj v8ToMongo( v8::Handle<v8::Object> o , int depth ) {
+        BSONHolder * holder = getLazyHolder( o );
+        if ( holder && lazyUnchanged( o ) ) {
+            // at the top _id has to come first.  a sub object's BSON lives in its parent's buffer,
+            // so it's copied unless the caller appends it right away
+            const BSONObj& stored = holder->_o;
+            if ( depth )
+                return stored;
+            if ( strcmp( stored.firstElement().fieldName() , "_id" ) == 0 || !stored.hasField( "_id" ) )
+                return stored.getOwned();
+        }
+
         BSONObjBuilder b;
 
         if ( depth == 0 ) {
             v8::Handle<v8::String> idName = v8::String::New( "_id" );
-            if ( o->HasRealNamedProperty( idName ) ) {
+            if ( o->HasRealNamedProperty( idName ) || ( holder && o->Has( idName ) ) ) {
                 v8ToMongoElement( b , idName , "_id" , o->Get( idName ) );
             }
         }
@@ -554,67 +766,6 @@ namespace mongo {
         return b.obj();
     }
 
-    // --- object wrapper ---
-
-    class WrapperHolder {
-    public:
-        WrapperHolder( const BSONObj * o , bool readOnly , bool iDelete )
-            : _o(o), _readOnly( readOnly ), _iDelete( iDelete ) {
-        }
-
-        ~WrapperHolder() {
-            if ( _o && _iDelete ) {
-                delete _o;
-            }
-            _o = 0;
-        }
-
-        v8::Handle<v8::Value> get( v8::Local<v8::String> name ) {
-            const string& s = toSTLString( name );
-            const BSONElement& e = _o->getField( s );
-            return mongoToV8Element(e);
-        }
-
-        const BSONObj * _o;
-        bool _readOnly;
-        bool _iDelete;
-    };
-
-    WrapperHolder * createWrapperHolder( const BSONObj * o , bool readOnly , bool iDelete ) {
-        return new WrapperHolder( o , readOnly , iDelete );
-    }
-
-#define WRAPPER_STRING (v8::String::New( "_wrapper" ) )
-
-    WrapperHolder * getWrapper( v8::Handle<v8::Object> o ) {
-        Handle<v8::Value> t = o->GetRealNamedProperty( WRAPPER_STRING );
-        assert( t->IsExternal() );
-        Local<External> c = External::Cast( *t );
-        WrapperHolder * w = (WrapperHolder*)(c->Value());
-        assert( w );
-        return w;
-    }
-
-
-    Handle<Value> wrapperCons(const Arguments& args) {
-        if ( ! ( args.Length() == 1 && args[0]->IsExternal() ) )
-            return v8::ThrowException( v8::String::New( "wrapperCons needs 1 External arg" ) );
-
-        args.This()->Set( WRAPPER_STRING , args[0] );
-
-        return v8::Undefined();
-    }
-
-    v8::Handle<v8::Value> wrapperGetHandler( v8::Local<v8::String> name, const v8::AccessorInfo &info) {
-        return getWrapper( info.This() )->get( name );
-    }
-
-    v8::Handle<v8::FunctionTemplate> getObjectWrapperTemplate() {
-        v8::Local<v8::FunctionTemplate> t = newV8Function< wrapperCons >();
-        t->InstanceTemplate()->SetNamedPropertyHandler( wrapperGetHandler );
-        return t;
-    }
-
     // --- random utils ----
 
     v8::Function * getNamedCons( const char * name ) {
@@ -25,19 +25,15 @@
 
 namespace mongo {
 
+    /** objects are backed by m and convert their fields as they're read, arrays are converted whole */
     v8::Local<v8::Object> mongoToV8( const mongo::BSONObj & m , bool array = 0 , bool readOnly = false );
     mongo::BSONObj v8ToMongo( v8::Handle<v8::Object> o , int depth = 0 );
 
     void v8ToMongoElement( BSONObjBuilder & b , v8::Handle<v8::String> name ,
                            const string sname , v8::Handle<v8::Value> value , int depth = 0 );
-    v8::Handle<v8::Value> mongoToV8Element( const BSONElement &f );
+    v8::Handle<v8::Value> mongoToV8Element( const BSONElement &f , bool readOnly = false );
 
     v8::Function * getNamedCons( const char * name );
     v8::Function * getObjectIdCons();
 
-    v8::Handle<v8::FunctionTemplate> getObjectWrapperTemplate();
-
-    class WrapperHolder;
-    WrapperHolder * createWrapperHolder( const BSONObj * o , bool readOnly , bool iDelete );
-
 }
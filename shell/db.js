@@ -111,6 +111,7 @@ DB.prototype.auth = function( username , pass ){
      capped: if true, this is a capped collection (where old data rolls out).
     </li>
     <li> max: maximum number of objects if capped (optional).</li>
+    <li> usePowerOf2Sizes: if true, allocate records in power of 2 size classes (optional, not for capped).</li>
     </ul>
 
    <p>Example: </p>
@@ -124,6 +125,8 @@ DB.prototype.auth = function( username , pass ){
 DB.prototype.createCollection = function(name, opt) {
     var options = opt || {};
     var cmd = { create: name, capped: options.capped, size: options.size, max: options.max };
+    if ( options.usePowerOf2Sizes != undefined )
+        cmd.usePowerOf2Sizes = options.usePowerOf2Sizes;
     var res = this._dbCommand(cmd);
     return res;
 }
@@ -487,6 +490,11 @@ DB.prototype._groupFixParms = function( parmsObj ){
 	parms.$keyf = parms.keyf;
 	delete parms.keyf;
     }
+
+    if( parms.combine ) {
+	parms.$combine = parms.combine;
+	delete parms.combine;
+    }
     
     return parms;
 }
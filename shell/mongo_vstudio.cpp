@@ -1595,6 +1595,7 @@ const StringData _jscode_raw_db =
 "capped: if true, this is a capped collection (where old data rolls out).\n" 
 "</li>\n" 
 "<li> max: maximum number of objects if capped (optional).</li>\n" 
+"<li> usePowerOf2Sizes: if true, allocate records in power of 2 size classes (optional, not for capped).</li>\n" 
 "</ul>\n" 
 "\n" 
 "<p>Example: </p>\n" 
@@ -1608,6 +1609,8 @@ const StringData _jscode_raw_db =
 "DB.prototype.createCollection = function(name, opt) {\n" 
 "var options = opt || {};\n" 
 "var cmd = { create: name, capped: options.capped, size: options.size, max: options.max };\n" 
+"if ( options.usePowerOf2Sizes != undefined )\n" 
+"cmd.usePowerOf2Sizes = options.usePowerOf2Sizes;\n" 
 "var res = this._dbCommand(cmd);\n" 
 "return res;\n" 
 "}\n" 
@@ -1972,6 +1975,11 @@ const StringData _jscode_raw_db =
 "delete parms.keyf;\n" 
 "}\n" 
 "\n" 
+"if( parms.combine ) {\n" 
+"parms.$combine = parms.combine;\n" 
+"delete parms.combine;\n" 
+"}\n" 
+"\n" 
 "return parms;\n" 
 "}\n" 
 "\n" 
@@ -77,6 +77,7 @@ public:
         else {
             //This branch should only be taken with DBDirectClient or mongos which doesn't support exhaust mode
             scoped_ptr<DBClientCursor> cursor(connBase.query( coll.c_str() , q , 0 , 0 , 0 , queryOptions ));
+            cursor->prefetch();
             while ( cursor->more() ) {
                 writer(cursor->next());
             }
@@ -0,0 +1,328 @@
+// @file compress.cpp
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "compress.h"
+#include "concurrency/thread_pool.h"
+#include "unittest.h"
+
+namespace mongo {
+
+    namespace {
+
+        const size_t FragmentSize = 1 << 16; // copies never reach back further than this
+        const int MaxHashTableBits = 14;
+        const size_t InputMargin = 15;       // don't look for matches this close to the end
+
+        /** pieces handed to each thread by the threaded compress; a multiple of FragmentSize */
+        const size_t ThreadedPieceSize = 16 * FragmentSize;
+
+        inline unsigned load32(const char *p) {
+            unsigned v;
+            memcpy(&v, p, 4);
+            return v;
+        }
+
+        inline unsigned hashBytes(const char *p, int shift) {
+            return (load32(p) * 0x1e35a7bd) >> shift;
+        }
+
+        size_t maxCompressedLength(size_t n) {
+            return 32 + n + n / 6;
+        }
+
+        char* emitVarint32(char *op, unsigned v) {
+            while( v >= 0x80 ) {
+                *op++ = (char) (v | 0x80);
+                v >>= 7;
+            }
+            *op++ = (char) v;
+            return op;
+        }
+
+        char* emitLiteral(char *op, const char *literal, size_t len) {
+            size_t n = len - 1;
+            if( n < 60 ) {
+                *op++ = (char) (n << 2);
+            }
+            else {
+                char *base = op++;
+                int count = 0;
+                while( n > 0 ) {
+                    *op++ = (char) (n & 0xff);
+                    n >>= 8;
+                    count++;
+                }
+                *base = (char) ((59 + count) << 2);
+            }
+            memcpy(op, literal, len);
+            return op + len;
+        }
+
+        char* emitCopyAtMost64(char *op, size_t offset, size_t len) {
+            if( len < 12 && offset < 2048 ) {
+                *op++ = (char) (1 + ((len - 4) << 2) + ((offset >> 8) << 5));
+                *op++ = (char) (offset & 0xff);
+            }
+            else {
+                *op++ = (char) (2 + ((len - 1) << 2));
+                *op++ = (char) (offset & 0xff);
+                *op++ = (char) ((offset >> 8) & 0xff);
+            }
+            return op;
+        }
+
+        char* emitCopy(char *op, size_t offset, size_t len) {
+            // keep the last piece at least 4 long so the 1 byte offset form can encode it
+            while( len >= 68 ) {
+                op = emitCopyAtMost64(op, offset, 64);
+                len -= 64;
+            }
+            if( len > 64 ) {
+                op = emitCopyAtMost64(op, offset, 60);
+                len -= 60;
+            }
+            return emitCopyAtMost64(op, offset, len);
+        }
+
+        size_t matchLength(const char *s1, const char *s2, const char *s2Limit) {
+            size_t matched = 0;
+            while( s2 + matched < s2Limit && s1[matched] == s2[matched] )
+                matched++;
+            return matched;
+        }
+
+        /** compress one fragment (<= FragmentSize bytes) with a fresh hash table */
+        char* compressFragment(const char *input, size_t len, char *op, unsigned short *table) {
+            int bits = 8;
+            while( bits < MaxHashTableBits && ((size_t)1 << bits) < len )
+                bits++;
+            const int shift = 32 - bits;
+            memset(table, 0, sizeof(unsigned short) << bits);
+
+            const char *ip = input;
+            const char *ipEnd = input + len;
+            const char *nextEmit = ip;
+
+            if( len >= InputMargin ) {
+                const char *ipLimit = ipEnd - InputMargin;
+                unsigned nextHash = hashBytes(++ip, shift);
+                while( 1 ) {
+                    // scan for a 4 byte match, stepping faster the longer we go without one so
+                    // incompressible data doesn't cost much
+                    unsigned skip = 32;
+                    const char *nextIp = ip;
+                    const char *candidate;
+                    do {
+                        ip = nextIp;
+                        unsigned h = nextHash;
+                        nextIp = ip + (skip++ >> 5);
+                        if( nextIp > ipLimit )
+                            goto emitRemainder;
+                        nextHash = hashBytes(nextIp, shift);
+                        candidate = input + table[h];
+                        table[h] = (unsigned short) (ip - input);
+                    } while( load32(ip) != load32(candidate) );
+
+                    op = emitLiteral(op, nextEmit, ip - nextEmit);
+
+                    do {
+                        const char *base = ip;
+                        size_t matched = 4 + matchLength(candidate + 4, ip + 4, ipEnd);
+                        ip += matched;
+                        op = emitCopy(op, base - candidate, matched);
+                        nextEmit = ip;
+                        if( ip >= ipLimit )
+                            goto emitRemainder;
+                        table[hashBytes(ip - 1, shift)] = (unsigned short) (ip - 1 - input);
+                        unsigned h = hashBytes(ip, shift);
+                        candidate = input + table[h];
+                        table[h] = (unsigned short) (ip - input);
+                    } while( load32(ip) == load32(candidate) );
+
+                    nextHash = hashBytes(++ip, shift);
+                }
+            }
+
+        emitRemainder:
+            if( nextEmit < ipEnd )
+                op = emitLiteral(op, nextEmit, ipEnd - nextEmit);
+            return op;
+        }
+
+        /** compress input into output, no length preamble */
+        void compressFragments(const char *input, size_t length, string *output) {
+            output->resize(maxCompressedLength(length));
+            char *start = &(*output)[0];
+            char *op = start;
+            unsigned short table[1 << MaxHashTableBits];
+            for( size_t ofs = 0; ofs < length; ofs += FragmentSize ) {
+                op = compressFragment(input + ofs, min(FragmentSize, length - ofs), op, table);
+            }
+            output->resize(op - start);
+        }
+
+        void compressPiece(const char *input, size_t length, string *output) {
+            compressFragments(input, length, output);
+        }
+
+        void appendPreamble(size_t length, string *output) {
+            char buf[5];
+            char *end = emitVarint32(buf, (unsigned) length);
+            output->append(buf, end - buf);
+        }
+
+    }
+
+    size_t compress(const char *input, size_t length, string *output) {
+        string body;
+        compressFragments(input, length, &body);
+        output->clear();
+        appendPreamble(length, output);
+        output->append(body);
+        return output->size();
+    }
+
+    size_t compress(const char *input, size_t length, string *output, ThreadPool& pool) {
+        if( length <= ThreadedPieceSize )
+            return compress(input, length, output);
+
+        size_t n = (length + ThreadedPieceSize - 1) / ThreadedPieceSize;
+        vector<string> pieces(n);
+        for( size_t i = 0; i < n; i++ ) {
+            size_t ofs = i * ThreadedPieceSize;
+            pool.schedule(compressPiece, input + ofs, min(ThreadedPieceSize, length - ofs), &pieces[i]);
+        }
+        pool.join();
+
+        output->clear();
+        appendPreamble(length, output);
+        for( size_t i = 0; i < n; i++ )
+            output->append(pieces[i]);
+        return output->size();
+    }
+
+    bool uncompress(const char *compressed, size_t length, string *output) {
+        const unsigned char *ip = (const unsigned char *) compressed;
+        const unsigned char *ipEnd = ip + length;
+
+        unsigned ulen = 0;
+        for( int shift = 0; ; shift += 7 ) {
+            if( ip >= ipEnd || shift > 28 )
+                return false;
+            unsigned char b = *ip++;
+            ulen |= (unsigned) (b & 0x7f) << shift;
+            if( b < 0x80 )
+                break;
+        }
+
+        output->resize(ulen);
+        if( ulen == 0 )
+            return ip == ipEnd;
+        char *opStart = &(*output)[0];
+        char *op = opStart;
+        char *opEnd = opStart + ulen;
+
+        while( ip < ipEnd ) {
+            unsigned char c = *ip++;
+            size_t len;
+            size_t offset;
+            switch( c & 3 ) {
+            case 0: {
+                len = c >> 2;
+                if( len >= 60 ) {
+                    int nbytes = (int) len - 59;
+                    if( ipEnd - ip < nbytes )
+                        return false;
+                    len = 0;
+                    for( int i = 0; i < nbytes; i++ )
+                        len |= (size_t) ip[i] << (8 * i);
+                    ip += nbytes;
+                }
+                len++;
+                if( (size_t) (ipEnd - ip) < len || (size_t) (opEnd - op) < len )
+                    return false;
+                memcpy(op, ip, len);
+                op += len;
+                ip += len;
+                continue;
+            }
+            case 1:
+                if( ip >= ipEnd )
+                    return false;
+                len = ((c >> 2) & 7) + 4;
+                offset = ((size_t) (c >> 5) << 8) | *ip++;
+                break;
+            case 2:
+                if( ipEnd - ip < 2 )
+                    return false;
+                len = (c >> 2) + 1;
+                offset = ip[0] | ((size_t) ip[1] << 8);
+                ip += 2;
+                break;
+            default:
+                if( ipEnd - ip < 4 )
+                    return false;
+                len = (c >> 2) + 1;
+                offset = ip[0] | ((size_t) ip[1] << 8) | ((size_t) ip[2] << 16) | ((size_t) ip[3] << 24);
+                ip += 4;
+                break;
+            }
+            if( offset == 0 || offset > (size_t) (op - opStart) || (size_t) (opEnd - op) < len )
+                return false;
+            // copies may overlap their own output (run length style), so go byte at a time then
+            const char *src = op - offset;
+            if( offset >= len ) {
+                memcpy(op, src, len);
+                op += len;
+            }
+            else {
+                for( size_t i = 0; i < len; i++ )
+                    *op++ = *src++;
+            }
+        }
+        return op == opEnd;
+    }
+
+    class CompressUnitTest : public UnitTest {
+    public:
+        void roundTrip(const string& in) {
+            string c, out;
+            compress(in.data(), in.size(), &c);
+            assert( uncompress(c.data(), c.size(), &out) );
+            assert( out == in );
+        }
+        void run() {
+            roundTrip("");
+            roundTrip("a");
+            roundTrip("abcdabcdabcdabcdabcdabcdabcdabcdabcdabcdabcd");
+            string s;
+            for( int i = 0; i < 20000; i++ )
+                s += (char) ('a' + (i * 7 + i / 13) % 23);
+            roundTrip(s);
+            string z(30000, 0);
+            roundTrip(z);
+            string c;
+            compress(z.data(), z.size(), &c);
+            assert( c.size() < z.size() / 10 );
+            string out;
+            assert( !uncompress(c.data(), c.size() - 1, &out) );
+        }
+    } compressUnitTest;
+
+}
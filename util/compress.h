@@ -0,0 +1,47 @@
+// @file compress.h fast block compression for the journal
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../pch.h"
+
+namespace mongo {
+
+    namespace threadpool { class ThreadPool; }
+
+    /** LZ77 style compression using the snappy stream format: a varint uncompressed length,
+        then literal and copy tags.  Input is processed in independent 64KB fragments, which is
+        what lets the threaded version below produce identical output.
+
+        Favors speed over ratio; it is meant for the journal where it sits on the commit path.
+
+        if you change the format you must bump dur::JHeader::CurrentVersion
+
+        @return compressed length
+    */
+    size_t compress(const char *input, size_t length, string *output);
+
+    /** same output as compress(), with large inputs split across the threads of pool.
+        blocks until done; pool should not be running anything else.
+    */
+    size_t compress(const char *input, size_t length, string *output, threadpool::ThreadPool& pool);
+
+    /** @return false if the input is not a valid compressed buffer */
+    bool uncompress(const char *compressed, size_t length, string *output);
+
+}
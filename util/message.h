@@ -143,6 +143,8 @@ namespace mongo {
 
         int unsafe_recv( char *buf, int max );
 
+        int getSocket() const { return sock; }
+
         void clearCounters() { _bytesIn = 0; _bytesOut = 0; }
         long long getBytesIn() const { return _bytesIn; }
         long long getBytesOut() const { return _bytesOut; }
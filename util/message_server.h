@@ -17,7 +17,7 @@
 
 /*
   abstract database server
-  async io core, worker thread system
+  thread per connection, or a worker thread pool fed by epoll
  */
 
 #pragma once
@@ -38,8 +38,9 @@ namespace mongo {
         struct Options {
             int port;                   // port to bind to
             string ipList;             // addresses to bind to
+            int workerThreads;         // > 0 to serve connections from a fixed pool of threads (linux only)
 
-            Options() : port(0), ipList("") {}
+            Options() : port(0), ipList(""), workerThreads(0) {}
         };
 
         virtual ~MessageServer() {}
@@ -47,6 +48,5 @@ namespace mongo {
         virtual void setAsTimeTracker() = 0;
     };
 
-    // TODO use a factory here to decide between port and asio variations
     MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler );
 }
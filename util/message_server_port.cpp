@@ -17,20 +17,38 @@
 
 #include "pch.h"
 
-#ifndef USE_ASIO
-
 #include "message.h"
 #include "message_server.h"
+#include "concurrency/thread_pool.h"
 
 #include "../db/cmdline.h"
 #include "../db/stats/counters.h"
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#endif
+
 namespace mongo {
 
     namespace pms {
 
         MessageHandler * handler;
 
+        /** reads and processes a single message from p.
+            @return false if the other side closed the connection
+        */
+        bool processOne( MessagingPort * p , Message& m ) {
+            m.reset();
+            p->clearCounters();
+
+            if ( ! p->recv(m) )
+                return false;
+
+            handler->process( m , p );
+            networkCounter.hit( p->getBytesIn() , p->getBytesOut() );
+            return true;
+        }
+
         void threadRun( MessagingPort * inPort) {
             TicketHolderReleaser connTicketReleaser( &connTicketHolder );
             
@@ -46,20 +64,12 @@ namespace mongo {
             try {
                 otherSide = p->farEnd.toString();
 
-                while ( 1 ) {
-                    m.reset();
-                    p->clearCounters();
-
-                    if ( ! p->recv(m) ) {
-                        if( !cmdLine.quiet )
-                            log() << "end connection " << otherSide << endl;
-                        p->shutdown();
-                        break;
-                    }
+                while ( processOne( p.get() , m ) )
+                    ;
 
-                    handler->process( m , p.get() );
-                    networkCounter.hit( p->getBytesIn() , p->getBytesOut() );
-                }
+                if( !cmdLine.quiet )
+                    log() << "end connection " << otherSide << endl;
+                p->shutdown();
             }
             catch ( const SocketException& ) {
                 log() << "unclean socket shutdown from: " << otherSide << endl;
@@ -74,6 +84,187 @@ namespace mongo {
             handler->disconnected( p.get() );
         }
 
+#if defined(__linux__)
+
+        /** serves connections from a fixed pool of worker threads instead of one thread each.
+
+            idle sockets are watched by a single epoll thread with EPOLLONESHOT.  when one becomes
+            readable, the connection is handed to the pool, which reads whatever has arrived without
+            blocking.  a partial message is kept with the connection and the socket goes back to
+            epoll; once a whole message is buffered the worker processes it and re-arms the socket.
+            as a socket is armed at most once, a connection is never handled by two workers at the
+            same time and its requests stay in order, and a client that stalls mid-message does not
+            hold a worker.
+        */
+        class PortPoller : boost::noncopyable {
+        public:
+            PortPoller( int nThreads ) : _pool( nThreads ) {
+                _epfd = epoll_create( 1024 );
+                massert( 13649 , str::stream() << "epoll_create failed: " << errnoWithDescription() , _epfd >= 0 );
+            }
+
+            /** takes ownership of p */
+            void add( MessagingPort * p ) {
+                Conn * c = new Conn( p );
+                struct epoll_event ev;
+                memset( &ev , 0 , sizeof(ev) );
+                ev.events = EPOLLIN | EPOLLONESHOT;
+                ev.data.ptr = c;
+                if ( epoll_ctl( _epfd , EPOLL_CTL_ADD , p->getSocket() , &ev ) ) {
+                    log() << "epoll_ctl add failed: " << errnoWithDescription() << ", closing connection" << endl;
+                    _close( c );
+                }
+            }
+
+            void run() {
+                setThreadName( "connPoller" );
+
+                const int MaxEvents = 256;
+                struct epoll_event events[MaxEvents];
+
+                while ( ! inShutdown() ) {
+                    int n = epoll_wait( _epfd , events , MaxEvents , 1000 );
+                    if ( n < 0 ) {
+                        if ( errno == EINTR )
+                            continue;
+                        log() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                        sleepmillis( 10 );
+                        continue;
+                    }
+
+                    for ( int i=0; i<n; i++ )
+                        _pool.schedule( &PortPoller::_handle , this , (Conn*)events[i].data.ptr );
+                }
+            }
+
+        private:
+            /** a connection and the part of its next message received so far */
+            struct Conn : boost::noncopyable {
+                Conn( MessagingPort * p ) : port( p ) , len( 0 ) , got( 0 ) , data( 0 ) { }
+                ~Conn() { free( data ); }
+                MessagingPort * port;
+                int len;       // from the message header, valid once got >= 4
+                int got;       // bytes of the current message received
+                MsgData * data;
+            };
+
+            enum ReadResult { ReadClosed , ReadMore , ReadDone };
+
+            /** reads what is available on c's socket without blocking */
+            ReadResult _read( Conn * c ) {
+                while ( 1 ) {
+                    char * buf;
+                    int want;
+                    if ( c->got < 4 ) {
+                        buf = ((char *) &c->len) + c->got;
+                        want = 4 - c->got;
+                    }
+                    else {
+                        buf = ((char *) c->data) + c->got;
+                        want = c->len - c->got;
+                    }
+
+                    int ret = ::recv( c->port->getSocket() , buf , want , MSG_DONTWAIT | MSG_NOSIGNAL );
+                    if ( ret == 0 )
+                        return ReadClosed;
+                    if ( ret < 0 ) {
+                        if ( errno == EINTR )
+                            continue;
+                        if ( errno == EAGAIN || errno == EWOULDBLOCK )
+                            return ReadMore;
+                        log(3) << "PortPoller recv() " << errnoWithDescription() << " " << c->port->farEnd.toString() << endl;
+                        return ReadClosed;
+                    }
+
+                    c->got += ret;
+                    if ( c->got < 4 )
+                        continue;
+
+                    if ( c->got == 4 && ! c->data ) {
+                        if ( c->len == -1 ) {
+                            // endian check from the client, see MessagingPort::recv
+                            unsigned foo = 0x10203040;
+                            c->port->send( (char *) &foo, 4, "endian" );
+                            c->got = 0;
+                            continue;
+                        }
+                        if ( c->len < 16 || c->len > 48000000 ) {
+                            log() << "recv(): message len " << c->len << " is invalid, closing connection" << endl;
+                            return ReadClosed;
+                        }
+                        int z = (c->len+1023)&0xfffffc00;
+                        c->data = (MsgData *) malloc( z );
+                        assert( c->data );
+                        c->data->len = c->len;
+                    }
+
+                    if ( c->got == c->len )
+                        return ReadDone;
+                }
+            }
+
+            void _handle( Conn * c ) {
+                MessagingPort * p = c->port;
+                bool ok = false;
+                try {
+                    ReadResult r = _read( c );
+                    if ( r == ReadDone ) {
+                        int len = c->len;
+                        Message m;
+                        m.setData( c->data , true );
+                        c->data = 0;
+                        c->got = 0;
+
+                        p->clearCounters();
+                        handler->process( m , p );
+                        networkCounter.hit( len , p->getBytesOut() );
+                    }
+                    ok = r != ReadClosed;
+                    if ( ! ok && !cmdLine.quiet )
+                        log() << "end connection " << p->farEnd.toString() << endl;
+                }
+                catch ( const SocketException& ) {
+                    log() << "unclean socket shutdown from: " << p->farEnd.toString() << endl;
+                }
+                catch ( const std::exception& e ) {
+                    problem() << "uncaught exception (" << e.what() << ")(" << demangleName( typeid(e) ) <<") in PortPoller, closing connection" << endl;
+                }
+                catch ( ... ) {
+                    problem() << "uncaught exception in PortPoller, closing connection" << endl;
+                }
+
+                if ( ok && _rearm( c ) )
+                    return;
+
+                epoll_ctl( _epfd , EPOLL_CTL_DEL , p->getSocket() , 0 );
+                handler->disconnected( p );
+                _close( c );
+            }
+
+            bool _rearm( Conn * c ) {
+                struct epoll_event ev;
+                memset( &ev , 0 , sizeof(ev) );
+                ev.events = EPOLLIN | EPOLLONESHOT;
+                ev.data.ptr = c;
+                if ( epoll_ctl( _epfd , EPOLL_CTL_MOD , c->port->getSocket() , &ev ) == 0 )
+                    return true;
+                log() << "epoll_ctl mod failed: " << errnoWithDescription() << ", closing connection" << endl;
+                return false;
+            }
+
+            void _close( Conn * c ) {
+                c->port->shutdown();
+                delete c->port;
+                delete c;
+                connTicketHolder.release();
+            }
+
+            int _epfd;
+            ThreadPool _pool;
+        };
+
+#endif
+
     }
 
     class PortMessageServer : public MessageServer , public Listener {
@@ -83,6 +274,15 @@ namespace mongo {
 
             uassert( 10275 ,  "multiple PortMessageServer not supported" , ! pms::handler );
             pms::handler = handler;
+
+            if ( opts.workerThreads > 0 ) {
+#if defined(__linux__)
+                log() << "serving connections from a pool of " << opts.workerThreads << " worker threads" << endl;
+                _poller.reset( new pms::PortPoller( opts.workerThreads ) );
+#else
+                warning() << "workerThreads is only supported on linux, using a thread per connection" << endl;
+#endif
+            }
         }
 
         virtual void accepted(MessagingPort * p) {
@@ -98,6 +298,13 @@ namespace mongo {
                 return;
             }
 
+#if defined(__linux__)
+            if ( _poller.get() ) {
+                _poller->add( p );
+                return;
+            }
+#endif
+
             try {
                 boost::thread thr( boost::bind( &pms::threadRun , p ) );
             }
@@ -117,9 +324,17 @@ namespace mongo {
         }
 
         void run() {
+#if defined(__linux__)
+            if ( _poller.get() )
+                boost::thread thr( boost::bind( &pms::PortPoller::run , _poller.get() ) );
+#endif
             initAndListen();
         }
 
+    private:
+#if defined(__linux__)
+        scoped_ptr<pms::PortPoller> _poller;
+#endif
     };
 
 
@@ -128,5 +343,3 @@ namespace mongo {
     }
 
 }
-
-#endif